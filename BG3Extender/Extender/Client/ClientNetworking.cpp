@@ -54,7 +54,16 @@ void ExtenderProtocol::ProcessExtenderMessage(net::MessageContext& context, net:
 
 	case net::MessageWrapper::kUserVars:
 	{
-		SyncUserVars(msg.user_vars());
+		net::MsgUserVarAcks acks;
+		SyncUserVars(*msg.mutable_user_vars(), &acks);
+		if (acks.acks_size() > 0) {
+			auto& networkMgr = gExtender->GetClient().GetNetworkManager();
+			auto ackMsg = networkMgr.GetFreeMessage();
+			if (ackMsg) {
+				ackMsg->GetMessage().mutable_user_var_acks()->Swap(&acks);
+				networkMgr.Send(ackMsg);
+			}
+		}
 		break;
 	}
 
@@ -66,6 +75,7 @@ void ExtenderProtocol::ProcessExtenderMessage(net::MessageContext& context, net:
 void NetworkManager::Reset()
 {
 	extenderSupport_ = false;
+	hostVersion_ = 0;
 }
 
 bool NetworkManager::CanSendExtenderMessages() const
@@ -118,6 +128,7 @@ void NetworkManager::OnExtenderHello(net::MsgC2SExtenderHello const& hello)
 {
 	DEBUG("Got extender support notification from host (version %d)", hello.version());
 	AllowExtenderMessages();
+	hostVersion_ = hello.version();
 
 	auto helloMsg = GetFreeMessage();
 	if (helloMsg != nullptr) {
@@ -26,12 +26,19 @@ public:
 	void OnClientConnectMessage(net::ClientConnectMessage* msg);
 	void OnExtenderHello(net::MsgC2SExtenderHello const& hello);
 
+	inline uint32_t GetHostVersion() const
+	{
+		return hostVersion_;
+	}
+
 private:
 	ExtenderProtocol* protocol_{ nullptr };
 
 	// Indicates that the client can support extender messages to the server
 	// (i.e. the server supports the message ID and won't crash)
 	bool extenderSupport_{ false };
+	// Protocol version of the host
+	uint32_t hostVersion_{ 0 };
 
 	net::Client* GetClient() const;
 };
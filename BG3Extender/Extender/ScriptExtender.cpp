@@ -7,6 +7,7 @@
 
 #include <Extender/Shared/StatLoadOrderHelper.inl>
 #include <Extender/Shared/UserVariables.inl>
+#include <Extender/Shared/UserVariableDelta.inl>
 #include <Extender/Shared/VirtualTextures.inl>
 
 #undef DEBUG_SERVER_CLIENT
@@ -528,8 +529,16 @@ void ScriptExtender::PostStartup()
 	// We need to initialize the function library here, as GlobalAllocator isn't available in Init().
 	if (Libraries.PostStartupFindLibraries()) {
 		lua::RegisterLibraries();
+
+		auto initStart = std::chrono::high_resolution_clock::now();
 		lua::InitObjectProxyPropertyMaps();
+		if (config_.EagerPropertyMapInit) {
+			lua::gStructRegistry.InitializeAll();
+		}
 		TypeInformationRepository::GetInstance().Initialize();
+		auto initEnd = std::chrono::high_resolution_clock::now();
+		auto us = std::chrono::duration_cast<std::chrono::microseconds>(initEnd - initStart).count();
+		DEBUG("Property map and type information registration took %d us (eager init: %d)", us, config_.EagerPropertyMapInit ? 1 : 0);
 
 		engineHooks_.HookAll();
 		hooks_.Startup();
@@ -541,6 +550,8 @@ void ScriptExtender::PostStartup()
 			ERR("Failed to load Lua builtin resource bundle!");
 		}
 
+		bytecodeCache_.SetEnabled(config_.EnableLuaBytecodeCache);
+
 		engineHooks_.FileReader__ctor.SetWrapper(&ScriptExtender::OnFileReaderCreate, this);
 		//engineHooks_.Kernel_FindFirstFileW.SetWrapper(&ScriptExtender::OnFindFirstFileW, this);
 		//engineHooks_.Kernel_FindNextFileW.SetWrapper(&ScriptExtender::OnFindNextFileW, this);
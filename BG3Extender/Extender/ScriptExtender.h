@@ -16,6 +16,7 @@
 #include <Lua/Debugger/LuaDebugMessages.h>
 #endif
 #include <Lua/Shared/LuaBundle.h>
+#include <Lua/Shared/BytecodeCache.h>
 #include <Lua/Shared/Proxies/LuaCppClass.h>
 #include <GameHooks/OsirisWrappers.h>
 #include <GameHooks/DataLibraries.h>
@@ -110,6 +111,11 @@ public:
 		return luaBuiltinBundle_;
 	}
 
+	inline lua::BytecodeCache& GetBytecodeCache()
+	{
+		return bytecodeCache_;
+	}
+
 	inline lua::CppPropertyMapManager& GetPropertyMapManager()
 	{
 		return propertyMapManager_;
@@ -155,6 +161,7 @@ private:
 	std::unordered_map<STDString, STDString> pathOverrides_;
 	stats::StatLoadOrderHelper statLoadOrderHelper_;
 	lua::LuaBundle luaBuiltinBundle_;
+	lua::BytecodeCache bytecodeCache_;
 	lua::CppPropertyMapManager propertyMapManager_;
 	VirtualTextureHelpers virtualTextures_;
 #if defined(ENABLE_IMGUI)
@@ -37,7 +37,16 @@ void ExtenderProtocol::ProcessExtenderMessage(net::MessageContext& context, net:
 
 	case net::MessageWrapper::kUserVars:
 	{
-		SyncUserVars(msg.user_vars());
+		SyncUserVars(*msg.mutable_user_vars(), nullptr);
+		break;
+	}
+
+	case net::MessageWrapper::kUserVarAcks:
+	{
+		auto& state = esv::ExtensionState::Get();
+		auto peerId = context.UserID.GetPeerId();
+		state.GetUserVariables().OnSyncAcks(peerId, msg.user_var_acks());
+		state.GetModVariables().OnSyncAcks(peerId, msg.user_var_acks());
 		break;
 	}
 
@@ -149,6 +158,31 @@ void NetworkManager::Send(net::ExtenderMessage * msg, UserId userId)
 	}
 }
 
+void NetworkManager::SendToPeer(net::ExtenderMessage* msg, PeerId peerId)
+{
+	auto server = GetServer();
+	if (server != nullptr) {
+		server->SendMessageSinglePeer((TPeerId)peerId, msg);
+	}
+}
+
+void NetworkManager::Multicast(net::ExtenderMessage* msg, Array<PeerId> const& peerIds)
+{
+	auto server = GetServer();
+	if (server == nullptr) return;
+
+	Array<PeerId> recipients;
+	for (auto peerId : peerIds) {
+		if (CanSendExtenderMessages(peerId)) {
+			recipients.push_back(peerId);
+		} else {
+			WARN("Not sending extender message to peer %d as it does not understand extender protocol!", peerId);
+		}
+	}
+
+	server->SendMessageMultiPeerMoveIds(recipients, msg, (TPeerId)ReservedUserId.GetPeerId());
+}
+
 void NetworkManager::Broadcast(net::ExtenderMessage * msg, UserId excludeUserId, bool excludeLocalPeer)
 {
 	auto server = GetServer();
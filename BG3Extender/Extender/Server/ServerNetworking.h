@@ -32,6 +32,9 @@ public:
 	net::GameServer* GetServer() const;
 
 	void Send(net::ExtenderMessage * msg, UserId userId);
+	void SendToPeer(net::ExtenderMessage* msg, PeerId peerId);
+	// Sends the message to the specified peers; peers that don't support the extender protocol are skipped
+	void Multicast(net::ExtenderMessage* msg, Array<PeerId> const& peerIds);
 	void Broadcast(net::ExtenderMessage * msg, UserId excludeUserId, bool excludeLocalPeer = false);
 	void BroadcastToConnectedPeers(net::ExtenderMessage* msg, UserId excludeUserId, bool excludeLocalPeer = false);
 
@@ -2,6 +2,7 @@
 #include <Extender/Version.h>
 #include <Extender/Shared/Console.h>
 #include <Extender/ScriptExtender.h>
+#include <Extender/Shared/ScriptHelpers.h>
 
 BEGIN_SE()
 
@@ -42,6 +43,9 @@ void DebugConsole::PrintHelp()
 	DEBUG("  reset server - Reset server Lua state");
 	DEBUG("  reset - Reset client and server Lua states");
 	DEBUG("  silence <on|off> - Enable/disable silent mode (log output when in input mode)");
+	DEBUG("  profile start [intervalUs] - Start the sampling Lua profiler in the current context");
+	DEBUG("  profile stop - Stop the Lua profiler");
+	DEBUG("  profile save <path> [folded|chrome] - Save collected profiler samples");
 	DEBUG("  clear - Clear the console");
 	DEBUG("  exit - Leave console mode");
 	DEBUG("  !<cmd> <arg1> ... <argN> - Trigger Lua \"ConsoleCommand\" event with arguments cmd, arg1, ..., argN");
@@ -157,6 +161,8 @@ void DebugConsole::HandleCommand(std::string const& cmd)
 	} else if (cmd == "silence off") {
 		DEBUG("Silent mode OFF");
 		silence_ = false;
+	} else if (cmd == "profile" || cmd.starts_with("profile ")) {
+		ExecProfilerCommand(cmd);
 	} else if (cmd == "clear") {
 		Clear();
 	} else if (cmd == "help") {
@@ -290,5 +296,59 @@ void DebugConsole::Create()
 	consoleThread_ = new std::thread(&DebugConsole::ConsoleThread, this);
 }
 
+void DebugConsole::ExecProfilerCommand(std::string const& cmd)
+{
+	std::vector<std::string> args;
+	std::istringstream ss(cmd);
+	std::string arg;
+	while (ss >> arg) {
+		args.push_back(arg);
+	}
+
+	if (args.size() < 2 || (args[1] != "start" && args[1] != "stop" && args[1] != "save")
+		|| (args[1] == "save" && args.size() < 3)) {
+		ERR("Usage: profile start [intervalUs] | profile stop | profile save <path> [folded|chrome]");
+		return;
+	}
+
+	auto task = [args]() {
+		auto state = gExtender->GetCurrentExtensionState();
+		if (!state) {
+			ERR("Extensions not initialized!");
+			return;
+		}
+
+		LuaVirtualPin pin(*state);
+		if (!pin) {
+			ERR("Lua state not initialized!");
+			return;
+		}
+
+		auto& profiler = pin->GetProfiler();
+		if (args[1] == "start") {
+			uint32_t interval = lua::LuaProfiler::DefaultSampleIntervalUs;
+			if (args.size() >= 3) {
+				interval = (uint32_t)std::strtoul(args[2].c_str(), nullptr, 10);
+			}
+
+			profiler.Clear();
+			if (profiler.Start(pin->GetState(), interval, lua::LuaProfiler::DefaultInstructionCount)) {
+				DEBUG("Lua profiler started.");
+			}
+		} else if (args[1] == "stop") {
+			profiler.Stop(pin->GetState());
+			DEBUG("Lua profiler stopped; %d samples collected.", (int)profiler.GetNumSamples());
+		} else {
+			auto contents = profiler.Export(args.size() >= 4 ? args[3] : "folded");
+			if (!contents) {
+				ERR("Unknown profile format: %s", args[3].c_str());
+			} else if (script::SaveExternalFile(args[2], PathRootType::UserProfile, *contents)) {
+				DEBUG("Profile saved to %s", args[2].c_str());
+			}
+		}
+	};
+
+	SubmitTaskAndWait(serverContext_, task);
+}
 
 END_SE()
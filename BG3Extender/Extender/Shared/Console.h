@@ -33,6 +33,7 @@ private:
 	void ResetLuaClient();
 	void ResetLuaServer();
 	void ExecLuaCommand(std::string const& cmd);
+	void ExecProfilerCommand(std::string const& cmd);
 	void ClearFromReset();
 };
 
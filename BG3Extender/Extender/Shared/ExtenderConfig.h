@@ -45,9 +45,16 @@ struct ExtenderConfig
 
 	bool ClearOnReset{ true };
 	bool ShowPerfWarnings{ false };
+	bool EagerPropertyMapInit{ false };
+	bool EnableLuaBytecodeCache{ true };
+	bool EnableLuaScriptPrefetch{ true };
+	// Periodically log the mods that used the most Lua time
+	bool LogModStats{ false };
 	uint32_t DebuggerPort{ 9999 };
 	uint32_t LuaDebuggerPort{ 9998 };
 	uint32_t DebugFlags{ 0 };
+	// Time budget of Lua GC work per tick; 0 uses the default Lua collector
+	uint32_t LuaGCBudgetUs{ 1000 };
 	std::wstring LogDirectory;
 	std::wstring LuaBuiltinResourceDirectory;
 	std::string CustomProfile;
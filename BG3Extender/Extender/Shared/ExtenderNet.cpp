@@ -93,6 +93,7 @@ void ExtenderProtocolBase::OnRemovedFromHost()
 
 void ExtenderProtocolBase::Reset()
 {
+	deltaReceiver_.Clear();
 }
 
 ExtenderMessage::ExtenderMessage()
@@ -2,6 +2,7 @@
 
 #include <GameDefinitions/Net.h>
 #include <Extender/Shared/ExtenderProtocol.pb.h>
+#include <Extender/Shared/UserVariableDelta.h>
 
 BEGIN_NS(net)
 
@@ -12,8 +13,12 @@ public:
 	static constexpr uint32_t MaxPayloadLength = 0xfffff;
 
 	static constexpr uint32_t VerInitial = 1;
+	// Added MessagePack encoded composite user variables (UserVar.packedval)
+	static constexpr uint32_t VerPackedUserVars = 2;
+	// Added versioned composite user variables and patches against acknowledged versions
+	static constexpr uint32_t VerUserVarDeltas = 3;
 	// Version of protocol, increment each time the protobuf changes
-	static constexpr uint32_t ProtoVersion = VerInitial;
+	static constexpr uint32_t ProtoVersion = VerUserVarDeltas;
 
 	ExtenderMessage();
 	~ExtenderMessage() override;
@@ -59,9 +64,13 @@ public:
 	void OnRemovedFromHost() override;
 	void Reset() override;
 
-	void SyncUserVars(MsgUserVars const& msg);
+	// Applies user variables received from a peer; acknowledgements for versioned values are added to acks
+	// if the caller wants to send them
+	void SyncUserVars(MsgUserVars& msg, MsgUserVarAcks* acks);
 
 protected:
+	UserVarDeltaReceiver deltaReceiver_;
+
 	virtual void ProcessExtenderMessage(net::MessageContext& context, MessageWrapper & msg) = 0;
 };
 
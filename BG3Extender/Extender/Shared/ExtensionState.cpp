@@ -290,6 +290,16 @@ namespace bg3se
 		}
 	}
 
+	void ExtensionStateBase::SetEventSubscribers(lua::EngineEvent evt, bool hasSubscribers)
+	{
+		auto flag = 1ull << (uint32_t)evt;
+		if (hasSubscribers) {
+			subscribedEvents_.fetch_or(flag, std::memory_order_relaxed);
+		} else {
+			subscribedEvents_.fetch_and(~flag, std::memory_order_relaxed);
+		}
+	}
+
 	void ExtensionStateBase::LuaReset(ExtensionStateContext nextContext, bool startup)
 	{
 		nextContext_ = nextContext;
@@ -339,6 +349,17 @@ namespace bg3se
 		return path;
 	}
 
+	STDString ExtensionStateBase::GetModScriptName(Module const& mod, STDString const& fileName)
+	{
+		STDString scriptName = mod.Info.Directory;
+		if (scriptName.length() > 37) {
+			// Strip GUID from end of dir
+			scriptName = scriptName.substr(0, scriptName.length() - 37);
+		}
+		scriptName += "/" + fileName;
+		return scriptName;
+	}
+
 	std::optional<int> ExtensionStateBase::LuaLoadExternalFile(STDString const & path)
 	{
 		std::ifstream f(path.c_str(), std::ios::in | std::ios::binary);
@@ -421,17 +442,49 @@ namespace bg3se
 		}
 
 		auto path = ResolveModScriptPath(*mod, fileName);
+		auto scriptName = GetModScriptName(*mod, fileName);
 
-		STDString scriptName = mod->Info.Directory;
-		if (scriptName.length() > 37) {
-			// Strip GUID from end of dir
-			scriptName = scriptName.substr(0, scriptName.length() - 37);
+		{
+			LuaVirtualPin lua(*this);
+			if (lua) {
+				lua->GetScriptOrigins().Register(scriptName, FixedString(mod->Info.Name));
+			}
+		}
+
+		if (scriptPrefetcher_.IsRunning()) {
+			auto prefetched = scriptPrefetcher_.Take(mod->Info.Directory, scriptName);
+			if (prefetched) {
+				return LuaLoadPrefetchedFile(path, scriptName, mod->Info.Directory, *prefetched, globalsIdx);
+			}
 		}
-		scriptName += "/" + fileName;
 
 		return LuaLoadGameFile(path, scriptName, warnOnError, globalsIdx);
 	}
 
+	std::optional<int> ExtensionStateBase::LuaLoadPrefetchedFile(STDString const& path, STDString const& scriptName,
+		STDString const& modDirectory, lua::ScriptPrefetcher::Script const& script, int globalsIdx)
+	{
+		LuaVirtualPin lua(*this);
+		if (!lua) {
+			OsiErrorS("Called when the Lua VM has not been initialized!");
+			return {};
+		}
+
+		loadedFiles_.insert(std::make_pair(scriptName, path));
+		loadedFileFullPaths_.insert(std::make_pair(scriptName, GetStaticSymbols().ToPath(path, PathRootType::Data)));
+
+		lua::BytecodeCache::Clock::duration loadTime;
+		auto result = lua->LoadPrefetchedScript(script, scriptName, globalsIdx, loadTime);
+		scriptPrefetcher_.OnScriptLoaded(modDirectory, loadTime);
+
+		if (!result) {
+			loadedFiles_.erase(scriptName);
+			loadedFileFullPaths_.erase(scriptName);
+		}
+
+		return result;
+	}
+
 	std::optional<int> ExtensionStateBase::LuaLoadBuiltinFile(STDString const & path, bool warnOnError, int globalsIdx)
 	{
 		auto file = gExtender->GetLuaBuiltinBundle().GetResource(path);
@@ -518,32 +571,68 @@ namespace bg3se
 			return;
 		}
 
-		lua::Restriction restriction(*lua, lua::State::RestrictAll);
+		std::vector<Module const*> luaMods;
 		for (auto const& mod : modManager->BaseModule.LoadOrderedModules) {
 			auto configIt = modConfigs_.find(mod.Info.ModuleUUIDString);
 			if (configIt != modConfigs_.end()) {
 				auto const & config = configIt->second;
 				if (config.FeatureFlags.find("Lua") != config.FeatureFlags.end()) {
-					if (gExtender->GetClient().IsInClientThread()) {
-						gExtender->GetClient().UpdateClientProgress(mod.Info.Name);
-					} else {
-						gExtender->GetClient().UpdateServerProgress(mod.Info.Name);
-					}
-
-					if (context_ == ExtensionStateContext::Game) {
-						LuaLoadGameBootstrap(config, mod);
-					} else if (context_ == ExtensionStateContext::Load) {
-						LuaLoadPreinitBootstrap(config, mod);
-					} else {
-						ERR("Bootstrap request with Uninitialized extension context?");
-					}
+					luaMods.push_back(&mod);
 				}
 			}
 		}
 
+		if (gExtender->GetConfig().EnableLuaScriptPrefetch) {
+			LuaPrefetchScripts(luaMods);
+		}
+
+		lua::Restriction restriction(*lua, lua::State::RestrictAll);
+		for (auto mod : luaMods) {
+			auto const& config = modConfigs_.find(mod->Info.ModuleUUIDString)->second;
+			if (gExtender->GetClient().IsInClientThread()) {
+				gExtender->GetClient().UpdateClientProgress(mod->Info.Name);
+			} else {
+				gExtender->GetClient().UpdateServerProgress(mod->Info.Name);
+			}
+
+			if (context_ == ExtensionStateContext::Game) {
+				LuaLoadGameBootstrap(config, *mod);
+			} else if (context_ == ExtensionStateContext::Load) {
+				LuaLoadPreinitBootstrap(config, *mod);
+			} else {
+				ERR("Bootstrap request with Uninitialized extension context?");
+			}
+		}
+
+		scriptPrefetcher_.Finish();
 		lua->FinishStartup();
 	}
 
+	void ExtensionStateBase::LuaPrefetchScripts(std::vector<Module const*> const& mods)
+	{
+		STDString bootstrapFileName;
+		if (context_ == ExtensionStateContext::Game) {
+			bootstrapFileName = GetBootstrapFileName();
+		} else if (context_ == ExtensionStateContext::Load) {
+			bootstrapFileName = "BootstrapModule.lua";
+		} else {
+			return;
+		}
+
+		std::vector<lua::ScriptPrefetcher::ModRequest> requests;
+		for (auto mod : mods) {
+			requests.push_back(lua::ScriptPrefetcher::ModRequest{
+				.Directory = mod->Info.Directory,
+				.Name = FixedString(mod->Info.Name),
+				.ScriptRoot = ResolveModScriptPath(*mod, ""),
+				.ChunkPrefix = GetModScriptName(*mod, ""),
+				.BootstrapFile = bootstrapFileName
+			});
+		}
+
+		scriptPrefetcher_.Start(std::move(requests));
+	}
+
 	void ExtensionStateBase::LuaLoadGameBootstrap(ExtensionModConfig const& config, Module const& mod)
 	{
 		auto bootstrapFileName = GetBootstrapFileName();
@@ -82,6 +82,7 @@ namespace bg3se
 
 		std::optional<STDString> ResolveModScriptPath(STDString const& modNameGuid, STDString const& fileName);
 		STDString ResolveModScriptPath(Module const& mod, STDString const& fileName);
+		STDString GetModScriptName(Module const& mod, STDString const& fileName);
 
 		std::optional<int> LuaLoadExternalFile(STDString const & path);
 		std::optional<int> LuaLoadGameFile(FileReaderPin & reader, STDString const & scriptName, int globalsIdx = 0);
@@ -89,6 +90,8 @@ namespace bg3se
 			bool warnOnError = true, int globalsIdx = 0);
 		std::optional<int> LuaLoadModScript(STDString const & modNameGuid, STDString const & fileName, 
 			bool warnOnError = true, int globalsIdx = 0);
+		std::optional<int> LuaLoadPrefetchedFile(STDString const& path, STDString const& scriptName,
+			STDString const& modDirectory, lua::ScriptPrefetcher::Script const& script, int globalsIdx = 0);
 		std::optional<int> LuaLoadBuiltinFile(STDString const& fileName, bool warnOnError = true, int globalsIdx = 0);
 		std::optional<int> LuaLoadFile(STDString const& path, STDString const& scriptName, bool warnOnError = true, int globalsIdx = 0);
 
@@ -122,6 +125,15 @@ namespace bg3se
 			return luaRefs_;
 		}
 
+		// Checks whether the Lua state has any subscribers for the event.
+		// Safe to call without pinning the Lua state; hooks should check this before constructing the event.
+		inline bool HasEventSubscribers(lua::EngineEvent evt) const
+		{
+			return (subscribedEvents_.load(std::memory_order_relaxed) & (1ull << (uint32_t)evt)) != 0;
+		}
+
+		void SetEventSubscribers(lua::EngineEvent evt, bool hasSubscribers);
+
 	protected:
 		friend class LuaVirtualPin;
 		static std::unordered_set<std::string_view> sAllFeatureFlags;
@@ -132,6 +144,7 @@ namespace bg3se
 
 		std::recursive_mutex luaMutex_;
 		std::atomic<uint32_t> luaRefs_{ 0 };
+		std::atomic<uint64_t> subscribedEvents_{ 0 };
 		std::vector<PostResetCallback> luaPostResetCallbacks_;
 		bool LuaPendingDelete{ false };
 		bool LuaPendingStartup{ false };
@@ -142,6 +155,7 @@ namespace bg3se
 		// Keep track of the list of loaded files so we can pass them to the debugger
 		std::unordered_map<STDString, STDString> loadedFiles_;
 		std::unordered_map<STDString, STDString> loadedFileFullPaths_;
+		lua::ScriptPrefetcher scriptPrefetcher_;
 
 		UserVariableManager userVariables_;
 		ModVariableManager modVariables_;
@@ -152,6 +166,7 @@ namespace bg3se
 		virtual void LuaStartup();
 		void LuaLoadGameBootstrap(ExtensionModConfig const& config, Module const& mod);
 		void LuaLoadPreinitBootstrap(ExtensionModConfig const& config, Module const& mod);
+		void LuaPrefetchScripts(std::vector<Module const*> const& mods);
 	};
 
 	ExtensionStateBase* GetCurrentExtensionState();
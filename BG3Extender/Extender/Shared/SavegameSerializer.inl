@@ -43,7 +43,7 @@ void SavegameSerializer::Serialize(ObjectVisitor* visitor, uint32_t version)
 	if (version >= SavegameVerAddedTimers) {
 		auto lua = state.GetLua();
 		if (lua) {
-			lua->GetTimers().SavegameVisit(visitor);
+			lua->GetTimers().SavegameVisit(visitor, version);
 		}
 	}
 }
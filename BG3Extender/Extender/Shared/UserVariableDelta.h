@@ -0,0 +1,119 @@
+#pragma once
+
+#include <GameDefinitions/Base/Base.h>
+#include <Extender/Shared/ExtenderProtocol.pb.h>
+#include <unordered_map>
+
+BEGIN_NS(net)
+
+// Field-level patch of a MessagePack encoded composite value.
+// A patch is a sequence of operations on the keys of the root map; nested maps that changed are patched
+// recursively, everything else is replaced as a whole. Keys and values are MessagePack objects.
+enum class CompositePatchOp : uint8_t
+{
+	// <key> <value>
+	Set = 1,
+	// <key>
+	Remove = 2,
+	// <key> <u32 patch length> <patch>
+	Update = 3
+};
+
+// Makes a patch that transforms base into value; returns false if either of them is not a map
+bool MakeCompositePatch(std::string_view base, std::string_view value, std::string& patch);
+// Applies a patch made by MakeCompositePatch; returns false if the patch doesn't match the base value
+bool ApplyCompositePatch(std::string_view base, std::string_view patch, std::string& value);
+
+struct UserVarDeltaStats
+{
+	// Number of composite values sent in full and as patches
+	uint64_t FullValues{ 0 };
+	uint64_t Patches{ 0 };
+	// Number of patches rejected by peers
+	uint64_t Resyncs{ 0 };
+	// Size of the composite values sent, if all of them had been sent in full
+	uint64_t FullBytes{ 0 };
+	// Size of the composite values and patches actually sent
+	uint64_t SentBytes{ 0 };
+};
+
+// Server side of delta encoded user variable replication.
+// Each composite value sent is assigned a version number; peers acknowledge the versions they received,
+// and later values are sent to each peer as a patch against the last version it acknowledged.
+class UserVarDeltaSender
+{
+public:
+	static constexpr unsigned MaxHistory = 8;
+
+	struct ResyncRequest
+	{
+		Guid Entity;
+		FixedString Variable;
+	};
+
+	// Assigns a version to a composite value that is about to be sent and keeps it as a possible baseline
+	void OnSend(Guid const& entity, FixedString const& key, UserVar& var);
+	// Replaces composite values in the message with patches against the baseline of the peer where that's smaller
+	void EncodeForPeer(PeerId peer, MsgUserVars& msg);
+	// Processes acknowledgements of variables of the specified type; variables that must be resent
+	// in full to the peer are added to resyncs
+	void OnAcks(PeerId peer, MsgUserVarAcks const& acks, UserVarType type, Array<ResyncRequest>& resyncs);
+	// Drops the baselines of a variable that no longer exists or is no longer a composite value
+	void Remove(Guid const& entity, FixedString const& key);
+	// Drops the acknowledged versions of peers that are not in the list of connected peers
+	void RetainPeers(Array<PeerId> const& connectedPeers);
+	void Clear();
+
+	inline UserVarDeltaStats const& GetStats() const
+	{
+		return stats_;
+	}
+
+private:
+	struct SentVersion
+	{
+		uint32_t Version;
+		std::string Value;
+	};
+
+	struct VariableState
+	{
+		uint32_t Version{ 0 };
+		Vector<SentVersion> History;
+		std::unordered_map<PeerId, uint32_t> AckedVersions;
+	};
+
+	HashMap<Guid, HashMap<FixedString, VariableState>> vars_;
+	// Peers that acknowledged at least one version
+	Array<PeerId> peers_;
+	UserVarDeltaStats stats_;
+
+	VariableState* GetState(Guid const& entity, FixedString const& key);
+	void PruneHistory(VariableState& state);
+};
+
+// Client side of delta encoded user variable replication; keeps the last few composite values received
+// so patches from the server can be applied to them
+class UserVarDeltaReceiver
+{
+public:
+	static constexpr unsigned MaxHistory = 8;
+
+	// Resolves patches to full values and acknowledges the versions received; returns false if the
+	// baseline of the patch is not available and the variable must be skipped until it is resent
+	bool Receive(UserVar& var, MsgUserVarAcks& acks);
+	void Clear();
+	// Number of values kept as possible baselines, across all variables
+	std::size_t NumValues() const;
+
+private:
+	struct ReceivedVersion
+	{
+		uint32_t Version;
+		std::string Value;
+	};
+
+	std::unordered_map<std::string, Vector<ReceivedVersion>> vars_;
+};
+
+END_NS()
@@ -0,0 +1,537 @@
+#include <Extender/Shared/UserVariableDelta.h>
+#include <deque>
+
+BEGIN_NS(net)
+
+// Reads MessagePack objects from a buffer without decoding them
+class MsgPackSpanReader
+{
+public:
+	static constexpr unsigned MaxDepth = 64;
+
+	inline MsgPackSpanReader(std::string_view data)
+		: data_(data)
+	{}
+
+	inline bool AtEnd() const
+	{
+		return pos_ >= data_.size();
+	}
+
+	bool ReadU8(uint8_t& value)
+	{
+		if (pos_ >= data_.size()) return false;
+		value = (uint8_t)data_[pos_++];
+		return true;
+	}
+
+	bool ReadU32(uint32_t& value)
+	{
+		std::string_view bytes;
+		if (!ReadBytes(4, bytes)) return false;
+		memcpy(&value, bytes.data(), 4);
+		return true;
+	}
+
+	bool ReadBytes(uint64_t size, std::string_view& bytes)
+	{
+		if (size > data_.size() - pos_) return false;
+		bytes = data_.substr(pos_, (std::size_t)size);
+		pos_ += (std::size_t)size;
+		return true;
+	}
+
+	// Reads the encoded bytes of the next object
+	bool ReadObject(std::string_view& object)
+	{
+		auto start = pos_;
+		if (!Skip(0)) return false;
+		object = data_.substr(start, pos_ - start);
+		return true;
+	}
+
+	bool ReadMapHeader(uint32_t& size)
+	{
+		uint8_t type;
+		if (!ReadU8(type)) return false;
+
+		uint64_t len;
+		if ((type & 0xf0) == 0x80) {
+			size = type & 0x0f;
+		} else if (type == 0xde && ReadBE(2, len)) {
+			size = (uint32_t)len;
+		} else if (type == 0xdf && ReadBE(4, len)) {
+			size = (uint32_t)len;
+		} else {
+			return false;
+		}
+
+		return true;
+	}
+
+private:
+	std::string_view data_;
+	std::size_t pos_{ 0 };
+
+	bool ReadBE(unsigned bytes, uint64_t& value)
+	{
+		if (bytes > data_.size() - pos_) return false;
+		value = 0;
+		for (unsigned i = 0; i < bytes; i++) {
+			value = (value << 8) | (uint8_t)data_[pos_++];
+		}
+		return true;
+	}
+
+	bool SkipBytes(uint64_t size)
+	{
+		std::string_view bytes;
+		return ReadBytes(size, bytes);
+	}
+
+	// Skips a length-prefixed str/bin/ext object
+	bool SkipSized(unsigned lengthBytes, unsigned extraBytes)
+	{
+		uint64_t len;
+		return ReadBE(lengthBytes, len) && SkipBytes(len + extraBytes);
+	}
+
+	bool SkipItems(uint64_t count, unsigned depth)
+	{
+		// Each item takes at least one byte
+		if (count > data_.size() - pos_) return false;
+		for (uint64_t i = 0; i < count; i++) {
+			if (!Skip(depth + 1)) return false;
+		}
+		return true;
+	}
+
+	bool Skip(unsigned depth)
+	{
+		uint8_t type;
+		if (depth > MaxDepth || !ReadU8(type)) return false;
+
+		if (type <= 0x7f || type >= 0xe0) return true;
+		if ((type & 0xf0) == 0x80) return SkipItems((type & 0x0f) * 2, depth);
+		if ((type & 0xf0) == 0x90) return SkipItems(type & 0x0f, depth);
+		if ((type & 0xe0) == 0xa0) return SkipBytes(type & 0x1f);
+
+		uint64_t len;
+		switch (type) {
+		case 0xc0: case 0xc2: case 0xc3: return true;
+		case 0xc4: case 0xd9: return SkipSized(1, 0);
+		case 0xc5: case 0xda: return SkipSized(2, 0);
+		case 0xc6: case 0xdb: return SkipSized(4, 0);
+		case 0xc7: return SkipSized(1, 1);
+		case 0xc8: return SkipSized(2, 1);
+		case 0xc9: return SkipSized(4, 1);
+		case 0xca: return SkipBytes(4);
+		case 0xcb: return SkipBytes(8);
+		case 0xcc: case 0xd0: return SkipBytes(1);
+		case 0xcd: case 0xd1: return SkipBytes(2);
+		case 0xce: case 0xd2: return SkipBytes(4);
+		case 0xcf: case 0xd3: return SkipBytes(8);
+		case 0xd4: return SkipBytes(2);
+		case 0xd5: return SkipBytes(3);
+		case 0xd6: return SkipBytes(5);
+		case 0xd7: return SkipBytes(9);
+		case 0xd8: return SkipBytes(17);
+		case 0xdc: return ReadBE(2, len) && SkipItems(len, depth);
+		case 0xdd: return ReadBE(4, len) && SkipItems(len, depth);
+		case 0xde: return ReadBE(2, len) && SkipItems(len * 2, depth);
+		case 0xdf: return ReadBE(4, len) && SkipItems(len * 2, depth);
+		default: return false;
+		}
+	}
+};
+
+struct CompositeField
+{
+	std::string_view Key;
+	std::string_view Value;
+	bool Removed{ false };
+};
+
+static bool ReadCompositeFields(std::string_view map, std::vector<CompositeField>& fields)
+{
+	MsgPackSpanReader reader(map);
+	uint32_t size;
+	if (!reader.ReadMapHeader(size)) return false;
+
+	fields.reserve(size);
+	for (uint32_t i = 0; i < size; i++) {
+		CompositeField field;
+		if (!reader.ReadObject(field.Key) || !reader.ReadObject(field.Value)) return false;
+		fields.push_back(field);
+	}
+
+	return reader.AtEnd();
+}
+
+static void WriteMapHeader(std::string& out, uint32_t size)
+{
+	if (size <= 0x0f) {
+		out.push_back((char)(0x80 | size));
+	} else if (size <= 0xffff) {
+		out.push_back((char)0xde);
+		out.push_back((char)(size >> 8));
+		out.push_back((char)size);
+	} else {
+		out.push_back((char)0xdf);
+		for (int shift = 24; shift >= 0; shift -= 8) {
+			out.push_back((char)(size >> shift));
+		}
+	}
+}
+
+bool MakeCompositePatch(std::string_view base, std::string_view value, std::string& patch)
+{
+	std::vector<CompositeField> baseFields, valueFields;
+	if (!ReadCompositeFields(base, baseFields) || !ReadCompositeFields(value, valueFields)) return false;
+
+	std::unordered_map<std::string_view, std::size_t> baseIndices;
+	for (std::size_t i = 0; i < baseFields.size(); i++) {
+		baseIndices.insert(std::make_pair(baseFields[i].Key, i));
+	}
+
+	std::vector<bool> matched(baseFields.size(), false);
+	std::string subPatch;
+	for (auto const& field : valueFields) {
+		auto it = baseIndices.find(field.Key);
+		if (it == baseIndices.end()) {
+			patch.push_back((char)CompositePatchOp::Set);
+			patch.append(field.Key);
+			patch.append(field.Value);
+			continue;
+		}
+
+		auto const& baseField = baseFields[it->second];
+		matched[it->second] = true;
+		if (baseField.Value == field.Value) continue;
+
+		subPatch.clear();
+		if (MakeCompositePatch(baseField.Value, field.Value, subPatch)) {
+			// Same contents, different key order
+			if (subPatch.empty()) continue;
+
+			if (subPatch.size() + 4 < field.Value.size()) {
+				uint32_t len = (uint32_t)subPatch.size();
+				patch.push_back((char)CompositePatchOp::Update);
+				patch.append(field.Key);
+				patch.append(reinterpret_cast<char const*>(&len), 4);
+				patch.append(subPatch);
+				continue;
+			}
+		}
+
+		patch.push_back((char)CompositePatchOp::Set);
+		patch.append(field.Key);
+		patch.append(field.Value);
+	}
+
+	for (std::size_t i = 0; i < baseFields.size(); i++) {
+		if (!matched[i]) {
+			patch.push_back((char)CompositePatchOp::Remove);
+			patch.append(baseFields[i].Key);
+		}
+	}
+
+	return true;
+}
+
+bool ApplyCompositePatch(std::string_view base, std::string_view patch, std::string& value)
+{
+	std::vector<CompositeField> fields;
+	if (!ReadCompositeFields(base, fields)) return false;
+
+	std::unordered_map<std::string_view, std::size_t> indices;
+	for (std::size_t i = 0; i < fields.size(); i++) {
+		indices.insert(std::make_pair(fields[i].Key, i));
+	}
+
+	// Values of patched nested maps; deque doesn't move existing elements, so fields can point into them
+	std::deque<std::string> patchedValues;
+	MsgPackSpanReader reader(patch);
+	while (!reader.AtEnd()) {
+		uint8_t op;
+		std::string_view key;
+		if (!reader.ReadU8(op) || !reader.ReadObject(key)) return false;
+
+		auto it = indices.find(key);
+		switch ((CompositePatchOp)op) {
+		case CompositePatchOp::Set:
+		{
+			std::string_view fieldValue;
+			if (!reader.ReadObject(fieldValue)) return false;
+
+			if (it == indices.end()) {
+				indices.insert(std::make_pair(key, fields.size()));
+				fields.push_back(CompositeField{ key, fieldValue });
+			} else {
+				fields[it->second].Value = fieldValue;
+			}
+			break;
+		}
+
+		case CompositePatchOp::Remove:
+			if (it == indices.end()) return false;
+			fields[it->second].Removed = true;
+			indices.erase(it);
+			break;
+
+		case CompositePatchOp::Update:
+		{
+			uint32_t len;
+			std::string_view subPatch;
+			if (it == indices.end() || !reader.ReadU32(len) || !reader.ReadBytes(len, subPatch)) return false;
+
+			auto& field = fields[it->second];
+			auto& patched = patchedValues.emplace_back();
+			if (!ApplyCompositePatch(field.Value, subPatch, patched)) return false;
+			field.Value = patched;
+			break;
+		}
+
+		default:
+			return false;
+		}
+	}
+
+	uint32_t size = (uint32_t)indices.size();
+	value.clear();
+	WriteMapHeader(value, size);
+	for (auto const& field : fields) {
+		if (!field.Removed) {
+			value.append(field.Key);
+			value.append(field.Value);
+		}
+	}
+
+	return true;
+}
+
+
+UserVarDeltaSender::VariableState* UserVarDeltaSender::GetState(Guid const& entity, FixedString const& key)
+{
+	auto vars = vars_.try_get(entity);
+	if (vars) {
+		return vars->try_get(key);
+	}
+
+	return nullptr;
+}
+
+void UserVarDeltaSender::OnSend(Guid const& entity, FixedString const& key, UserVar& var)
+{
+	auto vars = vars_.try_get(entity);
+	if (!vars) {
+		vars = vars_.add_key(entity);
+	}
+
+	auto state = vars->try_get(key);
+	if (!state) {
+		state = vars->add_key(key);
+	}
+
+	state->Version++;
+	var.set_version(state->Version);
+	state->History.push_back(SentVersion{ state->Version, var.packedval() });
+	if (state->History.size() > MaxHistory) {
+		state->History.erase(state->History.begin());
+	}
+}
+
+void UserVarDeltaSender::EncodeForPeer(PeerId peer, MsgUserVars& msg)
+{
+	std::string patch;
+	for (auto& var : *msg.mutable_vars()) {
+		if (var.version() == 0 || var.val_case() != UserVar::kPackedval) continue;
+
+		auto const& value = var.packedval();
+		stats_.FullBytes += value.size();
+
+		Guid entity;
+		entity.Val[0] = var.uuid1();
+		entity.Val[1] = var.uuid2();
+		auto state = GetState(entity, FixedString(var.key()));
+
+		SentVersion const* baseline{ nullptr };
+		uint32_t ackedVersion{ 0 };
+		if (state) {
+			auto acked = state->AckedVersions.find(peer);
+			if (acked != state->AckedVersions.end()) {
+				ackedVersion = acked->second;
+				for (auto const& sent : state->History) {
+					if (sent.Version == acked->second) {
+						baseline = &sent;
+					}
+				}
+			}
+		}
+
+		patch.clear();
+		if (baseline && MakeCompositePatch(baseline->Value, value, patch) && patch.size() < value.size()) {
+			var.set_base_version(baseline->Version);
+			var.set_packedpatch(patch);
+			stats_.Patches++;
+			stats_.SentBytes += patch.size();
+		} else {
+			// Later patches are only made against this version or newer ones, so the peer can drop older values
+			var.set_base_version(ackedVersion);
+			stats_.FullValues++;
+			stats_.SentBytes += value.size();
+		}
+	}
+}
+
+void UserVarDeltaSender::OnAcks(PeerId peer, MsgUserVarAcks const& acks, UserVarType type, Array<ResyncRequest>& resyncs)
+{
+	for (auto const& ack : acks.acks()) {
+		if (ack.type() != type) continue;
+
+		Guid entity;
+		entity.Val[0] = ack.uuid1();
+		entity.Val[1] = ack.uuid2();
+		FixedString key(ack.key());
+		auto state = GetState(entity, key);
+		if (!state) continue;
+
+		if (ack.resync()) {
+			// Forget the baseline of the peer so the next value is sent in full
+			state->AckedVersions.erase(peer);
+			stats_.Resyncs++;
+			resyncs.push_back(ResyncRequest{ entity, key });
+		} else {
+			auto& acked = state->AckedVersions[peer];
+			acked = std::max(acked, ack.version());
+			PruneHistory(*state);
+		}
+	}
+
+	if (std::find(peers_.begin(), peers_.end(), peer) == peers_.end()) {
+		peers_.push_back(peer);
+	}
+}
+
+void UserVarDeltaSender::PruneHistory(VariableState& state)
+{
+	// Patches are only made against acknowledged versions, and acknowledged versions only move forward,
+	// so values older than the oldest baseline of any peer won't be needed anymore
+	auto oldestAcked = std::numeric_limits<uint32_t>::max();
+	for (auto const& acked : state.AckedVersions) {
+		oldestAcked = std::min(oldestAcked, acked.second);
+	}
+
+	while (state.History.size() > 1 && state.History.front().Version < oldestAcked) {
+		state.History.erase(state.History.begin());
+	}
+}
+
+void UserVarDeltaSender::Remove(Guid const& entity, FixedString const& key)
+{
+	auto vars = vars_.try_get(entity);
+	if (vars && vars->remove(key) && vars->empty()) {
+		vars_.remove(entity);
+	}
+}
+
+void UserVarDeltaSender::RetainPeers(Array<PeerId> const& connectedPeers)
+{
+	for (uint32_t i = 0; i < peers_.size();) {
+		auto peer = peers_[i];
+		if (std::find(connectedPeers.begin(), connectedPeers.end(), peer) != connectedPeers.end()) {
+			i++;
+			continue;
+		}
+
+		for (auto& entity : vars_) {
+			for (auto& var : entity.Value()) {
+				var.Value().AckedVersions.erase(peer);
+			}
+		}
+
+		peers_.remove_at(i);
+	}
+}
+
+void UserVarDeltaSender::Clear()
+{
+	vars_.clear();
+	peers_.clear();
+}
+
+
+bool UserVarDeltaReceiver::Receive(UserVar& var, MsgUserVarAcks& acks)
+{
+	std::string key;
+	key.reserve(17 + var.key().size());
+	key.push_back((char)var.type());
+	auto uuid1 = var.uuid1(), uuid2 = var.uuid2();
+	key.append(reinterpret_cast<char const*>(&uuid1), 8);
+	key.append(reinterpret_cast<char const*>(&uuid2), 8);
+	key.append(var.key());
+
+	if (var.version() == 0) {
+		// The variable was deleted or is no longer a composite value; its old values won't be patched again
+		vars_.erase(key);
+		return true;
+	}
+
+	auto& history = vars_[key];
+	auto ack = acks.add_acks();
+	ack->set_uuid1(var.uuid1());
+	ack->set_uuid2(var.uuid2());
+	ack->set_key(var.key());
+	ack->set_type(var.type());
+	ack->set_version(var.version());
+
+	if (var.val_case() == UserVar::kPackedpatch) {
+		auto base = std::find_if(history.begin(), history.end(), [&](ReceivedVersion const& v) {
+			return v.Version == var.base_version();
+		});
+
+		std::string value;
+		if (base == history.end() || !ApplyCompositePatch(base->Value, var.packedpatch(), value)) {
+			WARN("Couldn't apply patch to user variable '%s' (base version %d); requesting resync", var.key().c_str(), var.base_version());
+			ack->set_resync(true);
+			return false;
+		}
+
+		// The server only patches against versions we acknowledged, and acknowledged versions
+		// only move forward, so anything older than the baseline won't be needed anymore
+		history.erase(history.begin(), base);
+		var.set_packedval(std::move(value));
+	}
+
+	if (var.val_case() == UserVar::kPackedval) {
+		// Versions restart when the server reloads its variables; drop values left over from the previous session.
+		// Values older than the baseline the server acknowledged won't be patched against anymore.
+		std::erase_if(history, [&](ReceivedVersion const& v) {
+			return v.Version >= var.version() || v.Version < var.base_version();
+		});
+
+		history.push_back(ReceivedVersion{ var.version(), var.packedval() });
+		if (history.size() > MaxHistory) {
+			history.erase(history.begin());
+		}
+	}
+
+	return true;
+}
+
+void UserVarDeltaReceiver::Clear()
+{
+	vars_.clear();
+}
+
+std::size_t UserVarDeltaReceiver::NumValues() const
+{
+	std::size_t values{ 0 };
+	for (auto const& var : vars_) {
+		values += var.second.size();
+	}
+
+	return values;
+}
+
+END_NS()
@@ -2,6 +2,7 @@
 
 #include <GameDefinitions/Base/Base.h>
 #include <Extender/Shared/ExtenderNet.h>
+#include <deque>
 
 BEGIN_SE()
 
@@ -11,8 +12,11 @@ enum class UserVariableType
 	Int64 = 1,
 	Double = 2,
 	String = 3,
+	// JSON text; only loaded from savegames and peers that predate PackedComposite
 	Composite = 4,
 	Boolean = 5,
+	// MessagePack encoded Lua value
+	PackedComposite = 6,
 };
 
 struct UserVariable
@@ -45,7 +49,10 @@ enum class UserVariableFlags
 	WriteableOnServer = 1 << 6,
 	WriteableOnClient = 1 << 7,
 	SyncOnTick = 1 << 8,
-	Persistent = 1 << 9
+	Persistent = 1 << 9,
+	// Sync priority class; variables with neither flag have normal priority
+	SyncPriorityHigh = 1 << 10,
+	SyncPriorityLow = 1 << 11
 };
 
 template<> struct IsBitfield<UserVariableFlags>
@@ -53,6 +60,13 @@ template<> struct IsBitfield<UserVariableFlags>
 	static const bool value = true;
 };
 
+enum class UserVariableSyncPriority : uint8_t
+{
+	Low = 0,
+	Normal = 1,
+	High = 2
+};
+
 struct UserVariablePrototype
 {
 	UserVariableFlags Flags{ (UserVariableFlags)0 };
@@ -77,6 +91,13 @@ struct UserVariablePrototype
 		return Has(server ? UserVariableFlags::WriteableOnServer : UserVariableFlags::WriteableOnClient);
 	}
 
+	inline UserVariableSyncPriority SyncPriority() const
+	{
+		if (Has(UserVariableFlags::SyncPriorityHigh)) return UserVariableSyncPriority::High;
+		if (Has(UserVariableFlags::SyncPriorityLow)) return UserVariableSyncPriority::Low;
+		return UserVariableSyncPriority::Normal;
+	}
+
 	bool NeedsRebroadcast(bool server) const;
 };
 
@@ -84,6 +105,7 @@ class UserVariableInterface
 {
 public:
 	virtual UserVariable* Get(Guid const& entity, FixedString const& key) = 0;
+	virtual UserVariablePrototype const* GetPrototype(Guid const& entity, FixedString const& key) const = 0;
 };
 
 enum class UserVarClass
@@ -92,6 +114,114 @@ enum class UserVarClass
 	ModuleVar
 };
 
+struct UserVariableSyncStats
+{
+	// Number of variables waiting to be sent
+	uint32_t QueueDepth{ 0 };
+	uint32_t PeakQueueDepth{ 0 };
+	// Number of sync requests; requests for variables that are already queued are coalesced into the queued entry
+	uint64_t Requests{ 0 };
+	uint64_t Coalesced{ 0 };
+	// Number of queued variables sent
+	uint64_t Sent{ 0 };
+	// Number of ticks where the bandwidth budget ran out before the queue was drained
+	uint64_t BudgetLimitedTicks{ 0 };
+	// Time from the first sync request of a queued variable until it was sent
+	std::chrono::steady_clock::duration TotalLatency{ 0 };
+	std::chrono::steady_clock::duration MaxLatency{ 0 };
+};
+
+// Variables waiting to be synced.
+// Requests are kept in a FIFO per priority class and sent higher priority classes first; the head of a queue
+// that has been waiting for a while is treated as if it were in a higher class, so lower classes can't be starved.
+class UserVariableSyncQueue
+{
+public:
+	// Number of ticks a queued variable waits before being promoted to the next priority class
+	static constexpr uint64_t AgingTicks = 30;
+
+	void Enqueue(Guid const& entity, FixedString const& key, UserVariableSyncPriority priority);
+	void NextTick();
+	void Clear();
+
+	inline bool IsEmpty() const
+	{
+		return pending_.empty();
+	}
+
+	inline UserVariableSyncStats const& GetStats() const
+	{
+		return stats_;
+	}
+
+	// Sends queued variables in priority order until the budget runs out; at least one variable is sent per call,
+	// so values larger than the budget still get through.
+	// getSize(entity, key) returns the sync size of the variable, or nullopt if it no longer needs to be sent;
+	// send(entity, key) sends the variable.
+	template <class SizeFun, class SendFun>
+	void Flush(size_t budget, SizeFun getSize, SendFun send)
+	{
+		size_t sentBytes{ 0 };
+		while (auto req = Next()) {
+			auto size = getSize(req->Entity, req->Variable);
+			if (!size) {
+				Pop(false);
+				continue;
+			}
+
+			if (sentBytes > 0 && sentBytes + *size > budget) {
+				stats_.BudgetLimitedTicks++;
+				break;
+			}
+
+			send(req->Entity, req->Variable);
+			sentBytes += *size;
+			Pop(true);
+		}
+	}
+
+private:
+	static constexpr unsigned NumPriorityClasses = (unsigned)UserVariableSyncPriority::High + 1;
+
+	struct PendingSync
+	{
+		Guid Entity;
+		FixedString Variable;
+		UserVariableSyncPriority Priority;
+		// Tick when the request entered its current queue (used for aging)
+		uint64_t QueuedTick;
+	};
+
+	struct PendingVariable
+	{
+		// Priority class of the queue that holds the live request of the variable
+		UserVariableSyncPriority Priority;
+		// Time of the first sync request; later requests for the same variable don't reset it
+		std::chrono::steady_clock::time_point QueuedAt;
+	};
+
+	// Pending requests of each priority class in the order they were queued
+	std::array<std::deque<PendingSync>, NumPriorityClasses> queues_;
+	// Raising the priority of a queued variable requeues it in the higher class; the entry left in the
+	// lower class no longer matches the priority here and is skipped when it reaches the head of its queue.
+	HashMap<Guid, HashMap<FixedString, PendingVariable>> pending_;
+	// Queue of the request returned by the last Next() call
+	std::deque<PendingSync>* next_{ nullptr };
+	uint64_t tick_{ 0 };
+	UserVariableSyncStats stats_;
+
+	// Returns the live request with the highest priority after aging, or null if the queue is empty
+	PendingSync const* Next();
+	// Removes the request returned by Next()
+	void Pop(bool sent);
+	// Returns the queue whose head has the highest priority after aging, or null if all queues are empty
+	std::deque<PendingSync>* NextQueue();
+	void RemovePending(Guid const& entity, FixedString const& key);
+};
+
+// Sends variable changes to the other side.
+// Changes are queued and sent on each tick within a per-tick bandwidth budget (see UserVariableSyncQueue).
+// SyncOnWrite variables and forced flushes bypass the budget.
 class UserVariableSyncWriter
 {
 public:
@@ -99,33 +229,50 @@ public:
 		: vars_(vars), isServer_(isServer), varClass_(varClass)
 	{}
 
+	// Sends queued variables; a forced flush sends the whole queue regardless of the bandwidth budget
 	void Flush(bool force);
 	void Clear();
+	// Drops the delta encoding baselines of all variables (eg. when variables are reloaded from a savegame)
+	void ClearDeltas();
 	void Sync(Guid const& entity, FixedString const& key, UserVariablePrototype const& proto, UserVariable const* value);
+	// Queues a variable with the sync priority of its prototype
 	void DeferredSync(Guid const& entity, FixedString const& key);
+	void OnAcks(PeerId peer, net::MsgUserVarAcks const& acks);
+
+	inline UserVariableSyncStats const& GetStats() const
+	{
+		return queue_.GetStats();
+	}
+
+	inline net::UserVarDeltaStats const& GetDeltaStats() const
+	{
+		return delta_.GetStats();
+	}
 
 private:
 	// Max (approximate) size of sync message we're allowed to send
 	static constexpr size_t SyncMessageBudget = 300000;
-
-	struct SyncRequest
-	{
-		Guid Entity;
-		FixedString Variable;
-	};
+	// Approximate number of bytes of variables sent to each peer per tick; queued variables that don't fit
+	// are sent on a later tick
+	static constexpr size_t SyncBudgetPerTick = 32768;
 
 	UserVariableInterface* vars_;
-	Array<SyncRequest> deferredSyncs_;
-	Array<SyncRequest> nextTickSyncs_;
+	UserVariableSyncQueue queue_;
+	// Size of SyncOnWrite variables sent since the last tick; they count against the budget of the next tick
+	size_t immediateBytes_{ 0 };
 	net::ExtenderMessage* syncMsg_{ nullptr };
 	size_t syncMsgBudget_{ 0 };
 	bool isServer_;
 	UserVarClass varClass_;
+	net::UserVarDeltaSender delta_;
 
 	void AppendToSyncMessage(Guid const& entity, FixedString const& key, UserVariable const& value);
-	void FlushSyncQueue(Array<SyncRequest>& queue);
+	void FlushQueue(size_t budget);
 	bool MakeSyncMessage();
 	void SendSyncs();
+	void SendToClients();
+	// Converts MessagePack encoded composite values to JSON for peers that predate VerPackedUserVars
+	void DowngradePackedValues(net::MsgUserVars& msg);
 };
 
 class UserVariableManager : public UserVariableInterface
@@ -156,6 +303,7 @@ public:
 	EntityVariables* Set(Guid const& entity, FixedString const& key, UserVariablePrototype const& proto, UserVariable&& value);
 	void MarkDirty(Guid const& entity, FixedString const& key, UserVariable& value);
 	UserVariablePrototype const* GetPrototype(FixedString const& key) const;
+	UserVariablePrototype const* GetPrototype(Guid const& entity, FixedString const& key) const override;
 	void RegisterPrototype(FixedString const& key, UserVariablePrototype const& proto);
 
 	void BindCache(lua::CachedUserVariableManager* cache);
@@ -163,6 +311,12 @@ public:
 	void Flush(bool force);
 	void SavegameVisit(ObjectVisitor* visitor);
 	void NetworkSync(net::UserVar const& var);
+	void OnSyncAcks(PeerId peer, net::MsgUserVarAcks const& acks);
+
+	inline UserVariableSyncWriter const& GetSyncWriter() const
+	{
+		return sync_;
+	}
 
 private:
 	HashMap<Guid, EntityVariables> vars_;
@@ -221,7 +375,7 @@ public:
 	HashMap<Guid, ModVariableMap>& GetAll();
 	ModVariableMap* GetMod(Guid const& modUuid);
 	ModVariableMap* GetOrCreateMod(Guid const& modUuid);
-	UserVariablePrototype const* GetPrototype(Guid const& modUuid, FixedString const& key) const;
+	UserVariablePrototype const* GetPrototype(Guid const& modUuid, FixedString const& key) const override;
 	void RegisterPrototype(Guid const& modUuid, FixedString const& key, UserVariablePrototype const& proto);
 	ModVariableMap* Set(Guid const& modUuid, FixedString const& key, UserVariablePrototype const& proto, UserVariable&& value);
 	void Set(ModVariableMap& mod, FixedString const& key, UserVariablePrototype const& proto, UserVariable&& value);
@@ -233,6 +387,12 @@ public:
 	void Flush(bool force);
 	void SavegameVisit(ObjectVisitor* visitor);
 	void NetworkSync(net::UserVar const& var);
+	void OnSyncAcks(PeerId peer, net::MsgUserVarAcks const& acks);
+
+	inline UserVariableSyncWriter const& GetSyncWriter() const
+	{
+		return sync_;
+	}
 
 private:
 	HashMap<Guid, uint32_t> modIndices_;
@@ -246,6 +406,11 @@ END_SE()
 
 BEGIN_NS(lua)
 
+// Computes an order-independent 64-bit hash of a Lua value, comparing tables by contents.
+// Returns false if the value contains types that can't be stored in user variables or is nested too deeply.
+// The resulting hash is never 0.
+bool StructuralHash(lua_State* L, int index, uint64_t& hash);
+
 enum class CachedUserVariableType
 {
 	Null,
@@ -271,13 +436,20 @@ struct CachedUserVariable
 
 	CachedUserVariableType Type{ CachedUserVariableType::Null };
 	bool Dirty{ false };
+	// Structural hash of the table value last read from or written to the global store; 0 if unknown
+	uint64_t SyncedHash{ 0 };
 	std::variant<bool, int64_t, double, FixedString, RegistryEntry> Value;
 
 	void Push(lua_State* L) const;
 	bool LikelyChanged(CachedUserVariable const& o) const;
 	UserVariable ToUserVariable(lua_State* L) const;
-	STDString StringifyReference(lua_State* L) const;
+	// Converts the value for the global store; returns nothing if the value is a table that
+	// didn't change since it was last synchronized
+	std::optional<UserVariable> SyncToUserVariable(lua_State* L);
+	uint64_t HashReference(lua_State* L) const;
+	STDString PackReference(lua_State* L) const;
 	void ParseReference(lua_State* L, StringView json);
+	void UnpackReference(lua_State* L, StringView packed);
 };
 
 class CachedUserVariableManager
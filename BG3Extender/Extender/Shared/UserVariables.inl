@@ -1,17 +1,20 @@
 #include <Extender/Shared/UserVariables.h>
 #include <GameDefinitions/Components/Components.h>
 #include <Lua/Libs/Json.h>
+#include <Lua/Libs/MsgPack.h>
 
 #define USER_VAR_DBG(msg, ...)
 //#define USER_VAR_DBG(msg, ...) DEBUG(msg, __VA_ARGS__)
 
 BEGIN_NS(net)
 
-void ExtenderProtocolBase::SyncUserVars(MsgUserVars const& msg)
+void ExtenderProtocolBase::SyncUserVars(MsgUserVars& msg, MsgUserVarAcks* acks)
 {
 	USER_VAR_DBG("Received sync message from peer");
 	auto state = gExtender->GetCurrentExtensionState();
-	for (auto const& var : msg.vars()) {
+	for (auto& var : *msg.mutable_vars()) {
+		if (acks && !deltaReceiver_.Receive(var, *acks)) continue;
+
 		if (var.type() == UserVarType::MODULE_VAR) {
 			state->GetModVariables().NetworkSync(var);
 		} else {
@@ -67,6 +70,18 @@ void UserVariable::SavegameVisit(ObjectVisitor* visitor)
 			Value = value;
 			break;
 		}
+		case UserVariableType::PackedComposite:
+		{
+			STDString encoded, value;
+			visitor->VisitSTDString(GFS.strValue, encoded, STDString{});
+			if (DecodeBase64(encoded, value)) {
+				Value = std::move(value);
+			} else {
+				ERR("Packed user variable value is corrupted");
+				Type = UserVariableType::Null;
+			}
+			break;
+		}
 		}
 	} else {
 		auto type = (uint8_t)Type;
@@ -102,6 +117,13 @@ void UserVariable::SavegameVisit(ObjectVisitor* visitor)
 			visitor->VisitSTDString(GFS.strValue, value, STDString{});
 			break;
 		}
+		case UserVariableType::PackedComposite:
+		{
+			// Savegame strings can't hold arbitrary binary data
+			auto value = EncodeBase64(std::get<STDString>(Value));
+			visitor->VisitSTDString(GFS.strValue, value, STDString{});
+			break;
+		}
 		}
 	}
 }
@@ -134,6 +156,13 @@ void UserVariable::ToNetMessage(net::UserVar& var) const
 		var.set_luaval(s.c_str(), s.size());
 		break;
 	}
+
+	case UserVariableType::PackedComposite:
+	{
+		auto const& s = std::get<STDString>(Value);
+		var.set_packedval(s.data(), s.size());
+		break;
+	}
 	}
 }
 
@@ -165,6 +194,11 @@ void UserVariable::FromNetMessage(net::UserVar const& var)
 		Value = STDString(var.luaval());
 		break;
 
+	case net::UserVar::kPackedval:
+		Type = UserVariableType::PackedComposite;
+		Value = STDString(var.packedval());
+		break;
+
 	case net::UserVar::VAL_NOT_SET:
 	default:
 		Type = UserVariableType::Null;
@@ -182,7 +216,8 @@ size_t UserVariable::Budget() const
 	case UserVariableType::Int64: budget += 8; break;
 	case UserVariableType::Double: budget += 8; break;
 	case UserVariableType::String: budget += std::get<FixedString>(Value).GetLength(); break;
-	case UserVariableType::Composite: budget += std::get<STDString>(Value).size(); break;
+	case UserVariableType::Composite:
+	case UserVariableType::PackedComposite: budget += std::get<STDString>(Value).size(); break;
 	}
 
 	return budget;
@@ -211,6 +246,130 @@ bool UserVariablePrototype::NeedsRebroadcast(bool server) const
 }
 
 
+void UserVariableSyncQueue::Enqueue(Guid const& entity, FixedString const& key, UserVariableSyncPriority priority)
+{
+	stats_.Requests++;
+
+	auto vars = pending_.try_get(entity);
+	if (!vars) {
+		vars = pending_.add_key(entity);
+	}
+
+	auto queued = vars->try_get(key);
+	if (queued) {
+		// The value is only read when the variable is sent, so repeated writes only need to update the priority
+		stats_.Coalesced++;
+		if (priority <= queued->Priority) return;
+
+		// Move the request to the higher class; the old entry becomes stale
+		queued->Priority = priority;
+	} else {
+		vars->set(key, PendingVariable{
+			.Priority = priority,
+			.QueuedAt = std::chrono::steady_clock::now()
+		});
+		stats_.QueueDepth++;
+		stats_.PeakQueueDepth = std::max(stats_.PeakQueueDepth, stats_.QueueDepth);
+	}
+
+	queues_[(unsigned)priority].push_back(PendingSync{
+		.Entity = entity,
+		.Variable = key,
+		.Priority = priority,
+		.QueuedTick = tick_
+	});
+}
+
+void UserVariableSyncQueue::NextTick()
+{
+	tick_++;
+}
+
+void UserVariableSyncQueue::Clear()
+{
+	for (auto& queue : queues_) {
+		queue.clear();
+	}
+	pending_.clear();
+	next_ = nullptr;
+	stats_.QueueDepth = 0;
+}
+
+UserVariableSyncQueue::PendingSync const* UserVariableSyncQueue::Next()
+{
+	while ((next_ = NextQueue()) != nullptr) {
+		auto const& req = next_->front();
+		auto queued = pending_.try_get(req.Entity);
+		auto var = queued ? queued->try_get(req.Variable) : nullptr;
+		if (var && var->Priority == req.Priority) {
+			return &req;
+		}
+
+		// Variable was requeued in a higher class or already sent
+		next_->pop_front();
+	}
+
+	return nullptr;
+}
+
+void UserVariableSyncQueue::Pop(bool sent)
+{
+	auto req = next_->front();
+	next_->pop_front();
+	next_ = nullptr;
+
+	if (sent) {
+		auto var = pending_.try_get(req.Entity)->try_get(req.Variable);
+		auto latency = std::chrono::steady_clock::now() - var->QueuedAt;
+		stats_.Sent++;
+		stats_.TotalLatency += latency;
+		stats_.MaxLatency = std::max(stats_.MaxLatency, latency);
+	}
+
+	RemovePending(req.Entity, req.Variable);
+}
+
+std::deque<UserVariableSyncQueue::PendingSync>* UserVariableSyncQueue::NextQueue()
+{
+	// Each queue is in queueing order, so its head has waited the longest; the head is promoted
+	// by one class for each AgingTicks it has been waiting
+	std::deque<PendingSync>* next{ nullptr };
+	uint64_t nextPriority{ 0 };
+	for (auto& queue : queues_) {
+		if (queue.empty()) continue;
+
+		auto const& head = queue.front();
+		auto priority = (uint64_t)head.Priority + (tick_ - head.QueuedTick) / AgingTicks;
+		if (next == nullptr
+			|| priority > nextPriority
+			|| (priority == nextPriority && head.QueuedTick < next->front().QueuedTick)) {
+			next = &queue;
+			nextPriority = priority;
+		}
+	}
+
+	return next;
+}
+
+void UserVariableSyncQueue::RemovePending(Guid const& entity, FixedString const& key)
+{
+	auto vars = pending_.try_get(entity);
+	if (vars && vars->remove(key)) {
+		stats_.QueueDepth--;
+		if (vars->empty()) {
+			pending_.remove(entity);
+		}
+	}
+
+	if (pending_.empty()) {
+		// Only stale entries are left
+		for (auto& queue : queues_) {
+			queue.clear();
+		}
+	}
+}
+
+
 void UserVariableSyncWriter::Flush(bool force)
 {
 	if (isServer_) {
@@ -231,15 +390,13 @@ void UserVariableSyncWriter::Flush(bool force)
 		}
 	}
 
-
-	if (!deferredSyncs_.empty()) {
-		USER_VAR_DBG("Flushing deferred syncs");
-		FlushSyncQueue(deferredSyncs_);
-	}
-	
-	if (force && !nextTickSyncs_.empty()) {
-		USER_VAR_DBG("Flushing next tick syncs");
-		FlushSyncQueue(nextTickSyncs_);
+	if (force) {
+		USER_VAR_DBG("Flushing sync queue");
+		FlushQueue(std::numeric_limits<size_t>::max());
+	} else {
+		FlushQueue(SyncBudgetPerTick - std::min(immediateBytes_, SyncBudgetPerTick));
+		immediateBytes_ = 0;
+		queue_.NextTick();
 	}
 
 	SendSyncs();
@@ -248,10 +405,16 @@ void UserVariableSyncWriter::Flush(bool force)
 
 void UserVariableSyncWriter::Clear()
 {
-	deferredSyncs_.clear();
-	nextTickSyncs_.clear();
+	queue_.Clear();
+	immediateBytes_ = 0;
 	syncMsg_ = nullptr;
 	syncMsgBudget_ = 0;
+	delta_.Clear();
+}
+
+void UserVariableSyncWriter::ClearDeltas()
+{
+	delta_.Clear();
 }
 
 void UserVariableSyncWriter::Sync(Guid const& entity, FixedString const& key, UserVariablePrototype const& proto, UserVariable const* value)
@@ -261,30 +424,20 @@ void UserVariableSyncWriter::Sync(Guid const& entity, FixedString const& key, Us
 			USER_VAR_DBG("Immediate sync var %s/%s", entity.ToString().c_str(), key.GetString());
 			if (MakeSyncMessage()) {
 				AppendToSyncMessage(entity, key, *value);
+				immediateBytes_ += value->Budget() + key.GetLength();
 				SendSyncs();
 			}
-		} else if (proto.Has(UserVariableFlags::SyncOnTick)) {
-			USER_VAR_DBG("Request next tick sync for var %s/%s", entity.ToString().c_str(), key.GetString());
-			nextTickSyncs_.push_back(SyncRequest{
-				.Entity = entity,
-				.Variable = key
-			});
 		} else {
-			USER_VAR_DBG("Request deferred sync for var %s/%s", entity.ToString().c_str(), key.GetString());
-			deferredSyncs_.push_back(SyncRequest{
-				.Entity = entity,
-				.Variable = key
-			});
+			USER_VAR_DBG("Request sync for var %s/%s", entity.ToString().c_str(), key.GetString());
+			queue_.Enqueue(entity, key, proto.SyncPriority());
 		}
 	}
 }
 
 void UserVariableSyncWriter::DeferredSync(Guid const& entity, FixedString const& key)
 {
-	deferredSyncs_.push_back(SyncRequest{
-		.Entity = entity,
-		.Variable = key
-	});
+	auto proto = vars_->GetPrototype(entity, key);
+	queue_.Enqueue(entity, key, proto ? proto->SyncPriority() : UserVariableSyncPriority::Normal);
 }
 
 void UserVariableSyncWriter::AppendToSyncMessage(Guid const& entity, FixedString const& key, UserVariable const& value)
@@ -304,23 +457,36 @@ void UserVariableSyncWriter::AppendToSyncMessage(Guid const& entity, FixedString
 	var->set_uuid2(entity.Val[1]);
 	var->set_key(key.GetString());
 	value.ToNetMessage(*var);
+	if (isServer_) {
+		if (value.Type == UserVariableType::PackedComposite) {
+			delta_.OnSend(entity, key, *var);
+		} else {
+			delta_.Remove(entity, key);
+		}
+	}
+
 	syncMsgBudget_ += value.Budget() + key.GetLength();
 }
 
-void UserVariableSyncWriter::FlushSyncQueue(Array<SyncRequest>& queue)
+void UserVariableSyncWriter::FlushQueue(size_t budget)
 {
-	if (!MakeSyncMessage()) return;
+	if (queue_.IsEmpty() || !MakeSyncMessage()) return;
 
-	for (auto const& req : queue) {
-		auto value = vars_->Get(req.Entity, req.Variable);
-		if (value && value->Dirty) {
-			USER_VAR_DBG("Flush sync var %s/%s", req.Entity.ToString().c_str(), req.Variable.GetString());
-			AppendToSyncMessage(req.Entity, req.Variable, *value);
-			value->Dirty = false;
+	queue_.Flush(budget, [this](Guid const& entity, FixedString const& key) -> std::optional<size_t> {
+		auto value = vars_->Get(entity, key);
+		if (!value) {
+			delta_.Remove(entity, key);
+			return {};
 		}
-	}
 
-	queue.clear();
+		if (!value->Dirty) return {};
+		return value->Budget() + key.GetLength();
+	}, [this](Guid const& entity, FixedString const& key) {
+		USER_VAR_DBG("Flush sync var %s/%s", entity.ToString().c_str(), key.GetString());
+		auto value = vars_->Get(entity, key);
+		AppendToSyncMessage(entity, key, *value);
+		value->Dirty = false;
+	});
 }
 
 bool UserVariableSyncWriter::MakeSyncMessage()
@@ -345,10 +511,15 @@ void UserVariableSyncWriter::SendSyncs()
 	if (syncMsg_ && syncMsg_->GetMessage().user_vars().vars_size() > 0) {
 		if (isServer_) {
 			USER_VAR_DBG("Syncing user vars to client(s)");
-			gExtender->GetServer().GetNetworkManager().BroadcastToConnectedPeers(syncMsg_, ReservedUserId, false);
+			SendToClients();
 		} else {
 			USER_VAR_DBG("Syncing user vars to server");
-			gExtender->GetClient().GetNetworkManager().Send(syncMsg_);
+			auto& networkMgr = gExtender->GetClient().GetNetworkManager();
+			if (networkMgr.GetHostVersion() < net::ExtenderMessage::VerPackedUserVars) {
+				DowngradePackedValues(*syncMsg_->GetMessage().mutable_user_vars());
+			}
+
+			networkMgr.Send(syncMsg_);
 		}
 
 		syncMsg_ = nullptr;
@@ -356,6 +527,123 @@ void UserVariableSyncWriter::SendSyncs()
 	}
 }
 
+void UserVariableSyncWriter::SendToClients()
+{
+	auto& networkMgr = gExtender->GetServer().GetNetworkManager();
+	auto server = networkMgr.GetServer();
+	if (server == nullptr) return;
+
+	delta_.RetainPeers(server->ConnectedPeerIds);
+
+	auto const& vars = syncMsg_->GetMessage().user_vars();
+	auto versioned = std::any_of(vars.vars().begin(), vars.vars().end(), [](net::UserVar const& var) {
+		return var.version() != 0;
+	});
+	auto packed = std::any_of(vars.vars().begin(), vars.vars().end(), [](net::UserVar const& var) {
+		return var.val_case() == net::UserVar::kPackedval;
+	});
+
+	Array<PeerId> legacyPeers, fullPeers, deltaPeers;
+	for (auto peerId : server->ConnectedPeerIds) {
+		auto version = networkMgr.GetPeerVersion(peerId);
+		if (packed && version && *version < net::ExtenderMessage::VerPackedUserVars) {
+			legacyPeers.push_back(peerId);
+		} else if (versioned && version && *version >= net::ExtenderMessage::VerUserVarDeltas) {
+			deltaPeers.push_back(peerId);
+		} else {
+			fullPeers.push_back(peerId);
+		}
+	}
+
+	// Peers that predate packed values get a copy with composite values converted to JSON;
+	// the original message is only reused if nobody else needs it
+	if (!legacyPeers.empty()) {
+		auto reuse = fullPeers.empty() && deltaPeers.empty();
+		auto msg = reuse ? syncMsg_ : networkMgr.GetFreeMessage();
+		if (msg) {
+			auto peerVars = msg->GetMessage().mutable_user_vars();
+			if (!reuse) {
+				peerVars->CopyFrom(vars);
+			}
+
+			DowngradePackedValues(*peerVars);
+			networkMgr.Multicast(msg, legacyPeers);
+		}
+
+		if (reuse) return;
+	}
+
+	// Each peer that can apply patches gets its own copy of the message encoded against its baselines;
+	// the last one reuses the original message if no peers need the full values
+	for (uint32_t i = 0; i < deltaPeers.size(); i++) {
+		auto reuse = fullPeers.empty() && i + 1 == deltaPeers.size();
+		auto msg = reuse ? syncMsg_ : networkMgr.GetFreeMessage();
+		if (!msg) continue;
+
+		auto peerVars = msg->GetMessage().mutable_user_vars();
+		if (!reuse) {
+			peerVars->CopyFrom(vars);
+		}
+
+		delta_.EncodeForPeer(deltaPeers[i], *peerVars);
+		networkMgr.SendToPeer(msg, deltaPeers[i]);
+	}
+
+	if (!fullPeers.empty() || deltaPeers.empty()) {
+		networkMgr.Multicast(syncMsg_, fullPeers);
+	}
+}
+
+void UserVariableSyncWriter::DowngradePackedValues(net::MsgUserVars& msg)
+{
+	LuaVirtualPin lua(gExtender->GetCurrentExtensionState());
+	for (auto& var : *msg.mutable_vars()) {
+		if (var.val_case() != net::UserVar::kPackedval) continue;
+
+		std::string json;
+		if (lua) {
+			auto L = lua->GetState();
+			STDString error;
+			if (lua::msgpack::Unpack(L, var.packedval(), error)) {
+				lua::json::StringifyContext ctx;
+				ctx.Beautify = false;
+				try {
+					json = lua::json::Stringify(L, ctx, lua_absindex(L, -1));
+				} catch (std::runtime_error& e) {
+					ERR("Error stringifying user variable '%s': %s", var.key().c_str(), e.what());
+				}
+				lua_pop(L, 1);
+			} else {
+				ERR("Failed to unpack user variable '%s': %s", var.key().c_str(), error.c_str());
+			}
+		}
+
+		var.set_version(0);
+		if (!json.empty()) {
+			var.set_luaval(json.data(), json.size());
+		} else {
+			var.clear_packedval();
+		}
+	}
+}
+
+void UserVariableSyncWriter::OnAcks(PeerId peer, net::MsgUserVarAcks const& acks)
+{
+	Array<net::UserVarDeltaSender::ResyncRequest> resyncs;
+	delta_.OnAcks(peer, acks, varClass_ == UserVarClass::ModuleVar ? net::UserVarType::MODULE_VAR : net::UserVarType::ENTITY_VAR, resyncs);
+
+	for (auto const& req : resyncs) {
+		auto value = vars_->Get(req.Entity, req.Variable);
+		if (value) {
+			USER_VAR_DBG("Resync var %s/%s", req.Entity.ToString().c_str(), req.Variable.GetString());
+			value->Dirty = true;
+			DeferredSync(req.Entity, req.Variable);
+		} else {
+			delta_.Remove(req.Entity, req.Variable);
+		}
+	}
+}
+
 
 UserVariable* UserVariableManager::Get(Guid const& entity, FixedString const& key)
 {
@@ -420,7 +708,7 @@ void UserVariableManager::BindCache(lua::CachedUserVariableManager* cache)
 
 void UserVariableManager::Update()
 {
-	Flush(true);
+	Flush(false);
 }
 
 void UserVariableManager::Flush(bool force)
@@ -433,6 +721,11 @@ UserVariablePrototype const* UserVariableManager::GetPrototype(FixedString const
 	return prototypes_.try_get(key);
 }
 
+UserVariablePrototype const* UserVariableManager::GetPrototype(Guid const& entity, FixedString const& key) const
+{
+	return prototypes_.try_get(key);
+}
+
 void UserVariableManager::RegisterPrototype(FixedString const& key, UserVariablePrototype const& proto)
 {
 	prototypes_.set(key, proto);
@@ -442,6 +735,7 @@ void UserVariableManager::SavegameVisit(ObjectVisitor* visitor)
 {
 	if (visitor->IsReading()) {
 		vars_.clear();
+		sync_.ClearDeltas();
 	}
 
 	STDString nullStr;
@@ -544,6 +838,11 @@ void UserVariableManager::NetworkSync(net::UserVar const& var)
 	}
 }
 
+void UserVariableManager::OnSyncAcks(PeerId peer, net::MsgUserVarAcks const& acks)
+{
+	sync_.OnAcks(peer, acks);
+}
+
 Guid UserVariableManager::EntityToGuid(EntityHandle const& entity) const
 {
 	auto uuid = entityHelpers_.GetComponent<UuidComponent>(entity);
@@ -747,7 +1046,7 @@ void ModVariableManager::BindCache(lua::CachedModVariableManager* cache)
 
 void ModVariableManager::Update()
 {
-	Flush(true);
+	Flush(false);
 }
 
 void ModVariableManager::OnSessionLoading()
@@ -776,6 +1075,7 @@ void ModVariableManager::SavegameVisit(ObjectVisitor* visitor)
 		for (auto& mod : vars_) {
 			mod.Value().ClearVars();
 		}
+		sync_.ClearDeltas();
 	}
 
 	STDString nullStr;
@@ -856,10 +1156,107 @@ void ModVariableManager::NetworkSync(net::UserVar const& var)
 	}
 }
 
+void ModVariableManager::OnSyncAcks(PeerId peer, net::MsgUserVarAcks const& acks)
+{
+	sync_.OnAcks(peer, acks);
+}
+
 END_SE()
 
 BEGIN_NS(lua)
 
+static constexpr unsigned MaxStructuralHashDepth = 64;
+
+// splitmix64 finalizer
+static inline uint64_t MixHash(uint64_t h)
+{
+	h ^= h >> 30;
+	h *= 0xbf58476d1ce4e5b9ull;
+	h ^= h >> 27;
+	h *= 0x94d049bb133111ebull;
+	h ^= h >> 31;
+	return h;
+}
+
+static bool StructuralHash(lua_State* L, int index, uint64_t& hash, unsigned depth)
+{
+	switch (lua_type(L, index)) {
+	case LUA_TNIL:
+		hash = MixHash(1);
+		return true;
+
+	case LUA_TBOOLEAN:
+		hash = MixHash(2 + lua_toboolean(L, index));
+		return true;
+
+	case LUA_TNUMBER:
+		// Integers and floats are packed differently, so they hash differently too
+		if (lua_isinteger(L, index)) {
+			hash = MixHash((uint64_t)lua_tointeger(L, index) ^ 0x1000000000000001ull);
+		} else {
+			auto value = lua_tonumber(L, index);
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			hash = MixHash(bits ^ 0x2000000000000002ull);
+		}
+		return true;
+
+	case LUA_TSTRING:
+	{
+		std::size_t length;
+		auto str = lua_tolstring(L, index, &length);
+		uint64_t h = MixHash(length ^ 0x3000000000000003ull);
+		std::size_t i = 0;
+		for (; i + 8 <= length; i += 8) {
+			uint64_t chunk;
+			memcpy(&chunk, str + i, 8);
+			h = MixHash(h ^ chunk);
+		}
+		if (i < length) {
+			uint64_t chunk{ 0 };
+			memcpy(&chunk, str + i, length - i);
+			h = MixHash(h ^ chunk);
+		}
+		hash = h;
+		return true;
+	}
+
+	case LUA_TTABLE:
+	{
+		if (depth >= MaxStructuralHashDepth || !lua_checkstack(L, 3)) return false;
+
+		// Pairs are combined with addition, so the result doesn't depend on the traversal order
+		index = lua_absindex(L, index);
+		uint64_t sum{ 0 }, count{ 0 };
+		lua_pushnil(L);
+		while (lua_next(L, index) != 0) {
+			uint64_t keyHash, valueHash;
+			if (!StructuralHash(L, -2, keyHash, depth + 1) || !StructuralHash(L, -1, valueHash, depth + 1)) {
+				lua_pop(L, 2);
+				return false;
+			}
+
+			sum += MixHash(keyHash * 31 + valueHash);
+			count++;
+			lua_pop(L, 1);
+		}
+
+		hash = MixHash(sum ^ MixHash(count ^ 0x4000000000000004ull));
+		return true;
+	}
+
+	default:
+		return false;
+	}
+}
+
+bool StructuralHash(lua_State* L, int index, uint64_t& hash)
+{
+	if (!StructuralHash(L, index, hash, 0)) return false;
+	if (hash == 0) hash = 1;
+	return true;
+}
+
 CachedUserVariable::CachedUserVariable(lua_State* L, UserVariable const& v)
 {
 	switch (v.Type) {
@@ -887,6 +1284,10 @@ CachedUserVariable::CachedUserVariable(lua_State* L, UserVariable const& v)
 		ParseReference(L, std::get<STDString>(v.Value));
 		break;
 
+	case UserVariableType::PackedComposite:
+		UnpackReference(L, std::get<STDString>(v.Value));
+		break;
+
 	case UserVariableType::Null:
 	default:
 		Type = CachedUserVariableType::Null;
@@ -943,6 +1344,7 @@ CachedUserVariable::CachedUserVariable(CachedUserVariable&& o)
 {
 	Type = o.Type;
 	Dirty = o.Dirty;
+	SyncedHash = o.SyncedHash;
 	Value = std::move(o.Value);
 }
 
@@ -950,6 +1352,7 @@ CachedUserVariable& CachedUserVariable::operator = (CachedUserVariable&& o)
 {
 	Type = o.Type;
 	Dirty = o.Dirty;
+	SyncedHash = o.SyncedHash;
 	Value = o.Value;
 
 	return *this;
@@ -967,6 +1370,19 @@ void CachedUserVariable::ParseReference(lua_State* L, StringView json)
 	}
 }
 
+void CachedUserVariable::UnpackReference(lua_State* L, StringView packed)
+{
+	STDString error;
+	if (msgpack::Unpack(L, packed, error)) {
+		Value = RegistryEntry(L, -1);
+		lua_pop(L, 1);
+		Type = CachedUserVariableType::Reference;
+	} else {
+		ERR("Failed to unpack user variable blob: %s", error.c_str());
+		Type = CachedUserVariableType::Null;
+	}
+}
+
 void CachedUserVariable::Push(lua_State* L) const
 {
 	switch (Type) {
@@ -1035,9 +1451,9 @@ UserVariable CachedUserVariable::ToUserVariable(lua_State* L) const
 		break;
 		
 	case CachedUserVariableType::Reference:
-		var.Value = StringifyReference(L);
+		var.Value = PackReference(L);
 		if (!std::get<STDString>(var.Value).empty()) {
-			var.Type = UserVariableType::Composite;
+			var.Type = UserVariableType::PackedComposite;
 		} else {
 			var.Type = UserVariableType::Null;
 		}
@@ -1048,17 +1464,44 @@ UserVariable CachedUserVariable::ToUserVariable(lua_State* L) const
 	return var;
 }
 
-STDString CachedUserVariable::StringifyReference(lua_State* L) const
+std::optional<UserVariable> CachedUserVariable::SyncToUserVariable(lua_State* L)
+{
+	uint64_t hash{ 0 };
+	if (Type == CachedUserVariableType::Reference) {
+		hash = HashReference(L);
+		if (hash != 0 && hash == SyncedHash) {
+			return {};
+		}
+	}
+
+	auto var = ToUserVariable(L);
+	SyncedHash = (var.Type == UserVariableType::PackedComposite) ? hash : 0;
+	return var;
+}
+
+uint64_t CachedUserVariable::HashReference(lua_State* L) const
+{
+	std::get<RegistryEntry>(Value).Push();
+	uint64_t hash;
+	if (!StructuralHash(L, -1, hash)) {
+		hash = 0;
+	}
+
+	lua_pop(L, 1);
+	return hash;
+}
+
+STDString CachedUserVariable::PackReference(lua_State* L) const
 {
 	std::get<RegistryEntry>(Value).Push();
 	json::StringifyContext ctx;
-	ctx.Beautify = false;
 
 	STDString str;
 	try {
-		str = json::Stringify(L, ctx, lua_absindex(L, -1));
+		auto packed = msgpack::Pack(L, ctx, lua_absindex(L, -1));
+		str.assign(packed.data(), packed.size());
 	} catch (std::runtime_error& e) {
-		ERR("Error stringifying user variable: %s", e.what());
+		ERR("Error packing user variable: %s", e.what());
 		str.clear();
 	}
 
@@ -1115,8 +1558,11 @@ CachedUserVariable* CachedUserVariableManager::PutCache(EntityHandle entity, Fix
 		if (var) {
 			wasDirty = var->Dirty;
 			bool dirty = var->Dirty || (isWrite && var->LikelyChanged(value));
+			// Writes don't change what the global store holds
+			auto syncedHash = isWrite ? var->SyncedHash : value.SyncedHash;
 			*var = std::move(value);
 			var->Dirty = dirty;
+			var->SyncedHash = syncedHash;
 		} else {
 			var = vars->Vars.set(key, std::move(value));
 			var->Dirty = isWrite;
@@ -1148,6 +1594,10 @@ CachedUserVariable* CachedUserVariableManager::PutCache(EntityHandle entity, Fix
 CachedUserVariable* CachedUserVariableManager::PutCache(lua_State* L, EntityHandle entity, FixedString const& key, Guid const& entityGuid, UserVariablePrototype const& proto, UserVariable const& value)
 {
 	CachedUserVariable var(L, value);
+	if (var.Type == CachedUserVariableType::Reference) {
+		var.SyncedHash = var.HashReference(L);
+	}
+
 	return PutCache(entity, key, entityGuid, proto, std::move(var), false);
 }
 
@@ -1216,9 +1666,11 @@ void CachedUserVariableManager::MoveToGlobal(lua_State* L, EntityHandle entity,
 		return;
 	}
 
-	auto userVar = var.ToUserVariable(L);
-	userVar.Dirty = true;
-	global_.Set(uuid, key, proto, std::move(userVar));
+	auto userVar = var.SyncToUserVariable(L);
+	if (userVar) {
+		userVar->Dirty = true;
+		global_.Set(uuid, key, proto, std::move(*userVar));
+	}
 }
 
 void CachedUserVariableManager::Set(lua_State* L, EntityHandle entity, FixedString const& key, UserVariablePrototype const& proto, CachedUserVariable && var)
@@ -1264,9 +1716,11 @@ void CachedUserVariableManager::Flush()
 			auto var = GetFromCache(req.Entity, req.Variable, entityGuid);
 			if (var && var->Dirty) {
 				USER_VAR_DBG("Flush cached var %016llx/%s", req.Entity.Handle, req.Variable.GetString());
-				auto userVar = var->ToUserVariable(lua->GetState());
-				userVar.Dirty = true;
-				global_.Set(entityGuid, req.Variable, *req.Proto, std::move(userVar));
+				auto userVar = var->SyncToUserVariable(lua->GetState());
+				if (userVar) {
+					userVar->Dirty = true;
+					global_.Set(entityGuid, req.Variable, *req.Proto, std::move(*userVar));
+				}
 				var->Dirty = false;
 			}
 		}
@@ -1333,8 +1787,11 @@ CachedUserVariable* CachedModVariableManager::PutCache(uint32_t modIndex, FixedS
 		if (var) {
 			wasDirty = var->Dirty;
 			bool dirty = var->Dirty || (isWrite && var->LikelyChanged(value));
+			// Writes don't change what the global store holds
+			auto syncedHash = isWrite ? var->SyncedHash : value.SyncedHash;
 			*var = std::move(value);
 			var->Dirty = dirty;
+			var->SyncedHash = syncedHash;
 		} else {
 			var = vars->Vars.set(key, std::move(value));
 			var->Dirty = isWrite;
@@ -1366,6 +1823,10 @@ CachedUserVariable* CachedModVariableManager::PutCache(uint32_t modIndex, FixedS
 CachedUserVariable* CachedModVariableManager::PutCache(lua_State* L, uint32_t modIndex, FixedString const& key, Guid const& modUuid, UserVariablePrototype const& proto, UserVariable const& value)
 {
 	CachedUserVariable var(L, value);
+	if (var.Type == CachedUserVariableType::Reference) {
+		var.SyncedHash = var.HashReference(L);
+	}
+
 	return PutCache(modIndex, key, modUuid, proto, std::move(var), false);
 }
 
@@ -1434,10 +1895,12 @@ void CachedModVariableManager::Set(lua_State* L, uint32_t modIndex, FixedString
 
 		if (cachedVar->Dirty && proto.NeedsSyncFor(isServer_) && proto.Has(UserVariableFlags::SyncOnWrite)) {
 			USER_VAR_DBG("Set global mod var %d/%s", modIndex, key.GetString());
-			auto userVar = cachedVar->ToUserVariable(L);
+			auto userVar = cachedVar->SyncToUserVariable(L);
 			cachedVar->Dirty = false;
-			userVar.Dirty = true;
-			global_.Set(ModIndexToGuid(modIndex), key, proto, std::move(userVar));
+			if (userVar) {
+				userVar->Dirty = true;
+				global_.Set(ModIndexToGuid(modIndex), key, proto, std::move(*userVar));
+			}
 		}
 	} else {
 		USER_VAR_DBG("Set global var %d/%s", modIndex, key.GetString());
@@ -1473,9 +1936,11 @@ void CachedModVariableManager::Flush()
 			auto var = GetFromCache(req.ModIndex, req.Variable, modUuid);
 			if (var && var->Dirty) {
 				USER_VAR_DBG("Flush cached mod var %d/%s", req.ModIndex, req.Variable.GetString());
-				auto userVar = var->ToUserVariable(lua->GetState());
-				userVar.Dirty = true;
-				global_.Set(modUuid, req.Variable, *req.Proto, std::move(userVar));
+				auto userVar = var->SyncToUserVariable(lua->GetState());
+				if (userVar) {
+					userVar->Dirty = true;
+					global_.Set(modUuid, req.Variable, *req.Proto, std::move(*userVar));
+				}
 				var->Dirty = false;
 			}
 		}
@@ -74,6 +74,10 @@ void LoadConfig(std::wstring const & configPath, ExtenderConfig & config)
 	ConfigGetBool(root, "DeveloperMode", config.DeveloperMode);
 	ConfigGetBool(root, "ClearOnReset", config.ClearOnReset);
 	ConfigGetBool(root, "ShowPerfWarnings", config.ShowPerfWarnings);
+	ConfigGetBool(root, "EagerPropertyMapInit", config.EagerPropertyMapInit);
+	ConfigGetBool(root, "EnableLuaBytecodeCache", config.EnableLuaBytecodeCache);
+	ConfigGetBool(root, "EnableLuaScriptPrefetch", config.EnableLuaScriptPrefetch);
+	ConfigGetBool(root, "LogModStats", config.LogModStats);
 	ConfigGetBool(root, "EnableAchievements", config.EnableAchievements);
 	ConfigGetBool(root, "DisableLauncher", config.DisableLauncher);
 	ConfigGetBool(root, "DisableStoryPatching", config.DisableStoryPatching);
@@ -82,6 +86,7 @@ void LoadConfig(std::wstring const & configPath, ExtenderConfig & config)
 	ConfigGetInt(root, "DebuggerPort", config.DebuggerPort);
 	ConfigGetInt(root, "LuaDebuggerPort", config.LuaDebuggerPort);
 	ConfigGetInt(root, "DebugFlags", config.DebugFlags);
+	ConfigGetInt(root, "LuaGCBudgetUs", config.LuaGCBudgetUs);
 
 	ConfigGet(root, "LogDirectory", config.LogDirectory);
 	ConfigGet(root, "LuaBuiltinResourceDirectory", config.LuaBuiltinResourceDirectory);
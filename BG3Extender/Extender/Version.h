@@ -14,6 +14,10 @@ namespace bg3se {
 	static constexpr uint32_t SavegameVerAddedTimers = 10;
 	// Boolean user vars added
 	static constexpr uint32_t SavegameVerBoolUserVars = 11;
+	// Persistent timer arguments stored in binary format
+	static constexpr uint32_t SavegameVerBinaryTimerArgs = 12;
+	// Composite user variables stored in binary format
+	static constexpr uint32_t SavegameVerPackedUserVars = 13;
 	// Last version with savegame changes
-	static constexpr uint32_t SavegameVersion = 11;
+	static constexpr uint32_t SavegameVersion = 13;
 }
@@ -470,6 +470,13 @@ std::optional<ComponentTypeIndex> EntitySystemHelpersBase::GetComponentIndex(Ext
 	}
 }
 
+lua::GenericPropertyMap* EntitySystemHelpersBase::GetPropertyMap(ExtComponentType type) const
+{
+	// Go through the struct registry to make sure that the property map is initialized
+	auto pm = components_[(unsigned)type].Properties;
+	return pm != nullptr ? lua::gStructRegistry.Get(pm->RegistryIndex) : nullptr;
+}
+
 STDString SimplifyComponentName(StringView name)
 {
 	STDString key{ name };
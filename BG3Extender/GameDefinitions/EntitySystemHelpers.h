@@ -165,10 +165,7 @@ public:
 		}
 	}
 
-	lua::GenericPropertyMap* GetPropertyMap(ExtComponentType type) const
-	{
-		return components_[(unsigned)type].Properties;
-	}
+	lua::GenericPropertyMap* GetPropertyMap(ExtComponentType type) const;
 
 	void BindPropertyMap(ExtComponentType type, lua::GenericPropertyMap* pm)
 	{
@@ -40,6 +40,9 @@ FS(CopyFrom);
 // Entity proxy functions
 FS(Vars);
 
+// Container proxy functions
+FS(ToTable);
+
 // Osi proxy functions
 FS(Get);
 FS(Delete);
@@ -108,6 +111,9 @@ FS(Entity);
 FS(ModVariables);
 FS(ModVariable);
 FS(Module);
+FS(High);
+FS(Normal);
+FS(Low);
 
 // Timers
 FS(PersistentTimers);
@@ -117,6 +123,7 @@ FS(Timer);
 FS(Time);
 FS(Handler);
 FS(Args);
+FS(PackedArgs);
 
 // Enums
 FS(Label);
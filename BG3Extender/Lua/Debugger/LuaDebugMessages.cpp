@@ -442,7 +442,7 @@ void DebugMessageHandler::HandleRequestSource(uint32_t seq, DbgRequestSource con
 	}
 
 	if (builtin) {
-		SendSourceResponse(seq, req.name().c_str(), builtin->c_str());
+		SendSourceResponse(seq, req.name().c_str(), STDString(*builtin));
 		return;
 	}
 
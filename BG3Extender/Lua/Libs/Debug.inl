@@ -1,4 +1,5 @@
 #include <Extender/ScriptExtender.h>
+#include <Extender/Shared/ScriptHelpers.h>
 
 /// <lua_module>Debug</lua_module>
 BEGIN_NS(lua::debug)
@@ -270,6 +271,193 @@ void SetEntityRuntimeCheckLevel(int level)
 	}
 }
 
+// Starts the sampling Lua profiler.
+// The call stack is sampled every "intervalUs" microseconds; the elapsed time is checked every "instructionCount" VM instructions.
+// Previously collected samples are discarded. Only available in developer mode.
+bool StartProfiler(lua_State* L, std::optional<int> intervalUs, std::optional<int> instructionCount)
+{
+	if (!gExtender->GetConfig().DeveloperMode) {
+		ERR("The Lua profiler is only available in developer mode");
+		return false;
+	}
+
+	auto& profiler = State::FromLua(L)->GetProfiler();
+	profiler.Clear();
+	return profiler.Start(State::FromLua(L)->GetState(),
+		(uint32_t)intervalUs.value_or(LuaProfiler::DefaultSampleIntervalUs),
+		(uint32_t)instructionCount.value_or(LuaProfiler::DefaultInstructionCount));
+}
+
+// Stops the sampling Lua profiler; collected samples are kept until the next StartProfiler() call
+UserReturn StopProfiler(lua_State* L)
+{
+	auto& profiler = State::FromLua(L)->GetProfiler();
+	profiler.Stop(State::FromLua(L)->GetState());
+	push(L, profiler.GetNumSamples());
+	return 1;
+}
+
+// Saves the collected profiler samples to a file in the user profile directory.
+// Supported formats are "folded" (folded stacks for flame graph tools, default) and "chrome" (Chrome trace event JSON)
+bool SaveProfile(lua_State* L, char const* path, std::optional<STDString> format)
+{
+	auto contents = State::FromLua(L)->GetProfiler().Export(format ? *format : "folded");
+	if (!contents) {
+		OsiError("Unknown profile format: " << *format);
+		return false;
+	}
+
+	return script::SaveExternalFile(path, PathRootType::UserProfile, *contents);
+}
+
+// Returns Lua usage statistics of each mod (handler calls, time spent in handlers and Lua memory allocated/freed).
+// By default the values of the last completed accounting window are returned; pass true to get totals instead.
+UserReturn GetModStats(lua_State* L, std::optional<bool> totals)
+{
+	lua_newtable(L);
+	State::FromLua(L)->GetModAccounting().ForEach([L, totals](ModStats const& stats) {
+		auto counters = totals.value_or(false) ? stats.GetTotal() : stats.LastWindow;
+		auto timeUs = std::chrono::duration_cast<std::chrono::microseconds>(counters.Time).count();
+
+		push(L, stats.Mod ? stats.Mod.GetStringView() : "(unknown)");
+		lua_newtable(L);
+		setfield(L, "Calls", counters.Calls);
+		setfield(L, "TimeUs", (int64_t)timeUs);
+		setfield(L, "AllocatedBytes", counters.AllocatedBytes);
+		setfield(L, "FreedBytes", counters.FreedBytes);
+		lua_settable(L, -3);
+	});
+	return 1;
+}
+
+// Enables or disables periodically logging the most expensive mods; optionally changes the accounting window length.
+// Only available in developer mode; otherwise logging is controlled by the LogModStats config option.
+void SetModStatsLogging(lua_State* L, bool enabled, std::optional<float> windowSeconds)
+{
+	if (!gExtender->GetConfig().DeveloperMode) {
+		ERR("Mod stats logging can only be changed from Lua in developer mode");
+		return;
+	}
+
+	auto& accounting = State::FromLua(L)->GetModAccounting();
+	accounting.SetLogging(enabled);
+	if (windowSeconds && *windowSeconds > 0.0f) {
+		accounting.SetWindowLength(std::chrono::duration_cast<ModAccounting::Clock::duration>(
+			std::chrono::duration<float>(*windowSeconds)));
+	}
+}
+
+// Changes the GC scheduling mode ("Automatic", "Incremental" or "Generational") and optionally the per-tick GC time budget.
+// In the Incremental and Generational modes GC work is mostly done at the end of each tick; the automatic collector only runs as a backstop.
+// Only available in developer mode; otherwise the budget is set by the LuaGCBudgetUs config option.
+bool SetGCMode(lua_State* L, char const* mode, std::optional<int> budgetUs)
+{
+	if (!gExtender->GetConfig().DeveloperMode) {
+		ERR("The GC mode can only be changed from Lua in developer mode");
+		return false;
+	}
+
+	GCScheduler::Mode gcMode;
+	if (strcmp(mode, "Automatic") == 0) {
+		gcMode = GCScheduler::Mode::Automatic;
+	} else if (strcmp(mode, "Incremental") == 0) {
+		gcMode = GCScheduler::Mode::Incremental;
+	} else if (strcmp(mode, "Generational") == 0) {
+		gcMode = GCScheduler::Mode::Generational;
+	} else {
+		OsiError("Unknown GC mode: " << mode);
+		return false;
+	}
+
+	auto state = State::FromLua(L);
+	auto& scheduler = state->GetGCScheduler();
+	if (budgetUs && *budgetUs > 0) {
+		scheduler.SetBudget((uint32_t)*budgetUs);
+	}
+
+	scheduler.SetMode(state->GetState(), gcMode);
+	return true;
+}
+
+// Returns GC timing statistics (time spent in GC in the last tick, average and maximum per tick).
+// The maximum is reset after each call.
+UserReturn GetGCStats(lua_State* L)
+{
+	using namespace std::chrono;
+
+	auto& scheduler = State::FromLua(L)->GetGCScheduler();
+	auto const& stats = scheduler.GetStats();
+	static char const* modeNames[] = { "Automatic", "Incremental", "Generational" };
+
+	lua_newtable(L);
+	setfield(L, "Mode", modeNames[(unsigned)scheduler.GetMode()]);
+	setfield(L, "BudgetUs", scheduler.GetBudget());
+	setfield(L, "LastFrameUs", (int64_t)duration_cast<microseconds>(stats.LastFrameTime).count());
+	setfield(L, "MaxFrameUs", (int64_t)duration_cast<microseconds>(stats.MaxFrameTime).count());
+	setfield(L, "AverageFrameUs", stats.AverageFrameUs);
+	setfield(L, "LastFrameSteps", stats.LastFrameSteps);
+	setfield(L, "Frames", stats.Frames);
+	setfield(L, "Cycles", stats.Cycles);
+	setfield(L, "EmergencyFrames", stats.EmergencyFrames);
+	setfield(L, "HeapKB", lua_gc(L, LUA_GCCOUNT));
+	scheduler.ResetStats();
+	return 1;
+}
+
+void PushAllocatorStats(lua_State* L, LuaPoolAllocator::Stats const& stats)
+{
+	lua_newtable(L);
+	setfield(L, "UsedBytes", stats.UsedBytes);
+	setfield(L, "PeakUsedBytes", stats.PeakUsedBytes);
+	setfield(L, "ReservedBytes", stats.ReservedBytes);
+	setfield(L, "PeakReservedBytes", stats.PeakReservedBytes);
+	setfield(L, "TrimmedBytes", stats.TrimmedBytes);
+	setfield(L, "LargeBlocks", stats.LargeBlocks);
+	setfield(L, "LargeBytes", stats.LargeBytes);
+	// Ratio of reserved memory that is not used by Lua (free list entries, unused slab space and size class rounding)
+	setfield(L, "Fragmentation", stats.ReservedBytes > 0 ? 1.0 - (double)stats.UsedBytes / stats.ReservedBytes : 0.0);
+
+	lua_newtable(L);
+	for (std::size_t i = 0; i < stats.SizeClasses.size(); i++) {
+		auto const& cls = stats.SizeClasses[i];
+		push(L, i + 1);
+		lua_newtable(L);
+		setfield(L, "Size", LuaPoolAllocator::GetClassSize(i));
+		setfield(L, "Blocks", cls.Blocks);
+		setfield(L, "RequestedBytes", cls.RequestedBytes);
+		setfield(L, "SlabBytes", cls.SlabBytes);
+		setfield(L, "TotalAllocations", cls.TotalAllocations);
+		setfield(L, "Fragmentation", cls.SlabBytes > 0 ? 1.0 - (double)cls.RequestedBytes / cls.SlabBytes : 0.0);
+		lua_settable(L, -3);
+	}
+	lua_setfield(L, -2, "SizeClasses");
+}
+
+// Returns memory usage statistics of the Lua allocator (usage by size class, fragmentation and peak usage)
+UserReturn GetAllocatorStats(lua_State* L)
+{
+	PushAllocatorStats(L, State::FromLua(L)->GetAllocator().GetStats());
+	return 1;
+}
+
+// Returns script load statistics of the current Lua state (number of scripts loaded from the bytecode cache
+// and compiled from source and time spent on each) and whether the bytecode cache is enabled
+UserReturn GetBytecodeCacheStats(lua_State* L)
+{
+	using namespace std::chrono;
+
+	auto const& stats = State::FromLua(L)->GetScriptLoadStats();
+	lua_newtable(L);
+	setfield(L, "Enabled", gExtender->GetBytecodeCache().IsEnabled());
+	setfield(L, "Hits", stats.Hits);
+	setfield(L, "Misses", stats.Misses);
+	setfield(L, "Rejected", stats.Rejected);
+	setfield(L, "SourceBytes", stats.SourceBytes);
+	setfield(L, "LoadTimeUs", (int64_t)duration_cast<microseconds>(stats.LoadTime).count());
+	setfield(L, "CompileTimeUs", (int64_t)duration_cast<microseconds>(stats.CompileTime).count());
+	return 1;
+}
+
 void RegisterDebugLib()
 {
 	DECLARE_MODULE(Debug, Both)
@@ -280,6 +468,15 @@ void RegisterDebugLib()
 	MODULE_NAMED_FUNCTION("DebugBreak", LuaDebugBreak)
 	MODULE_FUNCTION(IsDeveloperMode)
 	MODULE_FUNCTION(SetEntityRuntimeCheckLevel)
+	MODULE_FUNCTION(StartProfiler)
+	MODULE_FUNCTION(StopProfiler)
+	MODULE_FUNCTION(SaveProfile)
+	MODULE_FUNCTION(GetModStats)
+	MODULE_FUNCTION(SetModStatsLogging)
+	MODULE_FUNCTION(SetGCMode)
+	MODULE_FUNCTION(GetGCStats)
+	MODULE_FUNCTION(GetAllocatorStats)
+	MODULE_FUNCTION(GetBytecodeCacheStats)
 	MODULE_FUNCTION(Crash)
 	END_MODULE()
 }
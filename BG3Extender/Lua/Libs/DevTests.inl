@@ -0,0 +1,792 @@
+#include <Extender/ScriptExtender.h>
+#include <Extender/Shared/ScriptHelpers.h>
+#include <Lua/Shared/LuaBundleFormat.h>
+#include <Lua/Libs/Json.h>
+#include <Lua/Libs/MsgPack.h>
+#include <Lua/Libs/TimerWheel.h>
+#include <Extender/Shared/UserVariables.h>
+#include <queue>
+#include <random>
+
+// Test and benchmark helpers used by the LuaScripts/Tests suite; only available in developer mode
+BEGIN_NS(lua::devtests)
+
+// Replicates a list of successive values of a composite user variable in-process through the server and client
+// ends of the delta encoding, passing serialized sync and acknowledgement messages between them.
+// If dropBaselineAt is specified, the client forgets the values it received before that value arrives
+// (like after a reconnect); the rejected patch must be recovered by resending the full value.
+// Returns whether the client received every value intact, the delta encoding statistics and the number of
+// values the client kept as baselines at the end.
+UserReturn TestUserVarDeltaLoopback(lua_State* L, AnyRef values, std::optional<int> dropBaselineAt)
+{
+	luaL_checktype(L, values.Index, LUA_TTABLE);
+	auto numValues = (int)lua_rawlen(L, values.Index);
+
+	constexpr PeerId ClientPeer{ 2 };
+	Guid entity;
+	entity.Val[0] = 0x1234;
+	entity.Val[1] = 0x5678;
+	FixedString key("DeltaLoopbackTest");
+
+	net::UserVarDeltaSender server;
+	net::UserVarDeltaReceiver client;
+	Array<net::UserVarDeltaSender::ResyncRequest> resyncs;
+
+	auto send = [&](std::string const& packed, std::string& received) {
+		net::MsgUserVars msg;
+		auto var = msg.add_vars();
+		var->set_type(net::UserVarType::ENTITY_VAR);
+		var->set_uuid1(entity.Val[0]);
+		var->set_uuid2(entity.Val[1]);
+		var->set_key(key.GetString());
+		var->set_packedval(packed);
+		server.OnSend(entity, key, *var);
+		server.EncodeForPeer(ClientPeer, msg);
+
+		net::MsgUserVars clientMsg;
+		clientMsg.ParseFromString(msg.SerializeAsString());
+		net::MsgUserVarAcks acks;
+		auto& clientVar = *clientMsg.mutable_vars(0);
+		auto applied = client.Receive(clientVar, acks);
+		if (applied) {
+			received = clientVar.packedval();
+		}
+
+		net::MsgUserVarAcks serverAcks;
+		serverAcks.ParseFromString(acks.SerializeAsString());
+		server.OnAcks(ClientPeer, serverAcks, net::UserVarType::ENTITY_VAR, resyncs);
+		return applied;
+	};
+
+	bool intact = true;
+	for (int i = 1; i <= numValues; i++) {
+		lua_rawgeti(L, values.Index, i);
+		std::string packed;
+		json::StringifyContext ctx;
+		try {
+			packed = msgpack::Pack(L, ctx, lua_absindex(L, -1));
+		} catch (std::runtime_error& e) {
+			OsiError("Value could not be packed: " << e.what());
+			lua_pop(L, 1);
+			return 0;
+		}
+		lua_pop(L, 1);
+
+		if (dropBaselineAt && *dropBaselineAt == i) {
+			client.Clear();
+		}
+
+		std::string received;
+		resyncs.clear();
+		if (!send(packed, received)) {
+			if (resyncs.empty() || !send(packed, received)) {
+				intact = false;
+				continue;
+			}
+		}
+
+		// Maps may be rebuilt with a different key order on the client
+		std::string patch;
+		if (received != packed && !(net::MakeCompositePatch(packed, received, patch) && patch.empty())) {
+			intact = false;
+		}
+	}
+
+	auto const& stats = server.GetStats();
+	push(L, intact);
+	lua_newtable(L);
+	setfield(L, "FullValues", stats.FullValues);
+	setfield(L, "Patches", stats.Patches);
+	setfield(L, "Resyncs", stats.Resyncs);
+	setfield(L, "FullBytes", stats.FullBytes);
+	setfield(L, "SentBytes", stats.SentBytes);
+	setfield(L, "ClientValues", client.NumValues());
+	return 2;
+}
+
+// Runs the user variable sync scheduler on a list of sync requests for the specified number of ticks, without
+// sending anything. Each request is a table with the tick it is made on (Tick), the variable name (Variable),
+// its sync priority (Low, Normal or High) and sync size in bytes (Size).
+// Returns the list of variables sent in order, each as { Variable, Tick }, and the queue statistics.
+UserReturn SimulateUserVarSync(lua_State* L, AnyRef requests, int budget, int ticks)
+{
+	luaL_checktype(L, requests.Index, LUA_TTABLE);
+
+	struct SyncRequest
+	{
+		int Tick;
+		FixedString Variable;
+		UserVariableSyncPriority Priority;
+		size_t Size;
+	};
+
+	struct SimulatedVariable
+	{
+		size_t Size;
+		bool Dirty;
+	};
+
+	Vector<SyncRequest> syncRequests;
+	auto numRequests = (int)lua_rawlen(L, requests.Index);
+	for (int i = 1; i <= numRequests; i++) {
+		lua_rawgeti(L, requests.Index, i);
+		luaL_checktype(L, -1, LUA_TTABLE);
+		auto idx = lua_absindex(L, -1);
+
+		SyncRequest req{
+			.Tick = gettable<int>(L, "Tick", idx),
+			.Variable = gettable<FixedString>(L, "Variable", idx),
+			.Priority = UserVariableSyncPriority::Normal,
+			.Size = (size_t)gettable<int>(L, "Size", idx)
+		};
+
+		auto priority = gettable<FixedString>(L, "Priority", idx);
+		if (priority == GFS.strHigh) {
+			req.Priority = UserVariableSyncPriority::High;
+		} else if (priority == GFS.strLow) {
+			req.Priority = UserVariableSyncPriority::Low;
+		}
+
+		syncRequests.push_back(req);
+		lua_pop(L, 1);
+	}
+
+	Guid entity;
+	entity.Val[0] = 0x1234;
+	entity.Val[1] = 0x5678;
+
+	UserVariableSyncQueue queue;
+	HashMap<FixedString, SimulatedVariable> vars;
+	lua_newtable(L);
+	int numSent{ 0 };
+	for (int tick = 0; tick < ticks; tick++) {
+		for (auto const& req : syncRequests) {
+			if (req.Tick == tick) {
+				vars.set(req.Variable, SimulatedVariable{ .Size = req.Size, .Dirty = true });
+				queue.Enqueue(entity, req.Variable, req.Priority);
+			}
+		}
+
+		queue.Flush((size_t)budget, [&vars](Guid const&, FixedString const& key) -> std::optional<size_t> {
+			auto var = vars.try_get(key);
+			if (!var || !var->Dirty) return {};
+			return var->Size;
+		}, [L, &vars, &numSent, tick](Guid const&, FixedString const& key) {
+			vars.try_get(key)->Dirty = false;
+			lua_createtable(L, 0, 2);
+			setfield(L, "Variable", key);
+			setfield(L, "Tick", tick);
+			lua_rawseti(L, -2, ++numSent);
+		});
+		queue.NextTick();
+	}
+
+	auto const& stats = queue.GetStats();
+	lua_newtable(L);
+	setfield(L, "QueueDepth", stats.QueueDepth);
+	setfield(L, "PeakQueueDepth", stats.PeakQueueDepth);
+	setfield(L, "Requests", stats.Requests);
+	setfield(L, "Coalesced", stats.Coalesced);
+	setfield(L, "Sent", stats.Sent);
+	setfield(L, "BudgetLimitedTicks", stats.BudgetLimitedTicks);
+	return 2;
+}
+
+// Toggles the generated per-type serializers; when disabled, (un)serialization
+// falls back to walking the property map (used for benchmarking and debugging)
+void SetGeneratedSerializers(bool enabled)
+{
+	gUseGeneratedSerializers = enabled;
+}
+
+// Measures the throughput of the deferred Lua call queue used by timers and IMGUI events.
+// Queues "count" calls to the function and flushes the queue, repeated for the specified number of frames;
+// returns the average time spent queueing and flushing calls per frame in microseconds.
+UserReturn BenchmarkDeferredCalls(lua_State* L, FunctionRef func, int count, std::optional<int> frames)
+{
+	using namespace std::chrono;
+
+	LuaDelegate<void(int64_t)> delegate(L, func.Index);
+	DeferredLuaDelegateQueue queue;
+	auto numFrames = frames.value_or(10);
+	double queueTime{ 0.0 }, flushTime{ 0.0 };
+
+	// First frame is a warmup frame that allocates arena memory
+	for (int frame = 0; frame <= numFrames; frame++) {
+		auto start = high_resolution_clock::now();
+		for (int i = 0; i < count; i++) {
+			queue.Call(delegate, (int64_t)i);
+		}
+
+		auto queued = high_resolution_clock::now();
+		queue.Flush();
+		auto flushed = high_resolution_clock::now();
+
+		if (frame > 0) {
+			queueTime += duration_cast<nanoseconds>(queued - start).count() / 1000.0;
+			flushTime += duration_cast<nanoseconds>(flushed - queued).count() / 1000.0;
+		}
+	}
+
+	push(L, queueTime / numFrames);
+	push(L, flushTime / numFrames);
+	return 2;
+}
+
+void* GameLuaAlloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+	if (nsize == 0) {
+		GameFree(ptr);
+		return nullptr;
+	} else {
+		auto newBuf = GameAllocRaw(nsize);
+		if (ptr != nullptr) {
+			memcpy(newBuf, ptr, std::min(nsize, osize));
+			GameFree(ptr);
+		}
+
+		return newBuf;
+	}
+}
+
+std::optional<double> RunAllocatorBenchmark(lua_Alloc alloc, void* ud, char const* code, int iterations)
+{
+	using namespace std::chrono;
+
+	auto start = high_resolution_clock::now();
+	auto stub = lua_newstate(alloc, ud);
+	lua_setup_strcache(stub, &LuaCacheString, &LuaReleaseString);
+	luaL_requiref(stub, "_G", luaopen_base, 1);
+	luaL_requiref(stub, LUA_TABLIBNAME, luaopen_table, 1);
+	luaL_requiref(stub, LUA_STRLIBNAME, luaopen_string, 1);
+	luaL_requiref(stub, LUA_MATHLIBNAME, luaopen_math, 1);
+	lua_settop(stub, 0);
+
+	bool succeeded{ true };
+	for (int i = 0; i < iterations && succeeded; i++) {
+		if (luaL_loadstring(stub, code) != LUA_OK || lua_pcall(stub, 0, 0, 0) != LUA_OK) {
+			OsiError("Allocator benchmark failed: " << lua_tostring(stub, -1));
+			succeeded = false;
+		}
+	}
+
+	lua_close(stub);
+	if (!succeeded) return {};
+
+	return duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / 1000.0;
+}
+
+// Runs a Lua chunk in two stub Lua states (with only the base, table, string and math libraries),
+// one using the pooled Lua allocator and one using the game allocator directly.
+// Returns the time taken with each allocator in microseconds and the stats of the pooled allocator
+// (after trimming it on exit).
+UserReturn BenchmarkAllocator(lua_State* L, char const* code, std::optional<int> iterations)
+{
+	auto numIterations = iterations.value_or(10);
+	LuaPoolAllocator pool;
+	auto pooledTime = RunAllocatorBenchmark(&LuaPoolAllocator::LuaAlloc, &pool, code, numIterations);
+	// All blocks were freed by lua_close(), so this should release every slab
+	pool.Trim();
+	auto gameTime = RunAllocatorBenchmark(&GameLuaAlloc, nullptr, code, numIterations);
+	if (!pooledTime || !gameTime) {
+		return 0;
+	}
+
+	push(L, *pooledTime);
+	push(L, *gameTime);
+	debug::PushAllocatorStats(L, pool.GetStats());
+	return 3;
+}
+
+// Deletes all entries from the bytecode cache; returns the number of entries deleted
+unsigned ClearBytecodeCache(lua_State* L)
+{
+	return gExtender->GetBytecodeCache().Clear();
+}
+
+// Measures the time needed to compile a Lua chunk from source and to load its precompiled bytecode.
+// Returns the compile and load times in microseconds and the size of the bytecode.
+UserReturn BenchmarkBytecodeCache(lua_State* L, char const* code, std::optional<int> iterations)
+{
+	using namespace std::chrono;
+
+	std::string_view source(code);
+	STDString bytecode;
+	if (BytecodeCache::Compile(L, source, "=benchmark", bytecode) != LUA_OK) {
+		OsiError("Failed to compile benchmark chunk: " << lua_tostring(L, -1));
+		lua_pop(L, 1);
+		return 0;
+	}
+	lua_pop(L, 1);
+
+	auto numIterations = iterations.value_or(100);
+	auto compileStart = high_resolution_clock::now();
+	for (int i = 0; i < numIterations; i++) {
+		luaL_loadbufferx(L, source.data(), source.size(), "=benchmark", "t");
+		lua_pop(L, 1);
+	}
+
+	auto loadStart = high_resolution_clock::now();
+	for (int i = 0; i < numIterations; i++) {
+		luaL_loadbufferx(L, bytecode.data(), bytecode.size(), "=benchmark", "b");
+		lua_pop(L, 1);
+	}
+	auto loadEnd = high_resolution_clock::now();
+
+	push(L, duration_cast<nanoseconds>(loadStart - compileStart).count() / 1000.0);
+	push(L, duration_cast<nanoseconds>(loadEnd - loadStart).count() / 1000.0);
+	push(L, bytecode.size());
+	return 3;
+}
+
+std::optional<double> RunBundleBenchmark(std::vector<uint8_t> const& buf, std::vector<STDString> const& paths, int iterations)
+{
+	using namespace std::chrono;
+
+	auto start = high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		LuaBundle bundle;
+		if (!bundle.LoadBuffer(std::span(buf.data(), buf.size()))) {
+			return {};
+		}
+
+		for (auto const& path : paths) {
+			if (!bundle.GetResource(path)) {
+				OsiError("Resource missing from benchmark bundle: " << path);
+				return {};
+			}
+		}
+	}
+
+	return duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / 1000.0 / iterations;
+}
+
+// Repacks the builtin Lua scripts in each bundle format ("V1", "V2" and "V2Compressed") and measures the time
+// taken to load the bundle and look up every script. Returns the average time per load in microseconds and the bundle size.
+UserReturn BenchmarkLuaBundle(lua_State* L, std::optional<int> iterations)
+{
+	bundle::Writer writer;
+	std::vector<STDString> paths;
+	gExtender->GetLuaBuiltinBundle().ForEach([&](std::string_view path, std::string_view body) {
+		writer.Add(std::string(path), std::string(body));
+		paths.push_back(STDString(path));
+	});
+
+	std::pair<char const*, std::vector<uint8_t>> bundles[] = {
+		{ "V1", writer.WriteV1() },
+		{ "V2", writer.WriteV2(false) },
+		{ "V2Compressed", writer.WriteV2(true) }
+	};
+
+	lua_newtable(L);
+	for (auto const& bundle : bundles) {
+		auto loadTime = RunBundleBenchmark(bundle.second, paths, iterations.value_or(100));
+		if (!loadTime) continue;
+
+		lua_newtable(L);
+		setfield(L, "LoadUs", *loadTime);
+		setfield(L, "Size", bundle.second.size());
+		lua_setfield(L, -2, bundle.first);
+	}
+
+	return 1;
+}
+
+std::optional<double> RunJsonParseBenchmark(lua_State* L, std::string_view doc, int iterations,
+	bool (*parse)(lua_State*, StringView, STDString&))
+{
+	using namespace std::chrono;
+
+	STDString error;
+	auto start = high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		if (!parse(L, doc, error)) {
+			OsiError("JSON benchmark document could not be parsed: " << error);
+			return {};
+		}
+		lua_pop(L, 1);
+	}
+
+	return duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / 1000.0 / iterations;
+}
+
+// Parses a JSON document with the streaming parser used by Ext.Json.Parse and with the jsoncpp DOM parser.
+// Returns the average parse time of each parser in microseconds.
+UserReturn BenchmarkJsonParse(lua_State* L, char const* json, std::optional<int> iterations)
+{
+	std::string_view doc(json);
+	auto numIterations = iterations.value_or(10);
+	auto streamingTime = RunJsonParseBenchmark(L, doc, numIterations, &json::Parse);
+	auto domTime = RunJsonParseBenchmark(L, doc, numIterations, &json::ParseWithJsonCpp);
+	if (!streamingTime || !domTime) {
+		return 0;
+	}
+
+	push(L, *streamingTime);
+	push(L, *domTime);
+	return 2;
+}
+
+std::optional<double> RunJsonStringifyBenchmark(lua_State* L, int index, bool iterateUserdata, int iterations,
+	std::string (*stringify)(lua_State*, json::StringifyContext&, int), std::string& result)
+{
+	using namespace std::chrono;
+
+	auto start = high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		json::StringifyContext ctx;
+		ctx.StringifyInternalTypes = true;
+		ctx.IterateUserdata = iterateUserdata;
+		ctx.AvoidRecursion = iterateUserdata;
+		try {
+			result = stringify(L, ctx, index);
+		} catch (std::runtime_error& e) {
+			OsiError("JSON benchmark value could not be stringified: " << e.what());
+			return {};
+		}
+	}
+
+	return duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / 1000.0 / iterations;
+}
+
+// Stringifies a value with the streaming writer used by Ext.Json.Stringify and with the jsoncpp DOM writer.
+// Returns the average time taken by each writer in microseconds, the size of the output and whether the outputs are identical.
+UserReturn BenchmarkJsonStringify(lua_State* L, AnyRef value, std::optional<int> iterations, std::optional<bool> iterateUserdata)
+{
+	auto numIterations = iterations.value_or(10);
+	std::string streamingResult, domResult;
+	DisablePropertyWarnings();
+	auto streamingTime = RunJsonStringifyBenchmark(L, value.Index, iterateUserdata.value_or(false), numIterations,
+		&json::Stringify, streamingResult);
+	auto domTime = RunJsonStringifyBenchmark(L, value.Index, iterateUserdata.value_or(false), numIterations,
+		&json::StringifyWithJsonCpp, domResult);
+	EnablePropertyWarnings();
+	if (!streamingTime || !domTime) {
+		return 0;
+	}
+
+	push(L, *streamingTime);
+	push(L, *domTime);
+	push(L, streamingResult.size());
+	push(L, streamingResult == domResult);
+	return 4;
+}
+
+// Simulates timer load with the timing wheel used by Ext.Timer and with a binary heap that leaves cancelled
+// timers in the queue until they expire (the previous implementation).
+// Starts the specified number of timers (100000 by default) with a random delay of up to 10 seconds, then runs
+// 1000 frames at 60 FPS, each restarting 1% of the timers (cancel + re-add).
+// Returns the time taken by the wheel and the heap in microseconds, and the peak number of queued heap entries.
+UserReturn BenchmarkTimers(lua_State* L, std::optional<int> count)
+{
+	using namespace std::chrono;
+
+	auto numTimers = (uint32_t)std::max(count.value_or(100000), 1);
+	auto restartsPerFrame = std::max(numTimers / 100, 1u);
+	constexpr int NumFrames = 1000;
+	constexpr double FrameTime = 1.0 / 60.0;
+
+	std::size_t wheelFired{ 0 }, heapFired{ 0 };
+	auto start = high_resolution_clock::now();
+	{
+		std::mt19937 rng(1);
+		timer::TimerWheel wheel;
+		std::vector<timer::TimerWheel::EntryIndex> entries(numTimers);
+		double now = 0.0;
+		for (uint32_t i = 0; i < numTimers; i++) {
+			entries[i] = wheel.Add(now + (rng() % 10000) / 1000.0, i);
+		}
+
+		for (int frame = 0; frame < NumFrames; frame++) {
+			now += FrameTime;
+			for (uint32_t j = 0; j < restartsPerFrame; j++) {
+				auto i = rng() % numTimers;
+				wheel.Remove(entries[i], i);
+				entries[i] = wheel.Add(now + (rng() % 10000) / 1000.0, i);
+			}
+
+			wheel.Advance(now, [&wheelFired](timer::TimerHandle) { wheelFired++; });
+		}
+	}
+	auto wheelTime = duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / 1000.0;
+
+	std::size_t peakHeapSize{ 0 };
+	start = high_resolution_clock::now();
+	{
+		using QueueEntry = std::pair<double, timer::TimerHandle>;
+		std::mt19937 rng(1);
+		std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> heap;
+		// Cancellation only bumps the generation of the timer; stale heap entries are skipped when popped
+		std::vector<uint32_t> generations(numTimers, 0);
+		double now = 0.0;
+		for (uint32_t i = 0; i < numTimers; i++) {
+			heap.push({ now + (rng() % 10000) / 1000.0, i });
+		}
+
+		for (int frame = 0; frame < NumFrames; frame++) {
+			now += FrameTime;
+			for (uint32_t j = 0; j < restartsPerFrame; j++) {
+				auto i = rng() % numTimers;
+				generations[i]++;
+				heap.push({ now + (rng() % 10000) / 1000.0, ((uint64_t)generations[i] << 32) | i });
+			}
+
+			peakHeapSize = std::max(peakHeapSize, heap.size());
+			while (!heap.empty() && heap.top().first <= now) {
+				auto handle = heap.top().second;
+				heap.pop();
+				if ((handle >> 32) == generations[(uint32_t)handle]) heapFired++;
+			}
+		}
+	}
+	auto heapTime = duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / 1000.0;
+
+	if (wheelFired != heapFired) {
+		OsiError("Timer benchmark mismatch: wheel fired " << wheelFired << " timers, heap fired " << heapFired);
+	}
+
+	push(L, wheelTime);
+	push(L, heapTime);
+	push(L, peakHeapSize);
+	return 3;
+}
+
+// Round-trips persistent timers through savegame loading and saving: a record from a savegame before
+// SavegameVerBinaryTimerArgs with JSON arguments, and a record with MessagePack encoded arguments.
+// The saved records are loaded and saved again, like a savegame made after the conversion.
+// Returns the final records as { Callback, Time, Packed, Args }, where Packed is whether the arguments were
+// saved in MessagePack format and Args are the decoded arguments.
+UserReturn TestTimerPersistence(lua_State* L, char const* jsonArgs, AnyRef packedArgs)
+{
+	using Record = timer::TimerManager::PersistentTimerRecord;
+
+	std::string packed;
+	json::StringifyContext ctx;
+	try {
+		packed = msgpack::Pack(L, ctx, packedArgs.Index);
+	} catch (std::runtime_error& e) {
+		OsiError("Value could not be packed: " << e.what());
+		return 0;
+	}
+
+	auto state = State::FromLua(L);
+	DeferredLuaDelegateQueue queue;
+	timer::TimerManager loaded(*state, queue);
+	loaded.LoadPersistent(Record{
+		.Time = 10.0,
+		.Callback = FixedString("JsonTimer"),
+		.Args = jsonArgs
+	});
+	loaded.LoadPersistent(Record{
+		.Time = 20.0,
+		.Callback = FixedString("PackedTimer"),
+		.PackedArgs = EncodeBase64(packed)
+	});
+
+	Vector<Record> saved;
+	loaded.SavePersistent(saved);
+
+	timer::TimerManager reloaded(*state, queue);
+	for (auto const& record : saved) {
+		reloaded.LoadPersistent(record);
+	}
+
+	Vector<Record> resaved;
+	reloaded.SavePersistent(resaved);
+
+	lua_createtable(L, (int)resaved.size(), 0);
+	for (uint32_t i = 0; i < resaved.size(); i++) {
+		auto const& record = resaved[i];
+		lua_createtable(L, 0, 4);
+		setfield(L, "Callback", record.Callback);
+		setfield(L, "Time", record.Time);
+		setfield(L, "Packed", !record.PackedArgs.empty());
+
+		STDString args;
+		if (DecodeBase64(record.PackedArgs, args) && msgpack::Unpack(L, args)) {
+			lua_setfield(L, -2, "Args");
+		}
+
+		lua_rawseti(L, -2, i + 1);
+	}
+
+	return 1;
+}
+
+// Runs a list of operations on a timer wheel: { Op = "Add", Id, Time }, { Op = "Cancel", Id } and
+// { Op = "Advance", Time }. The ID is used as the timer handle; Cancel removes the wheel entry returned by
+// the last Add of the ID, so cancelling timers that already fired or whose entry was reused can be tested.
+// Returns the fired timers as { Id, Time } (where Time is the time of the Advance that fired it),
+// the results of the Cancel operations and the number of timers left in the wheel.
+UserReturn SimulateTimerWheel(lua_State* L, AnyRef ops)
+{
+	luaL_checktype(L, ops.Index, LUA_TTABLE);
+
+	timer::TimerWheel wheel;
+	std::unordered_map<timer::TimerHandle, timer::TimerWheel::EntryIndex> entries;
+	lua_newtable(L);
+	auto firedIdx = lua_gettop(L);
+	lua_newtable(L);
+	auto cancelledIdx = lua_gettop(L);
+	int numFired{ 0 }, numCancelled{ 0 };
+
+	auto numOps = (int)lua_rawlen(L, ops.Index);
+	for (int i = 1; i <= numOps; i++) {
+		lua_rawgeti(L, ops.Index, i);
+		luaL_checktype(L, -1, LUA_TTABLE);
+		auto idx = lua_absindex(L, -1);
+		auto op = gettable<FixedString>(L, "Op", idx).GetStringView();
+
+		if (op == "Add") {
+			auto handle = (timer::TimerHandle)gettable<int64_t>(L, "Id", idx);
+			entries[handle] = wheel.Add(gettable<double>(L, "Time", idx), handle);
+		} else if (op == "Cancel") {
+			auto handle = (timer::TimerHandle)gettable<int64_t>(L, "Id", idx);
+			auto it = entries.find(handle);
+			push(L, it != entries.end() && wheel.Remove(it->second, handle));
+			lua_rawseti(L, cancelledIdx, ++numCancelled);
+		} else if (op == "Advance") {
+			auto time = gettable<double>(L, "Time", idx);
+			wheel.Advance(time, [L, firedIdx, &numFired, time](timer::TimerHandle handle) {
+				lua_createtable(L, 0, 2);
+				setfield(L, "Id", (int64_t)handle);
+				setfield(L, "Time", time);
+				lua_rawseti(L, firedIdx, ++numFired);
+			});
+		} else {
+			return luaL_error(L, "Unknown timer wheel operation: %s", op.data());
+		}
+
+		lua_pop(L, 1);
+	}
+
+	push(L, wheel.Size());
+	return 3;
+}
+
+// Starts batched timers { Time, Handler, Arg } on a separate timer manager, cancels the timers at the
+// specified (1-based) indices and updates the manager to the specified time. The handlers of the due timers
+// are called before returning.
+// Returns the handles of the timers and the batching statistics.
+UserReturn SimulateBatchedTimers(lua_State* L, AnyRef timers, AnyRef cancels, double time)
+{
+	luaL_checktype(L, timers.Index, LUA_TTABLE);
+	luaL_checktype(L, cancels.Index, LUA_TTABLE);
+
+	DeferredLuaDelegateQueue queue;
+	timer::TimerManager manager(*State::FromLua(L), queue);
+
+	auto numTimers = (int)lua_rawlen(L, timers.Index);
+	Vector<timer::TimerHandle> handles;
+	for (int i = 1; i <= numTimers; i++) {
+		lua_rawgeti(L, timers.Index, i);
+		luaL_checktype(L, -1, LUA_TTABLE);
+		auto idx = lua_absindex(L, -1);
+
+		lua_getfield(L, idx, "Handler");
+		luaL_checktype(L, -1, LUA_TFUNCTION);
+		Ref handler(L, lua_absindex(L, -1));
+
+		RegistryEntry arg;
+		if (lua_getfield(L, idx, "Arg") != LUA_TNIL) {
+			arg = RegistryEntry(L, -1);
+		}
+		lua_pop(L, 1);
+
+		handles.push_back(manager.AddBatched(gettable<double>(L, "Time", idx), handler, std::move(arg)));
+		lua_pop(L, 2);
+	}
+
+	auto numCancels = (int)lua_rawlen(L, cancels.Index);
+	for (int i = 1; i <= numCancels; i++) {
+		lua_rawgeti(L, cancels.Index, i);
+		auto index = (int)lua_tointeger(L, -1);
+		lua_pop(L, 1);
+		if (index >= 1 && index <= (int)handles.size()) {
+			manager.Cancel(handles[index - 1]);
+		}
+	}
+
+	manager.Update(time);
+	queue.Flush();
+
+	lua_createtable(L, (int)handles.size(), 0);
+	for (uint32_t i = 0; i < handles.size(); i++) {
+		push(L, handles[i]);
+		lua_rawseti(L, -2, i + 1);
+	}
+
+	auto const& stats = manager.GetBatchingStats();
+	lua_newtable(L);
+	setfield(L, "TimersFired", stats.TimersFired);
+	setfield(L, "Dispatches", stats.Dispatches);
+	return 2;
+}
+
+// Measures the cost of checking a list of table values for changes when cached user variables are flushed:
+// computing their structural hash (current check) vs. packing them (the cost of a flush without the check).
+// Returns the average time of one pass over all values for each method in microseconds.
+UserReturn BenchmarkUserVarChangeDetection(lua_State* L, AnyRef values, std::optional<int> iterations)
+{
+	using namespace std::chrono;
+
+	luaL_checktype(L, values.Index, LUA_TTABLE);
+	auto numValues = (int)lua_rawlen(L, values.Index);
+	auto numIterations = iterations.value_or(10);
+
+	auto start = high_resolution_clock::now();
+	for (int i = 0; i < numIterations; i++) {
+		for (int j = 1; j <= numValues; j++) {
+			lua_rawgeti(L, values.Index, j);
+			uint64_t hash;
+			StructuralHash(L, -1, hash);
+			lua_pop(L, 1);
+		}
+	}
+	auto hashTime = duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / 1000.0 / numIterations;
+
+	start = high_resolution_clock::now();
+	for (int i = 0; i < numIterations; i++) {
+		for (int j = 1; j <= numValues; j++) {
+			lua_rawgeti(L, values.Index, j);
+			json::StringifyContext ctx;
+			try {
+				msgpack::Pack(L, ctx, lua_absindex(L, -1));
+			} catch (std::runtime_error& e) {
+				OsiError("Value could not be packed: " << e.what());
+				lua_pop(L, 1);
+				return 0;
+			}
+			lua_pop(L, 1);
+		}
+	}
+	auto packTime = duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / 1000.0 / numIterations;
+
+	push(L, hashTime);
+	push(L, packTime);
+	return 2;
+}
+
+void RegisterDevTestsLib()
+{
+	DECLARE_DEVELOPER_MODULE(DevTests, Both)
+	BEGIN_MODULE()
+	MODULE_FUNCTION(TestUserVarDeltaLoopback)
+	MODULE_FUNCTION(SimulateUserVarSync)
+	MODULE_FUNCTION(SetGeneratedSerializers)
+	MODULE_FUNCTION(BenchmarkDeferredCalls)
+	MODULE_FUNCTION(BenchmarkAllocator)
+	MODULE_FUNCTION(ClearBytecodeCache)
+	MODULE_FUNCTION(BenchmarkBytecodeCache)
+	MODULE_FUNCTION(BenchmarkLuaBundle)
+	MODULE_FUNCTION(BenchmarkJsonParse)
+	MODULE_FUNCTION(BenchmarkJsonStringify)
+	MODULE_FUNCTION(BenchmarkTimers)
+	MODULE_FUNCTION(TestTimerPersistence)
+	MODULE_FUNCTION(SimulateTimerWheel)
+	MODULE_FUNCTION(SimulateBatchedTimers)
+	MODULE_FUNCTION(BenchmarkUserVarChangeDetection)
+	END_MODULE()
+}
+
+END_NS()
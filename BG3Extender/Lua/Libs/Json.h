@@ -1,5 +1,51 @@
+#pragma once
+
 BEGIN_NS(lua::json)
 
+// Open addressing hash set of the tables and userdata visited while stringifying (for AvoidRecursion);
+// lookups and inserts don't allocate a node per element like std::unordered_set does
+class VisitedPointerSet
+{
+public:
+	// Adds the pointer to the set; returns false if it was already present
+	bool Insert(void* ptr)
+	{
+		if ((size_ + 1) * 4 > slots_.size() * 3) {
+			Grow();
+		}
+
+		auto mask = slots_.size() - 1;
+		for (auto i = Hash(ptr) & mask;; i = (i + 1) & mask) {
+			if (slots_[i] == ptr) return false;
+			if (slots_[i] == nullptr) {
+				slots_[i] = ptr;
+				size_++;
+				return true;
+			}
+		}
+	}
+
+private:
+	std::vector<void*> slots_;
+	std::size_t size_{ 0 };
+
+	static inline std::size_t Hash(void* ptr)
+	{
+		auto h = (uint64_t)ptr * 0x9E3779B97F4A7C15ull;
+		return (std::size_t)(h ^ (h >> 32));
+	}
+
+	void Grow()
+	{
+		std::vector<void*> slots(std::max<std::size_t>(64, slots_.size() * 2), nullptr);
+		std::swap(slots, slots_);
+		size_ = 0;
+		for (auto ptr : slots) {
+			if (ptr != nullptr) Insert(ptr);
+		}
+	}
+};
+
 struct StringifyContext
 {
 	bool StringifyInternalTypes{ false };
@@ -9,10 +55,16 @@ struct StringifyContext
 	uint32_t MaxDepth{ 64 };
 	int32_t LimitDepth{ -1 };
 	int32_t LimitArrayElements{ -1 };
-	std::unordered_set<void*> SeenUserdata;
+	VisitedPointerSet SeenUserdata;
 };
 
 std::string Stringify(lua_State * L, StringifyContext& ctx, int index);
+std::string StringifyWithJsonCpp(lua_State * L, StringifyContext& ctx, int index);
+// Reads Stringify options from the table at the specified stack index
+void GetStringifyOptions(lua_State * L, int index, StringifyContext& ctx);
+// Parses a JSON document and pushes the resulting Lua value; nothing is pushed if parsing fails
+bool Parse(lua_State* L, StringView json, STDString& error);
 bool Parse(lua_State* L, StringView json);
+bool ParseWithJsonCpp(lua_State* L, StringView json, STDString& error);
 
 END_NS()
@@ -1,5 +1,6 @@
 #include <Lua/Libs/Json.h>
 
+#include <charconv>
 #include <fstream>
 #include <unordered_set>
 #include <json/json.h>
@@ -71,7 +72,9 @@ void Parse(lua_State * L, Json::Value const & val)
 	}
 }
 
-bool Parse(lua_State * L, StringView json)
+// Parses the document into a jsoncpp DOM and converts it to Lua values afterwards.
+// Only used for comparing against the streaming parser.
+bool ParseWithJsonCpp(lua_State * L, StringView json, STDString& error)
 {
 	Json::CharReaderBuilder factory;
 	std::unique_ptr<Json::CharReader> reader(factory.newCharReader());
@@ -79,7 +82,7 @@ bool Parse(lua_State * L, StringView json)
 	Json::Value root;
 	std::string errs;
 	if (!reader->parse(json.data(), json.data() + json.size(), &root, &errs)) {
-		ERR("Unable to parse JSON: %s", errs.c_str());
+		error = errs.c_str();
 		return false;
 	}
 
@@ -87,22 +90,516 @@ bool Parse(lua_State * L, StringView json)
 	return true;
 }
 
+// Streaming JSON parser that pushes Lua values while tokenizing, without building a jsoncpp DOM first.
+// Accepts the same documents as the jsoncpp reader with its default settings (comments are allowed,
+// data after the root value is ignored) and produces the same Lua values.
+class LuaJsonParser
+{
+public:
+	// Maximum nesting depth of arrays and objects (same as the jsoncpp default)
+	static constexpr unsigned MaxDepth = 1000;
+	// Number of array elements / object members kept on the Lua stack before the table is created.
+	// Containers with fewer elements than this are created with their exact size.
+	static constexpr int MaxBufferedElements = 64;
+
+	LuaJsonParser(lua_State* L, StringView json)
+		: L_(L), begin_(json.data()), pos_(json.data()), end_(json.data() + json.size())
+	{}
+
+	bool Parse()
+	{
+		auto top = lua_gettop(L_);
+		if (!SkipWhitespace() || !ParseValue(0)) {
+			lua_settop(L_, top);
+			return false;
+		}
+
+		return true;
+	}
+
+	inline STDString const& GetError() const
+	{
+		return error_;
+	}
+
+private:
+	lua_State* L_;
+	char const* begin_;
+	char const* pos_;
+	char const* end_;
+	// Buffer for decoding strings that contain escape sequences
+	std::string scratch_;
+	STDString error_;
+
+	bool Fail(char const* msg)
+	{
+		int line{ 1 };
+		auto lineStart = begin_;
+		for (auto p = begin_; p < pos_; p++) {
+			if (*p == '\n') {
+				line++;
+				lineStart = p + 1;
+			}
+		}
+
+		char location[64];
+		sprintf_s(location, "Line %d, column %d: ", line, (int)(pos_ - lineStart) + 1);
+		error_ = location;
+		error_ += msg;
+		return false;
+	}
+
+	bool CheckStack(int slots)
+	{
+		return lua_checkstack(L_, slots) || Fail("Lua stack overflow");
+	}
+
+	bool SkipWhitespace()
+	{
+		while (pos_ < end_) {
+			auto c = *pos_;
+			if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+				pos_++;
+			} else if (c == '/' && pos_ + 1 < end_ && pos_[1] == '/') {
+				while (pos_ < end_ && *pos_ != '\n') pos_++;
+			} else if (c == '/' && pos_ + 1 < end_ && pos_[1] == '*') {
+				auto commentEnd = std::string_view(pos_ + 2, end_ - pos_ - 2).find("*/");
+				if (commentEnd == std::string_view::npos) {
+					return Fail("Unterminated comment");
+				}
+				pos_ += commentEnd + 4;
+			} else {
+				break;
+			}
+		}
+
+		return true;
+	}
+
+	bool ParseValue(unsigned depth)
+	{
+		if (pos_ >= end_) {
+			return Fail("Unexpected end of document, value expected");
+		}
+
+		// One slot for the value and one for creating the table of the enclosing array
+		if (!CheckStack(2)) return false;
+
+		switch (*pos_) {
+		case '{': return ParseObject(depth + 1);
+		case '[': return ParseArray(depth + 1);
+		case '"': return ParseString();
+		case 't': return ParseLiteral("true", [this] { lua_pushboolean(L_, 1); });
+		case 'f': return ParseLiteral("false", [this] { lua_pushboolean(L_, 0); });
+		case 'n': return ParseLiteral("null", [this] { lua_pushnil(L_); });
+		default: return ParseNumber();
+		}
+	}
+
+	template <class Fun>
+	bool ParseLiteral(std::string_view literal, Fun push)
+	{
+		if ((std::size_t)(end_ - pos_) < literal.size() || std::string_view(pos_, literal.size()) != literal) {
+			return Fail("Syntax error: value, object or array expected");
+		}
+
+		pos_ += literal.size();
+		push();
+		return true;
+	}
+
+	bool ParseNumber()
+	{
+		auto start = pos_;
+		bool isInteger{ true };
+		while (pos_ < end_) {
+			auto c = *pos_;
+			if (c >= '0' && c <= '9' || c == '-' || c == '+') {
+				pos_++;
+			} else if (c == '.' || c == 'e' || c == 'E') {
+				isInteger = false;
+				pos_++;
+			} else {
+				break;
+			}
+		}
+
+		if (start == pos_) {
+			return Fail("Syntax error: value, object or array expected");
+		}
+
+		if (isInteger) {
+			int64_t value;
+			auto result = std::from_chars(start, pos_, value);
+			if (result.ptr == pos_ && result.ec == std::errc{}) {
+				lua_pushinteger(L_, value);
+				return true;
+			}
+
+			// Values between INT64_MAX and UINT64_MAX are wrapped around, same as for the DOM parser
+			uint64_t uvalue;
+			result = std::from_chars(start, pos_, uvalue);
+			if (result.ptr == pos_ && result.ec == std::errc{}) {
+				lua_pushinteger(L_, (int64_t)uvalue);
+				return true;
+			}
+		}
+
+		double value;
+		auto result = std::from_chars(start, pos_, value);
+		if (result.ptr == pos_ && result.ec == std::errc::result_out_of_range) {
+			// Out of range values are rounded to +/-inf or zero, same as for the DOM parser
+			value = IsOverflow(start, pos_) ? std::numeric_limits<double>::infinity() : 0.0;
+			if (*start == '-') value = -value;
+		} else if (result.ptr != pos_ || result.ec != std::errc{}) {
+			pos_ = start;
+			return Fail("Invalid number");
+		}
+
+		lua_pushnumber(L_, value);
+		return true;
+	}
+
+	// Checks whether a number that is out of the range of doubles is too large or too small
+	static bool IsOverflow(char const* p, char const* end)
+	{
+		// Decimal exponent of the first significant digit
+		int64_t magnitude{ -1 };
+		bool significant{ false }, fraction{ false };
+		for (; p < end && *p != 'e' && *p != 'E'; p++) {
+			if (*p == '.') {
+				fraction = true;
+			} else if (*p >= '0' && *p <= '9' && !fraction) {
+				if (significant || *p != '0') {
+					significant = true;
+					magnitude++;
+				}
+			} else if (*p >= '0' && *p <= '9' && !significant) {
+				if (*p == '0') {
+					magnitude--;
+				} else {
+					significant = true;
+				}
+			}
+		}
+
+		if (p + 1 < end) {
+			auto expStart = p + 1;
+			if (*expStart == '+') expStart++;
+			int64_t exponent;
+			auto result = std::from_chars(expStart, end, exponent);
+			if (result.ec == std::errc::result_out_of_range) {
+				return *expStart != '-';
+			}
+
+			magnitude += exponent;
+		}
+
+		return magnitude > 0;
+	}
+
+	static bool DecodeHex(char const* p, uint32_t& value)
+	{
+		value = 0;
+		for (int i = 0; i < 4; i++) {
+			auto c = p[i];
+			value <<= 4;
+			if (c >= '0' && c <= '9') {
+				value |= c - '0';
+			} else if (c >= 'a' && c <= 'f') {
+				value |= c - 'a' + 10;
+			} else if (c >= 'A' && c <= 'F') {
+				value |= c - 'A' + 10;
+			} else {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void AppendUtf8(uint32_t cp)
+	{
+		if (cp < 0x80) {
+			scratch_ += (char)cp;
+		} else if (cp < 0x800) {
+			scratch_ += (char)(0xC0 | (cp >> 6));
+			scratch_ += (char)(0x80 | (cp & 0x3F));
+		} else if (cp < 0x10000) {
+			scratch_ += (char)(0xE0 | (cp >> 12));
+			scratch_ += (char)(0x80 | ((cp >> 6) & 0x3F));
+			scratch_ += (char)(0x80 | (cp & 0x3F));
+		} else {
+			scratch_ += (char)(0xF0 | (cp >> 18));
+			scratch_ += (char)(0x80 | ((cp >> 12) & 0x3F));
+			scratch_ += (char)(0x80 | ((cp >> 6) & 0x3F));
+			scratch_ += (char)(0x80 | (cp & 0x3F));
+		}
+	}
+
+	bool DecodeUnicodeEscape(uint32_t& cp)
+	{
+		// pos_ points to the 'u' of the escape sequence
+		if (end_ - pos_ < 5 || !DecodeHex(pos_ + 1, cp)) {
+			return Fail("Bad unicode escape sequence in string");
+		}
+		pos_ += 5;
+
+		if (cp >= 0xD800 && cp <= 0xDBFF) {
+			uint32_t low;
+			if (end_ - pos_ < 6 || pos_[0] != '\\' || pos_[1] != 'u' || !DecodeHex(pos_ + 2, low)
+				|| low < 0xDC00 || low > 0xDFFF) {
+				return Fail("Expecting another \\u token to begin the second half of a unicode surrogate pair");
+			}
+			pos_ += 6;
+			cp = 0x10000 + ((cp & 0x3FF) << 10) + (low & 0x3FF);
+		}
+
+		return true;
+	}
+
+	bool ParseString()
+	{
+		if (!CheckStack(1)) return false;
+
+		// Strings without escape sequences are pushed directly from the document
+		auto start = ++pos_;
+		while (pos_ < end_ && *pos_ != '"' && *pos_ != '\\') pos_++;
+		if (pos_ >= end_) {
+			return Fail("Missing '\"' at end of string");
+		}
+
+		if (*pos_ == '"') {
+			lua_pushlstring(L_, start, pos_ - start);
+			pos_++;
+			return true;
+		}
+
+		scratch_.assign(start, pos_);
+		while (pos_ < end_) {
+			auto c = *pos_;
+			if (c == '"') {
+				lua_pushlstring(L_, scratch_.data(), scratch_.size());
+				pos_++;
+				return true;
+			}
+
+			if (c != '\\') {
+				auto runStart = pos_;
+				while (pos_ < end_ && *pos_ != '"' && *pos_ != '\\') pos_++;
+				scratch_.append(runStart, pos_);
+				continue;
+			}
+
+			if (++pos_ >= end_) break;
+
+			switch (*pos_) {
+			case '"': scratch_ += '"'; break;
+			case '\\': scratch_ += '\\'; break;
+			case '/': scratch_ += '/'; break;
+			case 'b': scratch_ += '\b'; break;
+			case 'f': scratch_ += '\f'; break;
+			case 'n': scratch_ += '\n'; break;
+			case 'r': scratch_ += '\r'; break;
+			case 't': scratch_ += '\t'; break;
+			case 'u':
+			{
+				uint32_t cp;
+				if (!DecodeUnicodeEscape(cp)) return false;
+				AppendUtf8(cp);
+				continue;
+			}
+			default:
+				return Fail("Bad escape sequence in string");
+			}
+
+			pos_++;
+		}
+
+		return Fail("Missing '\"' at end of string");
+	}
+
+	// Moves the elements buffered on the stack to a new table created with the exact number of buffered elements
+	int CreateArray(int buffered)
+	{
+		lua_createtable(L_, buffered, 0);
+		lua_insert(L_, -(buffered + 1));
+		auto tableIdx = lua_gettop(L_) - buffered;
+		for (int i = buffered; i > 0; i--) {
+			lua_rawseti(L_, tableIdx, i);
+		}
+
+		return tableIdx;
+	}
+
+	// Moves the key/value pairs buffered on the stack to a new table; pairs are assigned in document order
+	// so the last value of a duplicate key is kept
+	bool CreateObject(int buffered, int& tableIdx)
+	{
+		if (!CheckStack(3)) return false;
+
+		auto base = lua_gettop(L_) - buffered * 2;
+		lua_createtable(L_, 0, buffered);
+		auto newTableIdx = lua_gettop(L_);
+		for (int i = 0; i < buffered; i++) {
+			lua_pushvalue(L_, base + i * 2 + 1);
+			lua_pushvalue(L_, base + i * 2 + 2);
+			lua_rawset(L_, newTableIdx);
+		}
+
+		lua_replace(L_, base + 1);
+		lua_settop(L_, base + 1);
+		tableIdx = base + 1;
+		return true;
+	}
+
+	bool ParseArray(unsigned depth)
+	{
+		if (depth > MaxDepth) {
+			return Fail("Exceeded stack limit while parsing JSON");
+		}
+
+		pos_++;
+		if (!SkipWhitespace()) return false;
+		if (pos_ < end_ && *pos_ == ']') {
+			if (!CheckStack(1)) return false;
+			lua_createtable(L_, 0, 0);
+			pos_++;
+			return true;
+		}
+
+		int buffered{ 0 };
+		int tableIdx{ 0 };
+		lua_Integer index{ 0 };
+		for (;;) {
+			if (!ParseValue(depth) || !SkipWhitespace()) return false;
+
+			if (tableIdx != 0) {
+				lua_rawseti(L_, tableIdx, ++index);
+			} else if (++buffered == MaxBufferedElements) {
+				tableIdx = CreateArray(buffered);
+				index = buffered;
+			}
+
+			if (pos_ >= end_) {
+				return Fail("Missing ',' or ']' in array declaration");
+			}
+
+			if (*pos_ == ']') {
+				pos_++;
+				break;
+			}
+
+			if (*pos_ != ',') {
+				return Fail("Missing ',' or ']' in array declaration");
+			}
+
+			pos_++;
+			if (!SkipWhitespace()) return false;
+		}
+
+		if (tableIdx == 0) {
+			CreateArray(buffered);
+		}
+
+		return true;
+	}
+
+	bool ParseObject(unsigned depth)
+	{
+		if (depth > MaxDepth) {
+			return Fail("Exceeded stack limit while parsing JSON");
+		}
+
+		pos_++;
+		if (!SkipWhitespace()) return false;
+		if (pos_ < end_ && *pos_ == '}') {
+			if (!CheckStack(1)) return false;
+			lua_createtable(L_, 0, 0);
+			pos_++;
+			return true;
+		}
+
+		int buffered{ 0 };
+		int tableIdx{ 0 };
+		for (;;) {
+			if (pos_ >= end_ || *pos_ != '"') {
+				return Fail("Missing '}' or object member name");
+			}
+
+			if (!ParseString() || !SkipWhitespace()) return false;
+
+			if (pos_ >= end_ || *pos_ != ':') {
+				return Fail("Missing ':' after object member name");
+			}
+
+			pos_++;
+			if (!SkipWhitespace() || !ParseValue(depth) || !SkipWhitespace()) return false;
+
+			if (tableIdx != 0) {
+				lua_rawset(L_, tableIdx);
+			} else if (++buffered == MaxBufferedElements) {
+				if (!CreateObject(buffered, tableIdx)) return false;
+			}
+
+			if (pos_ >= end_) {
+				return Fail("Missing ',' or '}' in object declaration");
+			}
+
+			if (*pos_ == '}') {
+				pos_++;
+				break;
+			}
+
+			if (*pos_ != ',') {
+				return Fail("Missing ',' or '}' in object declaration");
+			}
+
+			pos_++;
+			if (!SkipWhitespace()) return false;
+		}
+
+		if (tableIdx == 0) {
+			return CreateObject(buffered, tableIdx);
+		}
+
+		return true;
+	}
+};
+
+bool Parse(lua_State * L, StringView json, STDString& error)
+{
+	LuaJsonParser parser(L, json);
+	if (!parser.Parse()) {
+		error = parser.GetError();
+		return false;
+	}
+
+	return true;
+}
+
+bool Parse(lua_State * L, StringView json)
+{
+	STDString error;
+	if (!Parse(L, json, error)) {
+		ERR("Unable to parse JSON: %s", error.c_str());
+		return false;
+	}
+
+	return true;
+}
+
 UserReturn LuaParse(lua_State * L)
 {
 	StackCheck _(L, 1);
 	size_t length;
 	auto json = luaL_checklstring(L, 1, &length);
 
-	Json::CharReaderBuilder factory;
-	std::unique_ptr<Json::CharReader> reader(factory.newCharReader());
-
-	Json::Value root;
-	std::string errs;
-	if (!reader->parse(json, json + length, &root, &errs)) {
-		return luaL_error(L, "Unable to parse JSON: %s", errs.c_str());
+	STDString error;
+	if (!Parse(L, StringView(json, length), error)) {
+		return luaL_error(L, "Unable to parse JSON: %s", error.c_str());
 	}
 
-	Parse(L, root);
 	return 1;
 }
 
@@ -165,13 +662,8 @@ bool CheckForRecursion(lua_State* L, int index, StringifyContext& ctx)
 {
 	if (ctx.AvoidRecursion) {
 		auto ptr = GetPointerValue(L, index);
-		if (ptr) {
-			auto seenIt = ctx.SeenUserdata.find(ptr);
-			if (seenIt != ctx.SeenUserdata.end()) {
-				return true;
-			} else {
-				ctx.SeenUserdata.insert(ptr);
-			}
+		if (ptr && !ctx.SeenUserdata.Insert(ptr)) {
+			return true;
 		}
 	}
 
@@ -220,6 +712,30 @@ bool IsMapOrArrayLikeUserdata(lua_State* L, int index)
 
 Json::Value Stringify(lua_State * L, int index, unsigned depth, StringifyContext& ctx);
 
+// Converts arrays and sets to a Lua table in one pass instead of calling __next for each element
+Json::Value StringifyArrayUserdata(lua_State * L, int index, unsigned depth, StringifyContext& ctx)
+{
+	StackCheck _(L, 0);
+	CppObjectMetadata meta;
+	lua_get_cppobject(L, index, meta);
+	if (!meta.Lifetime.IsAlive(L)) {
+		luaL_error(L, "Attempted to iterate container whose lifetime has expired");
+	}
+
+	ContainerProxyHelpers::ToTable(L, meta, 1);
+
+	Json::Value arr(Json::arrayValue);
+	auto size = (int)lua_rawlen(L, -1);
+	for (int i = 1; i <= size; i++) {
+		lua_rawgeti(L, -1, i);
+		arr.append(Stringify(L, -1, depth + 1, ctx));
+		lua_pop(L, 1);
+	}
+
+	lua_pop(L, 1);
+	return arr;
+}
+
 Json::Value StringifyUserdata(lua_State * L, int index, unsigned depth, StringifyContext& ctx)
 {
 	StackCheck _(L, 0);
@@ -230,6 +746,10 @@ Json::Value StringifyUserdata(lua_State * L, int index, unsigned depth, Stringif
 		return Json::Value("*RECURSION*");
 	}
 
+	if (ctx.LimitArrayElements == -1 && IsArrayLikeUserdata(L, index)) {
+		return StringifyArrayUserdata(L, index, depth, ctx);
+	}
+
 	Json::Value arr;
 	if (IsArrayLikeUserdata(L, index)) {
 		arr = Json::Value(Json::arrayValue);
@@ -509,7 +1029,9 @@ Json::Value Stringify(lua_State * L, int index, unsigned depth, StringifyContext
 }
 
 
-std::string Stringify(lua_State * L, StringifyContext& ctx, int index)
+// Stringifies into a jsoncpp DOM and serializes it afterwards.
+// Only used for comparing against the streaming writer.
+std::string StringifyWithJsonCpp(lua_State * L, StringifyContext& ctx, int index)
 {
 	StackCheck _(L);
 
@@ -517,9 +1039,7 @@ std::string Stringify(lua_State * L, StringifyContext& ctx, int index)
 	root = Stringify(L, index, 0, ctx);
 
 	Json::StreamWriterBuilder builder;
-	if (ctx.Beautify) {
-		builder["indentation"] = "\t";
-	}
+	builder["indentation"] = ctx.Beautify ? "\t" : "";
 	std::stringstream ss;
 	std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
 	writer->write(root, &ss);
@@ -527,6 +1047,614 @@ std::string Stringify(lua_State * L, StringifyContext& ctx, int index)
 	return ss.str();
 }
 
+// Streaming JSON writer that emits JSON while walking the Lua value, without building a jsoncpp DOM first.
+// The output is identical to that of the jsoncpp StreamWriter (object members are sorted by name,
+// nested containers in objects start on a new line, the last value of a duplicate member name is kept).
+class LuaJsonWriter
+{
+public:
+	LuaJsonWriter(lua_State* L, StringifyContext& ctx)
+		: L_(L), ctx_(ctx)
+	{}
+
+	std::string Write(int index)
+	{
+		indented_ = true;
+		WriteValue(lua_absindex(L_, index), 0);
+		return std::move(out_);
+	}
+
+private:
+	struct Member
+	{
+		// Location of the unescaped member name in keys_
+		std::size_t KeyOffset;
+		std::size_t KeyLength;
+		// Location of the member in the output (without the separating comma)
+		std::size_t Start;
+		std::size_t End;
+	};
+
+	struct Container
+	{
+		// Output size and indentation state before the container was opened
+		std::size_t Start;
+		bool Indented;
+		std::size_t MemberBase;
+		std::size_t KeyBase;
+		uint32_t NumElements{ 0 };
+	};
+
+	lua_State* L_;
+	StringifyContext& ctx_;
+	std::string out_;
+	bool indented_{ true };
+	unsigned indent_{ 0 };
+	// Members of the objects currently being written; nested objects are appended after the members of their parent
+	std::vector<Member> members_;
+	std::string keys_;
+	// Buffer for reordering object members
+	std::string reorder_;
+
+	void WriteIndent()
+	{
+		if (ctx_.Beautify) {
+			out_ += '\n';
+			out_.append(indent_, '\t');
+		}
+	}
+
+	void WriteWithIndent(char c)
+	{
+		if (!indented_) WriteIndent();
+		out_ += c;
+		indented_ = false;
+	}
+
+	void WriteInteger(int64_t value)
+	{
+		char buf[32];
+		auto result = std::to_chars(buf, buf + sizeof(buf), value);
+		out_.append(buf, result.ptr);
+	}
+
+	void WriteNumber(double value)
+	{
+		if (!std::isfinite(value)) {
+			out_ += std::isnan(value) ? "null" : (value < 0 ? "-1e+9999" : "1e+9999");
+			return;
+		}
+
+		char buf[32];
+		auto result = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::general, 17);
+		std::string_view num(buf, result.ptr - buf);
+		out_ += num;
+		// Keep the value a real number when reading it back
+		if (num.find_first_of(".e") == std::string_view::npos) {
+			out_ += ".0";
+		}
+	}
+
+	void WriteHexEscape(uint32_t cp)
+	{
+		static constexpr char HexDigits[] = "0123456789abcdef";
+		char buf[6] = { '\\', 'u', HexDigits[(cp >> 12) & 0xF], HexDigits[(cp >> 8) & 0xF], HexDigits[(cp >> 4) & 0xF], HexDigits[cp & 0xF] };
+		out_.append(buf, sizeof(buf));
+	}
+
+	// Decodes the UTF-8 sequence at p and advances p to its last byte; invalid sequences are replaced with U+FFFD
+	static uint32_t DecodeUtf8(char const*& p, char const* end)
+	{
+		static constexpr uint32_t ReplacementCharacter = 0xFFFD;
+		auto s = reinterpret_cast<uint8_t const*>(p);
+		uint32_t first = s[0];
+		if (first < 0xE0) {
+			if (end - p < 2) return ReplacementCharacter;
+			uint32_t cp = ((first & 0x1F) << 6) | (s[1] & 0x3F);
+			p += 1;
+			return cp < 0x80 ? ReplacementCharacter : cp;
+		}
+
+		if (first < 0xF0) {
+			if (end - p < 3) return ReplacementCharacter;
+			uint32_t cp = ((first & 0x0F) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+			p += 2;
+			return (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF)) ? ReplacementCharacter : cp;
+		}
+
+		if (first < 0xF8) {
+			if (end - p < 4) return ReplacementCharacter;
+			uint32_t cp = ((first & 0x07) << 18) | ((s[1] & 0x3F) << 12) | ((s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+			p += 3;
+			return cp < 0x10000 ? ReplacementCharacter : cp;
+		}
+
+		return ReplacementCharacter;
+	}
+
+	// Writes a quoted string; control and non-ASCII characters are written as \u escapes
+	void WriteString(std::string_view str)
+	{
+		out_ += '"';
+		auto p = str.data();
+		auto end = p + str.size();
+		while (p < end) {
+			auto run = p;
+			while (p < end && (uint8_t)*p >= 0x20 && (uint8_t)*p < 0x80 && *p != '"' && *p != '\\') p++;
+			out_.append(run, p);
+			if (p >= end) break;
+
+			switch (*p) {
+			case '"': out_ += "\\\""; break;
+			case '\\': out_ += "\\\\"; break;
+			case '\b': out_ += "\\b"; break;
+			case '\f': out_ += "\\f"; break;
+			case '\n': out_ += "\\n"; break;
+			case '\r': out_ += "\\r"; break;
+			case '\t': out_ += "\\t"; break;
+			default:
+			{
+				auto cp = (uint8_t)*p < 0x80 ? (uint8_t)*p : DecodeUtf8(p, end);
+				if (cp < 0x10000) {
+					WriteHexEscape(cp);
+				} else {
+					cp -= 0x10000;
+					WriteHexEscape(0xD800 + ((cp >> 10) & 0x3FF));
+					WriteHexEscape(0xDC00 + (cp & 0x3FF));
+				}
+				break;
+			}
+			}
+
+			p++;
+		}
+		out_ += '"';
+	}
+
+	Container BeginContainer(char open)
+	{
+		Container container{ out_.size(), indented_, members_.size(), keys_.size() };
+		WriteWithIndent(open);
+		indent_++;
+		return container;
+	}
+
+	void BeginArrayElement(Container& container)
+	{
+		if (container.NumElements++ > 0) out_ += ',';
+		if (!indented_) WriteIndent();
+		indented_ = true;
+	}
+
+	void EndArrayElement()
+	{
+		indented_ = false;
+	}
+
+	void EndArray(Container& container)
+	{
+		indent_--;
+		if (container.NumElements == 0) {
+			out_.resize(container.Start);
+			indented_ = container.Indented;
+			out_ += "[]";
+		} else {
+			WriteWithIndent(']');
+		}
+	}
+
+	// Writes the name of an object member; the value must be written immediately after
+	std::size_t BeginMember(Container& container, std::string_view name)
+	{
+		if (container.NumElements++ > 0) out_ += ',';
+		members_.push_back(Member{ keys_.size(), name.size(), out_.size(), 0 });
+		keys_ += name;
+
+		if (!indented_) WriteIndent();
+		WriteString(name);
+		indented_ = false;
+		out_ += ctx_.Beautify ? " : " : ":";
+		return members_.size() - 1;
+	}
+
+	void EndMember(std::size_t member)
+	{
+		members_[member].End = out_.size();
+	}
+
+	std::string_view GetMemberName(Member const& member) const
+	{
+		return std::string_view(keys_.data() + member.KeyOffset, member.KeyLength);
+	}
+
+	// Rewrites the members of the object in name order
+	void SortMembers(Container& container)
+	{
+		auto begin = members_.begin() + container.MemberBase;
+		auto end = members_.end();
+		auto regionStart = begin->Start;
+
+		auto less = [this](Member const& a, Member const& b) {
+			return GetMemberName(a) < GetMemberName(b);
+		};
+
+		// Strictly ascending names need no reordering
+		if (std::adjacent_find(begin, end, [&](Member const& a, Member const& b) { return !less(a, b); }) == end) {
+			return;
+		}
+
+		std::stable_sort(begin, end, less);
+		reorder_.assign(out_, regionStart, std::string::npos);
+		out_.resize(regionStart);
+
+		bool first{ true };
+		for (auto it = begin; it != end; ++it) {
+			// Duplicate names keep the member that was written last
+			if (it + 1 != end && GetMemberName(*it) == GetMemberName(*(it + 1))) continue;
+
+			if (!first) out_ += ',';
+			first = false;
+			out_.append(reorder_, it->Start - regionStart, it->End - it->Start);
+		}
+	}
+
+	void EndObject(Container& container)
+	{
+		indent_--;
+		if (members_.size() == container.MemberBase) {
+			out_.resize(container.Start);
+			indented_ = container.Indented;
+			out_ += "{}";
+		} else {
+			SortMembers(container);
+			members_.resize(container.MemberBase);
+			keys_.resize(container.KeyBase);
+			WriteWithIndent('}');
+		}
+	}
+
+	// Writes the member name for the key at keyIndex; returns false if the member should be skipped
+	bool WriteMemberKey(Container& container, int keyIndex, bool allowInternalTypes, std::size_t& member)
+	{
+		switch (lua_type(L_, keyIndex)) {
+		case LUA_TSTRING:
+		{
+			size_t len;
+			auto key = lua_tolstring(L_, keyIndex, &len);
+			member = BeginMember(container, std::string_view(key, len));
+			return true;
+		}
+
+		case LUA_TNUMBER:
+		{
+			// Convert a copy of the key, as lua_tolstring() would confuse lua_next()
+			lua_pushvalue(L_, keyIndex);
+			size_t len;
+			auto key = lua_tolstring(L_, -1, &len);
+			member = BeginMember(container, std::string_view(key, len));
+			lua_pop(L_, 1);
+			return true;
+		}
+
+		case LUA_TLIGHTCPPOBJECT:
+		case LUA_TCPPOBJECT:
+			if (allowInternalTypes) {
+				lua_getglobal(L_, "tostring");
+				lua_pushvalue(L_, keyIndex);
+				lua_call(L_, 1, 1);
+				size_t len;
+				auto key = lua_tolstring(L_, -1, &len);
+				if (key) {
+					member = BeginMember(container, std::string_view(key, len));
+				}
+				lua_pop(L_, 1);
+				return key != nullptr;
+			}
+			break;
+
+		case LUA_TLIGHTUSERDATA:
+			if (allowInternalTypes) {
+				auto handle = get<EntityHandle>(L_, keyIndex);
+				char key[100];
+				sprintf_s(key, "%016llx", handle.Handle);
+				member = BeginMember(container, key);
+				return true;
+			}
+			break;
+		}
+
+		throw std::runtime_error("Can only stringify string or number table keys");
+	}
+
+	void WriteJsonValue(Json::Value const& val)
+	{
+		switch (val.type()) {
+		case Json::stringValue:
+			WriteString(val.asCString());
+			break;
+
+		case Json::arrayValue:
+		{
+			auto container = BeginContainer('[');
+			for (auto const& element : val) {
+				BeginArrayElement(container);
+				WriteJsonValue(element);
+				EndArrayElement();
+			}
+			EndArray(container);
+			break;
+		}
+
+		default:
+			throw std::runtime_error("Attempted to stringify an unsupported JSON value");
+		}
+	}
+
+	void WriteInternalType(int index)
+	{
+		if (!ctx_.StringifyInternalTypes) {
+			throw std::runtime_error("Attempted to stringify a lightuserdata, userdata, function or thread value");
+		}
+
+		size_t len;
+		auto str = luaL_tolstring(L_, index, &len);
+		WriteString(std::string_view(str, len));
+		lua_pop(L_, 1);
+	}
+
+	void WriteTable(int index, unsigned depth)
+	{
+		if (CheckForRecursion(L_, index, ctx_)) {
+			WriteString("*RECURSION*");
+			return;
+		}
+
+		if (JsonCanStringifyAsArray(L_, index)) {
+			auto container = BeginContainer('[');
+			lua_pushnil(L_);
+			while (lua_next(L_, index) != 0) {
+				BeginArrayElement(container);
+				WriteValue(lua_gettop(L_), depth + 1);
+				EndArrayElement();
+				lua_pop(L_, 1);
+			}
+			EndArray(container);
+		} else {
+			auto container = BeginContainer('{');
+			lua_pushnil(L_);
+			while (lua_next(L_, index) != 0) {
+				std::size_t member;
+				WriteMemberKey(container, -2, false, member);
+				WriteValue(lua_gettop(L_), depth + 1);
+				EndMember(member);
+				lua_pop(L_, 1);
+			}
+			EndObject(container);
+		}
+	}
+
+	// Converts arrays and sets to a Lua table in one pass instead of calling __next for each element
+	void WriteArrayUserdata(int index, unsigned depth)
+	{
+		StackCheck _(L_, 0);
+		CppObjectMetadata meta;
+		lua_get_cppobject(L_, index, meta);
+		if (!meta.Lifetime.IsAlive(L_)) {
+			luaL_error(L_, "Attempted to iterate container whose lifetime has expired");
+		}
+
+		ContainerProxyHelpers::ToTable(L_, meta, 1);
+
+		auto container = BeginContainer('[');
+		auto size = (int)lua_rawlen(L_, -1);
+		for (int i = 1; i <= size; i++) {
+			lua_rawgeti(L_, -1, i);
+			BeginArrayElement(container);
+			WriteValue(lua_gettop(L_), depth + 1);
+			EndArrayElement();
+			lua_pop(L_, 1);
+		}
+		EndArray(container);
+
+		lua_pop(L_, 1);
+	}
+
+	// Writes the userdata by iterating it with __pairs; returns false if the userdata has no __pairs metamethod
+	bool WriteIterableUserdata(int index, unsigned depth)
+	{
+		StackCheck _(L_, 0);
+
+		if (CheckForRecursion(L_, index, ctx_)) {
+			WriteString("*RECURSION*");
+			return true;
+		}
+
+		if (ctx_.LimitArrayElements == -1 && IsArrayLikeUserdata(L_, index)) {
+			WriteArrayUserdata(index, depth);
+			return true;
+		}
+
+		bool isArray = IsArrayLikeUserdata(L_, index);
+		bool isMapOrArray = IsMapOrArrayLikeUserdata(L_, index);
+
+		if (!TryGetUserdataPairs(L_, index)) {
+			return false;
+		}
+
+		// Call __pairs(obj)
+		auto nextIndex = lua_absindex(L_, -1);
+		lua_pushvalue(L_, index);
+		lua_call(L_, 1, 3); // returns __next, obj, nil
+
+		// Push next, obj, k
+		lua_pushvalue(L_, nextIndex);
+		lua_pushvalue(L_, nextIndex + 1);
+		lua_pushvalue(L_, nextIndex + 2);
+		// Call __next(obj, k)
+		lua_call(L_, 2, 2); // returns k, val
+
+		auto container = BeginContainer(isArray ? '[' : '{');
+		lua_Integer nextArrayIndex{ 1 };
+		int numElements{ 0 };
+		while (lua_type(L_, -2) != LUA_TNIL) {
+			if (isMapOrArray && ctx_.LimitArrayElements != -1 && numElements > ctx_.LimitArrayElements) {
+				break;
+			}
+
+			if (isArray) {
+				if (lua_type(L_, -2) != LUA_TNUMBER) {
+					throw std::runtime_error("Can only stringify number keys of array-like userdata");
+				}
+
+				// Fill gaps with nulls, same as assigning past the end of a jsoncpp array
+				auto key = lua_tointeger(L_, -2);
+				for (; nextArrayIndex < key; nextArrayIndex++) {
+					BeginArrayElement(container);
+					out_ += "null";
+					EndArrayElement();
+				}
+
+				BeginArrayElement(container);
+				WriteValue(lua_gettop(L_), depth + 1);
+				EndArrayElement();
+				nextArrayIndex = std::max(nextArrayIndex, key + 1);
+			} else {
+				std::size_t member;
+				if (WriteMemberKey(container, -2, ctx_.StringifyInternalTypes, member)) {
+					WriteValue(lua_gettop(L_), depth + 1);
+					EndMember(member);
+				}
+			}
+
+			// Push next, obj, k
+			lua_pushvalue(L_, nextIndex);
+			lua_pushvalue(L_, nextIndex + 1);
+			lua_pushvalue(L_, nextIndex + 3);
+			lua_remove(L_, -4);
+			lua_remove(L_, -4);
+			// Call __next(obj, k)
+			lua_call(L_, 2, 2); // returns k, val
+			numElements++;
+		}
+
+		if (isArray) {
+			EndArray(container);
+		} else {
+			EndObject(container);
+		}
+
+		lua_pop(L_, 2);
+
+		// Pop __next, obj, nil
+		lua_pop(L_, 3);
+		return true;
+	}
+
+	void WriteUserdata(int index, unsigned depth)
+	{
+		CppValueMetadata meta;
+		if (lua_try_get_cppvalue(L_, index, EnumValueMetatable::MetaTag, meta)) {
+			WriteString(EnumValueMetatable::GetLabel(meta).GetStringView());
+			return;
+		}
+
+		if (lua_try_get_cppvalue(L_, index, BitfieldValueMetatable::MetaTag, meta)) {
+			WriteJsonValue(BitfieldValueMetatable::ToJson(meta));
+			return;
+		}
+
+		if (ctx_.IterateUserdata) {
+			if (ctx_.LimitDepth != -1 && depth > (uint32_t)ctx_.LimitDepth) {
+				WriteString("*DEPTH LIMIT EXCEEDED*");
+				return;
+			}
+
+			if (WriteIterableUserdata(index, depth)) {
+				return;
+			}
+		}
+
+		WriteInternalType(index);
+	}
+
+	void WriteValue(int index, unsigned depth)
+	{
+		if (depth > ctx_.MaxDepth) {
+			throw std::runtime_error("Recursion depth exceeded while stringifying JSON");
+		}
+
+		switch (lua_type(L_, index)) {
+		case LUA_TNIL:
+			out_ += "null";
+			break;
+
+		case LUA_TBOOLEAN:
+			out_ += lua_toboolean(L_, index) ? "true" : "false";
+			break;
+
+		case LUA_TNUMBER:
+			if (lua_isinteger(L_, index)) {
+				WriteInteger(lua_tointeger(L_, index));
+			} else {
+				WriteNumber(lua_tonumber(L_, index));
+			}
+			break;
+
+		case LUA_TSTRING:
+		{
+			size_t len;
+			auto str = lua_tolstring(L_, index, &len);
+			WriteString(std::string_view(str, len));
+			break;
+		}
+
+		case LUA_TTABLE:
+			if (ctx_.LimitDepth != -1 && depth > (uint32_t)ctx_.LimitDepth) {
+				WriteString("*DEPTH LIMIT EXCEEDED*");
+			} else {
+				WriteTable(index, depth);
+			}
+			break;
+
+		case LUA_TLIGHTCPPOBJECT:
+		case LUA_TCPPOBJECT:
+			WriteUserdata(index, depth);
+			break;
+
+		case LUA_TLIGHTUSERDATA:
+		case LUA_TFUNCTION:
+		case LUA_TTHREAD:
+			WriteInternalType(index);
+			break;
+
+		default:
+			throw std::runtime_error("Attempted to stringify an unknown type");
+		}
+	}
+};
+
+std::string Stringify(lua_State * L, StringifyContext& ctx, int index)
+{
+	StackCheck _(L);
+	LuaJsonWriter writer(L, ctx);
+	return writer.Write(index);
+}
+
+void GetStringifyOptions(lua_State * L, int index, StringifyContext& ctx)
+{
+	ctx.Beautify = try_gettable<bool>(L, "Beautify", index, true);
+	ctx.StringifyInternalTypes = try_gettable<bool>(L, "StringifyInternalTypes", index, false);
+	ctx.IterateUserdata = try_gettable<bool>(L, "IterateUserdata", index, false);
+	ctx.AvoidRecursion = try_gettable<bool>(L, "AvoidRecursion", index, false);
+	ctx.MaxDepth = try_gettable<uint32_t>(L, "MaxDepth", index, 64);
+	ctx.LimitDepth = try_gettable<int32_t>(L, "LimitDepth", index, -1);
+	ctx.LimitArrayElements = try_gettable<int32_t>(L, "LimitArrayElements", index, -1);
+
+	if (ctx.MaxDepth > 64) {
+		ctx.MaxDepth = 64;
+	}
+}
+
 UserReturn LuaStringify(lua_State * L)
 {
 	StackCheck _(L, 1);
@@ -544,17 +1672,7 @@ UserReturn LuaStringify(lua_State * L)
 	if (nargs >= 2) {
 		// New stringify API - Json.Stringify(obj, paramTable)
 		if (lua_type(L, 2) == LUA_TTABLE) {
-			ctx.Beautify = try_gettable<bool>(L, "Beautify", 2, true);
-			ctx.StringifyInternalTypes = try_gettable<bool>(L, "StringifyInternalTypes", 2, false);
-			ctx.IterateUserdata = try_gettable<bool>(L, "IterateUserdata", 2, false);
-			ctx.AvoidRecursion = try_gettable<bool>(L, "AvoidRecursion", 2, false);
-			ctx.MaxDepth = try_gettable<uint32_t>(L, "MaxDepth", 2, 64);
-			ctx.LimitDepth = try_gettable<int32_t>(L, "LimitDepth", 2, -1);
-			ctx.LimitArrayElements = try_gettable<int32_t>(L, "LimitArrayElements", 2, -1);
-
-			if (ctx.MaxDepth > 64) {
-				ctx.MaxDepth = 64;
-			}
+			GetStringifyOptions(L, 2, ctx);
 		} else {
 			// Old stringify API - Json.Stringify(obj, beautify, stringifyInternalTypes, iterateUserdata)
 			ctx.Beautify = lua_toboolean(L, 2) == 1;
@@ -573,6 +1691,7 @@ UserReturn LuaStringify(lua_State * L)
 	try {
 		push(L, Stringify(L, ctx, 1));
 	} catch (std::runtime_error& e) {
+		EnablePropertyWarnings();
 		return luaL_error(L, "%s", e.what());
 	}
 	EnablePropertyWarnings();
@@ -40,6 +40,10 @@ TypeInformation DoConstructFunctionSignature(Fun f)
 	mod.Table = FixedString{#name}; \
 	mod.SubTable = FixedString{#sub};
 
+// Module that is only instantiated in developer mode
+#define DECLARE_DEVELOPER_MODULE(name, role) DECLARE_MODULE(name, role) \
+	mod.DeveloperOnly = true;
+
 #define BEGIN_MODULE() mod.Functions = {
 #define MODULE_FUNCTION(fun) { FixedString{#fun}, LuaWrapFunction(&fun), DoConstructFunctionSignature(&fun) },
 #define MODULE_NAMED_FUNCTION(name, fun){ FixedString{name}, LuaWrapFunction(&fun), DoConstructFunctionSignature(&fun) },
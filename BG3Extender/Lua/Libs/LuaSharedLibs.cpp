@@ -4,12 +4,14 @@
 #include <Lua/Shared/LuaMethodCallHelpers.h>
 #include <Lua/Osiris/FunctionProxy.h>
 #include <Lua/Libs/Debug.inl>
+#include <Lua/Libs/DevTests.inl>
 #include <Lua/Libs/Entity.inl>
 #include <Lua/Libs/IO.inl>
 #include <Lua/Libs/Json.inl>
 #include <Lua/Libs/Localization.inl>
 #include <Lua/Libs/Math.inl>
 #include <Lua/Libs/Mod.inl>
+#include <Lua/Libs/MsgPack.inl>
 #include <Lua/Libs/StatAttributes.inl>
 #include <Lua/Libs/StatMisc.inl>
 #include <Lua/Libs/Stats.inl>
@@ -94,7 +96,9 @@ void RegisterSharedLibraries()
 	loca::RegisterLocalizationLib();
 	math::RegisterMathLib();
 	mod::RegisterModLib();
+	msgpack::RegisterMsgPackLib();
 	debug::RegisterDebugLib();
+	devtests::RegisterDevTestsLib();
 	stats::RegisterStatsLib();
 	res::RegisterStaticDataLib();
 	vars::RegisterVarsLib();
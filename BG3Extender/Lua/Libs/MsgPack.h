@@ -0,0 +1,14 @@
+#pragma once
+
+#include <Lua/Libs/Json.h>
+
+BEGIN_NS(lua::msgpack)
+
+// Encodes the Lua value at the specified stack index in MessagePack format.
+// Accepts the same values and options as json::Stringify (Beautify is ignored); throws std::runtime_error on failure.
+std::string Pack(lua_State* L, json::StringifyContext& ctx, int index);
+// Decodes a MessagePack value and pushes it to the Lua stack; nothing is pushed if decoding fails
+bool Unpack(lua_State* L, StringView data, STDString& error);
+bool Unpack(lua_State* L, StringView data);
+
+END_NS()
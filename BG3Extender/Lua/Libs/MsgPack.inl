@@ -0,0 +1,773 @@
+#include <Lua/Libs/MsgPack.h>
+
+#include <bit>
+#include <cfloat>
+
+/// <lua_module>MsgPack</lua_module>
+BEGIN_NS(lua::msgpack)
+
+// Encodes Lua values in MessagePack format. Tables with the keys 1..n are encoded as arrays, other tables as maps;
+// integer and float keys are kept as numbers. Userdata is handled the same way as in json::Stringify.
+class LuaMsgPackWriter
+{
+public:
+	LuaMsgPackWriter(lua_State* L, json::StringifyContext& ctx)
+		: L_(L), ctx_(ctx)
+	{}
+
+	std::string Write(int index)
+	{
+		WriteValue(lua_absindex(L_, index), 0);
+		return std::move(out_);
+	}
+
+private:
+	lua_State* L_;
+	json::StringifyContext& ctx_;
+	std::string out_;
+
+	inline void WriteByte(uint8_t value)
+	{
+		out_ += (char)value;
+	}
+
+	template <class T>
+	void WriteBigEndian(T value)
+	{
+		char buf[sizeof(T)];
+		for (std::size_t i = 0; i < sizeof(T); i++) {
+			buf[i] = (char)(value >> (8 * (sizeof(T) - 1 - i)));
+		}
+		out_.append(buf, sizeof(T));
+	}
+
+	void WriteInteger(int64_t value)
+	{
+		if (value >= 0) {
+			if (value < 0x80) {
+				WriteByte((uint8_t)value);
+			} else if (value <= 0xFF) {
+				WriteByte(0xcc);
+				WriteByte((uint8_t)value);
+			} else if (value <= 0xFFFF) {
+				WriteByte(0xcd);
+				WriteBigEndian((uint16_t)value);
+			} else if (value <= 0xFFFFFFFFll) {
+				WriteByte(0xce);
+				WriteBigEndian((uint32_t)value);
+			} else {
+				WriteByte(0xcf);
+				WriteBigEndian((uint64_t)value);
+			}
+		} else {
+			if (value >= -32) {
+				WriteByte((uint8_t)(int8_t)value);
+			} else if (value >= INT8_MIN) {
+				WriteByte(0xd0);
+				WriteByte((uint8_t)(int8_t)value);
+			} else if (value >= INT16_MIN) {
+				WriteByte(0xd1);
+				WriteBigEndian((uint16_t)(int16_t)value);
+			} else if (value >= INT32_MIN) {
+				WriteByte(0xd2);
+				WriteBigEndian((uint32_t)(int32_t)value);
+			} else {
+				WriteByte(0xd3);
+				WriteBigEndian((uint64_t)value);
+			}
+		}
+	}
+
+	void WriteNumber(double value)
+	{
+		// Use single precision if it doesn't lose information
+		if (std::abs(value) <= FLT_MAX && (double)(float)value == value) {
+			WriteByte(0xca);
+			WriteBigEndian(std::bit_cast<uint32_t>((float)value));
+		} else {
+			WriteByte(0xcb);
+			WriteBigEndian(std::bit_cast<uint64_t>(value));
+		}
+	}
+
+	void WriteString(std::string_view str)
+	{
+		auto size = str.size();
+		if (size < 32) {
+			WriteByte(0xa0 | (uint8_t)size);
+		} else if (size <= 0xFF) {
+			WriteByte(0xd9);
+			WriteByte((uint8_t)size);
+		} else if (size <= 0xFFFF) {
+			WriteByte(0xda);
+			WriteBigEndian((uint16_t)size);
+		} else if (size <= 0xFFFFFFFFull) {
+			WriteByte(0xdb);
+			WriteBigEndian((uint32_t)size);
+		} else {
+			throw std::runtime_error("String too long to pack");
+		}
+
+		out_ += str;
+	}
+
+	void WriteArrayHeader(uint32_t size)
+	{
+		if (size < 16) {
+			WriteByte(0x90 | (uint8_t)size);
+		} else if (size <= 0xFFFF) {
+			WriteByte(0xdc);
+			WriteBigEndian((uint16_t)size);
+		} else {
+			WriteByte(0xdd);
+			WriteBigEndian(size);
+		}
+	}
+
+	void WriteMapHeader(uint32_t size)
+	{
+		if (size < 16) {
+			WriteByte(0x80 | (uint8_t)size);
+		} else if (size <= 0xFFFF) {
+			WriteByte(0xde);
+			WriteBigEndian((uint16_t)size);
+		} else {
+			WriteByte(0xdf);
+			WriteBigEndian(size);
+		}
+	}
+
+	// Writes a 32-bit array or map header whose size is filled in later by PatchSize()
+	std::size_t WritePatchableHeader(bool isArray)
+	{
+		WriteByte(isArray ? 0xdd : 0xdf);
+		auto offset = out_.size();
+		WriteBigEndian((uint32_t)0);
+		return offset;
+	}
+
+	void PatchSize(std::size_t offset, uint32_t size)
+	{
+		for (std::size_t i = 0; i < 4; i++) {
+			out_[offset + i] = (char)(size >> (8 * (3 - i)));
+		}
+	}
+
+	// Returns the number of elements in the table and whether its keys are the sequence 1..n
+	uint32_t CountTable(int index, bool& isArray)
+	{
+		uint32_t count{ 0 };
+		isArray = true;
+		lua_pushnil(L_);
+		while (lua_next(L_, index) != 0) {
+			count++;
+			if (isArray && (!lua_isinteger(L_, -2) || lua_tointeger(L_, -2) != count)) {
+				isArray = false;
+			}
+			lua_pop(L_, 1);
+		}
+
+		return count;
+	}
+
+	// Writes the map key at keyIndex; returns false if the member should be skipped
+	bool WriteKey(int keyIndex, bool allowInternalTypes)
+	{
+		switch (lua_type(L_, keyIndex)) {
+		case LUA_TSTRING:
+		{
+			size_t len;
+			auto key = lua_tolstring(L_, keyIndex, &len);
+			WriteString(std::string_view(key, len));
+			return true;
+		}
+
+		case LUA_TNUMBER:
+			if (lua_isinteger(L_, keyIndex)) {
+				WriteInteger(lua_tointeger(L_, keyIndex));
+			} else {
+				WriteNumber(lua_tonumber(L_, keyIndex));
+			}
+			return true;
+
+		case LUA_TLIGHTCPPOBJECT:
+		case LUA_TCPPOBJECT:
+			if (allowInternalTypes) {
+				lua_getglobal(L_, "tostring");
+				lua_pushvalue(L_, keyIndex);
+				lua_call(L_, 1, 1);
+				size_t len;
+				auto key = lua_tolstring(L_, -1, &len);
+				if (key) {
+					WriteString(std::string_view(key, len));
+				}
+				lua_pop(L_, 1);
+				return key != nullptr;
+			}
+			break;
+
+		case LUA_TLIGHTUSERDATA:
+			if (allowInternalTypes) {
+				auto handle = get<EntityHandle>(L_, keyIndex);
+				char key[100];
+				sprintf_s(key, "%016llx", handle.Handle);
+				WriteString(key);
+				return true;
+			}
+			break;
+		}
+
+		throw std::runtime_error("Can only pack string or number table keys");
+	}
+
+	void WriteInternalType(int index)
+	{
+		if (!ctx_.StringifyInternalTypes) {
+			throw std::runtime_error("Attempted to pack a lightuserdata, userdata, function or thread value");
+		}
+
+		size_t len;
+		auto str = luaL_tolstring(L_, index, &len);
+		WriteString(std::string_view(str, len));
+		lua_pop(L_, 1);
+	}
+
+	void WriteTable(int index, unsigned depth)
+	{
+		if (json::CheckForRecursion(L_, index, ctx_)) {
+			WriteString("*RECURSION*");
+			return;
+		}
+
+		bool isArray;
+		auto size = CountTable(index, isArray);
+		if (isArray) {
+			WriteArrayHeader(size);
+			lua_pushnil(L_);
+			while (lua_next(L_, index) != 0) {
+				WriteValue(lua_gettop(L_), depth + 1);
+				lua_pop(L_, 1);
+			}
+		} else {
+			WriteMapHeader(size);
+			lua_pushnil(L_);
+			while (lua_next(L_, index) != 0) {
+				WriteKey(-2, false);
+				WriteValue(lua_gettop(L_), depth + 1);
+				lua_pop(L_, 1);
+			}
+		}
+	}
+
+	// Converts arrays and sets to a Lua table in one pass instead of calling __next for each element
+	void WriteArrayUserdata(int index, unsigned depth)
+	{
+		StackCheck _(L_, 0);
+		CppObjectMetadata meta;
+		lua_get_cppobject(L_, index, meta);
+		if (!meta.Lifetime.IsAlive(L_)) {
+			luaL_error(L_, "Attempted to iterate container whose lifetime has expired");
+		}
+
+		ContainerProxyHelpers::ToTable(L_, meta, 1);
+
+		auto size = (int)lua_rawlen(L_, -1);
+		WriteArrayHeader((uint32_t)size);
+		for (int i = 1; i <= size; i++) {
+			lua_rawgeti(L_, -1, i);
+			WriteValue(lua_gettop(L_), depth + 1);
+			lua_pop(L_, 1);
+		}
+
+		lua_pop(L_, 1);
+	}
+
+	// Writes the userdata by iterating it with __pairs; returns false if the userdata has no __pairs metamethod
+	bool WriteIterableUserdata(int index, unsigned depth)
+	{
+		StackCheck _(L_, 0);
+
+		if (json::CheckForRecursion(L_, index, ctx_)) {
+			WriteString("*RECURSION*");
+			return true;
+		}
+
+		if (ctx_.LimitArrayElements == -1 && json::IsArrayLikeUserdata(L_, index)) {
+			WriteArrayUserdata(index, depth);
+			return true;
+		}
+
+		bool isArray = json::IsArrayLikeUserdata(L_, index);
+		bool isMapOrArray = json::IsMapOrArrayLikeUserdata(L_, index);
+
+		if (!json::TryGetUserdataPairs(L_, index)) {
+			return false;
+		}
+
+		// Call __pairs(obj)
+		auto nextIndex = lua_absindex(L_, -1);
+		lua_pushvalue(L_, index);
+		lua_call(L_, 1, 3); // returns __next, obj, nil
+
+		// Push next, obj, k
+		lua_pushvalue(L_, nextIndex);
+		lua_pushvalue(L_, nextIndex + 1);
+		lua_pushvalue(L_, nextIndex + 2);
+		// Call __next(obj, k)
+		lua_call(L_, 2, 2); // returns k, val
+
+		auto header = WritePatchableHeader(isArray);
+		uint32_t size{ 0 };
+		lua_Integer nextArrayIndex{ 1 };
+		int numElements{ 0 };
+		while (lua_type(L_, -2) != LUA_TNIL) {
+			if (isMapOrArray && ctx_.LimitArrayElements != -1 && numElements > ctx_.LimitArrayElements) {
+				break;
+			}
+
+			if (isArray) {
+				if (lua_type(L_, -2) != LUA_TNUMBER) {
+					throw std::runtime_error("Can only pack number keys of array-like userdata");
+				}
+
+				// Fill gaps with nils so elements keep their index
+				auto key = lua_tointeger(L_, -2);
+				for (; nextArrayIndex < key; nextArrayIndex++) {
+					WriteByte(0xc0);
+					size++;
+				}
+
+				WriteValue(lua_gettop(L_), depth + 1);
+				nextArrayIndex = std::max(nextArrayIndex, key + 1);
+				size++;
+			} else if (WriteKey(-2, ctx_.StringifyInternalTypes)) {
+				WriteValue(lua_gettop(L_), depth + 1);
+				size++;
+			}
+
+			// Push next, obj, k
+			lua_pushvalue(L_, nextIndex);
+			lua_pushvalue(L_, nextIndex + 1);
+			lua_pushvalue(L_, nextIndex + 3);
+			lua_remove(L_, -4);
+			lua_remove(L_, -4);
+			// Call __next(obj, k)
+			lua_call(L_, 2, 2); // returns k, val
+			numElements++;
+		}
+
+		PatchSize(header, size);
+
+		lua_pop(L_, 2);
+
+		// Pop __next, obj, nil
+		lua_pop(L_, 3);
+		return true;
+	}
+
+	void WriteUserdata(int index, unsigned depth)
+	{
+		CppValueMetadata meta;
+		if (lua_try_get_cppvalue(L_, index, EnumValueMetatable::MetaTag, meta)) {
+			WriteString(EnumValueMetatable::GetLabel(meta).GetStringView());
+			return;
+		}
+
+		if (lua_try_get_cppvalue(L_, index, BitfieldValueMetatable::MetaTag, meta)) {
+			auto labels = BitfieldValueMetatable::ToJson(meta);
+			WriteArrayHeader(labels.size());
+			for (auto const& label : labels) {
+				WriteString(label.asCString());
+			}
+			return;
+		}
+
+		if (ctx_.IterateUserdata) {
+			if (ctx_.LimitDepth != -1 && depth > (uint32_t)ctx_.LimitDepth) {
+				WriteString("*DEPTH LIMIT EXCEEDED*");
+				return;
+			}
+
+			if (WriteIterableUserdata(index, depth)) {
+				return;
+			}
+		}
+
+		WriteInternalType(index);
+	}
+
+	void WriteValue(int index, unsigned depth)
+	{
+		if (depth > ctx_.MaxDepth) {
+			throw std::runtime_error("Recursion depth exceeded while packing value");
+		}
+
+		switch (lua_type(L_, index)) {
+		case LUA_TNIL:
+			WriteByte(0xc0);
+			break;
+
+		case LUA_TBOOLEAN:
+			WriteByte(lua_toboolean(L_, index) ? 0xc3 : 0xc2);
+			break;
+
+		case LUA_TNUMBER:
+			if (lua_isinteger(L_, index)) {
+				WriteInteger(lua_tointeger(L_, index));
+			} else {
+				WriteNumber(lua_tonumber(L_, index));
+			}
+			break;
+
+		case LUA_TSTRING:
+		{
+			size_t len;
+			auto str = lua_tolstring(L_, index, &len);
+			WriteString(std::string_view(str, len));
+			break;
+		}
+
+		case LUA_TTABLE:
+			if (ctx_.LimitDepth != -1 && depth > (uint32_t)ctx_.LimitDepth) {
+				WriteString("*DEPTH LIMIT EXCEEDED*");
+			} else {
+				WriteTable(index, depth);
+			}
+			break;
+
+		case LUA_TLIGHTCPPOBJECT:
+		case LUA_TCPPOBJECT:
+			WriteUserdata(index, depth);
+			break;
+
+		case LUA_TLIGHTUSERDATA:
+		case LUA_TFUNCTION:
+		case LUA_TTHREAD:
+			WriteInternalType(index);
+			break;
+
+		default:
+			throw std::runtime_error("Attempted to pack an unknown type");
+		}
+	}
+};
+
+// Decodes MessagePack data to Lua values. Strings and binary data are both decoded as Lua strings;
+// extension types are not supported.
+class LuaMsgPackReader
+{
+public:
+	// Maximum nesting depth of arrays and maps
+	static constexpr unsigned MaxDepth = 1000;
+	// Maximum number of slots preallocated for an array or map; larger containers grow while they're read.
+	// The size check only bounds each header by the remaining data, so nested headers that all claim the rest
+	// of the input could otherwise preallocate a multiple of the input size at each level.
+	static constexpr uint32_t MaxPresize = 1024;
+
+	LuaMsgPackReader(lua_State* L, StringView data)
+		: L_(L),
+		begin_(reinterpret_cast<uint8_t const*>(data.data())),
+		pos_(begin_),
+		end_(begin_ + data.size())
+	{}
+
+	bool Read()
+	{
+		auto top = lua_gettop(L_);
+		if (!ReadValue(0)) {
+			lua_settop(L_, top);
+			return false;
+		}
+
+		if (pos_ != end_) {
+			lua_settop(L_, top);
+			return Fail("Unexpected data after the end of the value");
+		}
+
+		return true;
+	}
+
+	inline STDString const& GetError() const
+	{
+		return error_;
+	}
+
+private:
+	lua_State* L_;
+	uint8_t const* begin_;
+	uint8_t const* pos_;
+	uint8_t const* end_;
+	STDString error_;
+
+	bool Fail(char const* msg)
+	{
+		char location[64];
+		sprintf_s(location, "Offset %d: ", (int)(pos_ - begin_));
+		error_ = location;
+		error_ += msg;
+		return false;
+	}
+
+	inline std::size_t Remaining() const
+	{
+		return end_ - pos_;
+	}
+
+	template <class T>
+	bool ReadBigEndian(T& value)
+	{
+		if (Remaining() < sizeof(T)) {
+			return Fail("Unexpected end of data");
+		}
+
+		value = 0;
+		for (std::size_t i = 0; i < sizeof(T); i++) {
+			value = (T)((value << 8) | pos_[i]);
+		}
+		pos_ += sizeof(T);
+		return true;
+	}
+
+	template <class T>
+	bool ReadSize(uint32_t& size)
+	{
+		T value;
+		if (!ReadBigEndian(value)) return false;
+		size = (uint32_t)value;
+		return true;
+	}
+
+	template <class T>
+	bool ReadInteger()
+	{
+		std::make_unsigned_t<T> value;
+		if (!ReadBigEndian(value)) return false;
+		lua_pushinteger(L_, (lua_Integer)(T)value);
+		return true;
+	}
+
+	bool ReadString(uint32_t size)
+	{
+		if (Remaining() < size) {
+			return Fail("String size exceeds the end of data");
+		}
+
+		lua_pushlstring(L_, reinterpret_cast<char const*>(pos_), size);
+		pos_ += size;
+		return true;
+	}
+
+	bool ReadArray(uint32_t size, unsigned depth)
+	{
+		if (depth > MaxDepth) {
+			return Fail("Exceeded nesting limit while unpacking");
+		}
+
+		// Each element takes at least one byte; reject bogus sizes before allocating the table
+		if (Remaining() < size) {
+			return Fail("Array size exceeds the end of data");
+		}
+
+		lua_createtable(L_, (int)std::min(size, MaxPresize), 0);
+		for (uint32_t i = 1; i <= size; i++) {
+			if (!ReadValue(depth)) return false;
+			lua_rawseti(L_, -2, i);
+		}
+
+		return true;
+	}
+
+	bool ReadMap(uint32_t size, unsigned depth)
+	{
+		if (depth > MaxDepth) {
+			return Fail("Exceeded nesting limit while unpacking");
+		}
+
+		if (Remaining() / 2 < size) {
+			return Fail("Map size exceeds the end of data");
+		}
+
+		lua_createtable(L_, 0, (int)std::min(size, MaxPresize));
+		for (uint32_t i = 0; i < size; i++) {
+			auto keyPos = pos_;
+			if (!ReadValue(depth)) return false;
+			auto keyType = lua_type(L_, -1);
+			if (keyType == LUA_TNIL || (keyType == LUA_TNUMBER && std::isnan(lua_tonumber(L_, -1)))) {
+				pos_ = keyPos;
+				return Fail("Map key is nil or NaN");
+			}
+
+			if (!ReadValue(depth)) return false;
+			lua_rawset(L_, -3);
+		}
+
+		return true;
+	}
+
+	bool ReadValue(unsigned depth)
+	{
+		// One slot for the value and one for the key of the enclosing map
+		if (!lua_checkstack(L_, 2)) {
+			return Fail("Lua stack overflow");
+		}
+
+		if (pos_ >= end_) {
+			return Fail("Unexpected end of data");
+		}
+
+		auto type = *pos_++;
+		if (type <= 0x7f) {
+			lua_pushinteger(L_, type);
+			return true;
+		}
+
+		if (type >= 0xe0) {
+			lua_pushinteger(L_, (int8_t)type);
+			return true;
+		}
+
+		switch (type & 0xf0) {
+		case 0x80: return ReadMap(type & 0x0f, depth + 1);
+		case 0x90: return ReadArray(type & 0x0f, depth + 1);
+		case 0xa0:
+		case 0xb0:
+			return ReadString(type & 0x1f);
+		}
+
+		uint32_t size;
+		switch (type) {
+		case 0xc0:
+			lua_pushnil(L_);
+			return true;
+
+		case 0xc2:
+		case 0xc3:
+			lua_pushboolean(L_, type == 0xc3);
+			return true;
+
+		case 0xc4:
+		case 0xd9:
+			return ReadSize<uint8_t>(size) && ReadString(size);
+
+		case 0xc5:
+		case 0xda:
+			return ReadSize<uint16_t>(size) && ReadString(size);
+
+		case 0xc6:
+		case 0xdb:
+			return ReadSize<uint32_t>(size) && ReadString(size);
+
+		case 0xca:
+		{
+			uint32_t value;
+			if (!ReadBigEndian(value)) return false;
+			lua_pushnumber(L_, std::bit_cast<float>(value));
+			return true;
+		}
+
+		case 0xcb:
+		{
+			uint64_t value;
+			if (!ReadBigEndian(value)) return false;
+			lua_pushnumber(L_, std::bit_cast<double>(value));
+			return true;
+		}
+
+		case 0xcc: return ReadInteger<uint8_t>();
+		case 0xcd: return ReadInteger<uint16_t>();
+		case 0xce: return ReadInteger<uint32_t>();
+		// Values above INT64_MAX are wrapped around, same as for JSON
+		case 0xcf: return ReadInteger<uint64_t>();
+		case 0xd0: return ReadInteger<int8_t>();
+		case 0xd1: return ReadInteger<int16_t>();
+		case 0xd2: return ReadInteger<int32_t>();
+		case 0xd3: return ReadInteger<int64_t>();
+
+		case 0xdc: return ReadSize<uint16_t>(size) && ReadArray(size, depth + 1);
+		case 0xdd: return ReadSize<uint32_t>(size) && ReadArray(size, depth + 1);
+		case 0xde: return ReadSize<uint16_t>(size) && ReadMap(size, depth + 1);
+		case 0xdf: return ReadSize<uint32_t>(size) && ReadMap(size, depth + 1);
+
+		default:
+			pos_--;
+			return Fail("Unsupported MessagePack type");
+		}
+	}
+};
+
+std::string Pack(lua_State* L, json::StringifyContext& ctx, int index)
+{
+	StackCheck _(L);
+	LuaMsgPackWriter writer(L, ctx);
+	return writer.Write(index);
+}
+
+bool Unpack(lua_State* L, StringView data, STDString& error)
+{
+	LuaMsgPackReader reader(L, data);
+	if (!reader.Read()) {
+		error = reader.GetError();
+		return false;
+	}
+
+	return true;
+}
+
+bool Unpack(lua_State* L, StringView data)
+{
+	STDString error;
+	if (!Unpack(L, data, error)) {
+		ERR("Unable to unpack MessagePack data: %s", error.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+UserReturn LuaPack(lua_State* L)
+{
+	StackCheck _(L, 1);
+	luaL_checkany(L, 1);
+
+	json::StringifyContext ctx;
+	if (lua_type(L, 2) == LUA_TTABLE) {
+		json::GetStringifyOptions(L, 2, ctx);
+	}
+
+	DisablePropertyWarnings();
+	try {
+		auto packed = Pack(L, ctx, 1);
+		lua_pushlstring(L, packed.data(), packed.size());
+	} catch (std::runtime_error& e) {
+		EnablePropertyWarnings();
+		return luaL_error(L, "%s", e.what());
+	}
+	EnablePropertyWarnings();
+
+	return 1;
+}
+
+UserReturn LuaUnpack(lua_State* L)
+{
+	StackCheck _(L, 1);
+	size_t length;
+	auto data = luaL_checklstring(L, 1, &length);
+
+	STDString error;
+	if (!Unpack(L, StringView(data, length), error)) {
+		return luaL_error(L, "Unable to unpack MessagePack data: %s", error.c_str());
+	}
+
+	return 1;
+}
+
+void RegisterMsgPackLib()
+{
+	DECLARE_MODULE(MsgPack, Both)
+	BEGIN_MODULE()
+	MODULE_NAMED_FUNCTION("Pack", LuaPack)
+	MODULE_NAMED_FUNCTION("Unpack", LuaUnpack)
+	END_MODULE()
+}
+
+END_NS()
@@ -1,61 +1,126 @@
 #pragma once
 
-#include <queue>
+#include <Lua/Libs/TimerWheel.h>
+#include <unordered_map>
 
 /// <lua_module>Timer</lua_module>
 BEGIN_NS(lua::timer)
 
-using TimerHandle = uint64_t;
-
 class TimerManager
 {
 public:
 	static constexpr uint64_t PersistentFlag = 0x100000000ull;
 	static constexpr uint64_t RealtimeFlag = 0x200000000ull;
+	static constexpr uint64_t BatchedFlag = 0x400000000ull;
 
 	struct EphemeralTimer 
 	{
 		double Time;
 		LuaDelegate<void(TimerHandle)> Callback;
 		float Repeat;
+		// Mod that created the timer
+		ModStats* Mod;
+		TimerWheel::EntryIndex WheelEntry;
 	};
 	
+	enum class ArgsFormat : uint8_t
+	{
+		// Records loaded from savegames before SavegameVerBinaryTimerArgs
+		Json,
+		MsgPack
+	};
+
+	// Persistent timer as stored in savegames
+	struct PersistentTimerRecord
+	{
+		double Time;
+		FixedString Callback;
+		// JSON arguments; only used by savegames before SavegameVerBinaryTimerArgs
+		STDString Args;
+		// Base64 encoded MessagePack arguments
+		STDString PackedArgs;
+	};
+
 	struct PersistentTimer
 	{
 		double Time;
 		FixedString Callback;
-		STDString ArgsJson;
+		// Serialized timer arguments; only decoded when the timer fires
+		STDString Args;
+		ArgsFormat Format;
+		TimerWheel::EntryIndex WheelEntry;
 	};
 	
-	struct TimerQueueEntry
+	struct BatchedTimer
 	{
 		double Time;
-		TimerHandle Handle;
+		LuaDelegate<void(RegistryEntry, RegistryEntry)> Callback;
+		// Identity of the handler function; due timers with the same handler are dispatched in one call
+		void const* Handler;
+		RegistryEntry Arg;
+		ModStats* Mod;
+		TimerWheel::EntryIndex WheelEntry;
+	};
 
-		inline bool operator > (TimerQueueEntry const& o) const
-		{
-			return Time > o.Time;
-		}
+	struct BatchingStats
+	{
+		// Number of batched timers that fired
+		uint64_t TimersFired{ 0 };
+		// Number of handler calls made for the batched timers
+		uint64_t Dispatches{ 0 };
+	};
+	
+	struct PersistentCallback
+	{
+		LuaDelegate<void(RegistryEntry, TimerHandle)> Callback;
+		ModStats* Mod;
 	};
 
 	TimerManager(State& state, DeferredLuaDelegateQueue& queue);
 	TimerHandle Add(double time, Ref callback, float repeat = 0.0f);
-	TimerHandle AddPersistent(double time, FixedString const& callback, StringView argsJson);
+	TimerHandle AddPersistent(double time, FixedString const& callback, StringView args, ArgsFormat format);
+	TimerHandle AddBatched(double time, Ref callback, RegistryEntry&& arg);
 	void RegisterPersistentCallback(FixedString const& name, Ref callback);
 	bool Cancel(TimerHandle handle);
 	void Update(double time);
-	void SavegameVisit(ObjectVisitor* visitor);
+	void SavegameVisit(ObjectVisitor* visitor, uint32_t version);
+	bool LoadPersistent(PersistentTimerRecord const& record);
+	// Returns the persistent timers to save; timers that still have JSON arguments are converted to MessagePack
+	void SavePersistent(Vector<PersistentTimerRecord>& records);
+
+	inline BatchingStats const& GetBatchingStats() const
+	{
+		return batchingStats_;
+	}
 
 private:
+	// Batched timers of the same handler that fired during the current update
+	struct TimerBatch
+	{
+		LuaDelegate<void(RegistryEntry, RegistryEntry)> Callback;
+		ModStats* Mod;
+		Vector<TimerHandle> Handles;
+		Vector<RegistryEntry> Args;
+	};
+
 	SaltedPool<EphemeralTimer> ephemeralTimers_;
 	SaltedPool<PersistentTimer> persistentTimers_;
-	HashMap<FixedString, LuaDelegate<void(RegistryEntry, TimerHandle)>> persistentCallbacks_;
-	std::priority_queue<TimerQueueEntry, Vector<TimerQueueEntry>, std::greater<TimerQueueEntry>> queue_;
+	SaltedPool<BatchedTimer> batchedTimers_;
+	HashMap<FixedString, PersistentCallback> persistentCallbacks_;
+	TimerWheel wheel_;
+	Vector<TimerBatch> batches_;
+	std::unordered_map<void const*, uint32_t> batchIndices_;
+	BatchingStats batchingStats_;
 
 	State& state_;
 	DeferredLuaDelegateQueue& eventQueue_;
 
 	void FireTimer(TimerHandle handle, double time);
+	void FireBatchedTimer(TimerHandle handle);
+	bool PushPersistentArgs(PersistentTimer const& timer);
+	bool ConvertArgsToMsgPack(PersistentTimer& timer);
+	void DispatchBatches();
+	ModStats* GetCallbackMod(Ref const& callback);
 };
 
 class TimerSystem
@@ -73,6 +138,11 @@ public:
 		return game_;
 	}
 
+	inline TimerManager::BatchingStats const& GetBatchingStats() const
+	{
+		return game_.GetBatchingStats();
+	}
+
 	inline bool SupportsPersistence() const
 	{
 		return isServer_;
@@ -80,9 +150,10 @@ public:
 
 	void Update(double time);
 	bool Cancel(TimerHandle handle);
-	void SavegameVisit(ObjectVisitor* visitor);
+	void SavegameVisit(ObjectVisitor* visitor, uint32_t version);
 
 private:
+	State& state_;
 	TimerManager realtime_;
 	TimerManager game_;
 	DeferredLuaDelegateQueue eventQueue_;
@@ -1,8 +1,158 @@
 #include <Lua/Libs/Timer.h>
+#include <Lua/Libs/MsgPack.h>
+#include <Extender/Version.h>
 
 /// <lua_module>Timer</lua_module>
 BEGIN_NS(lua::timer)
 
+TimerWheel::EntryIndex TimerWheel::Add(double time, TimerHandle handle)
+{
+	EntryIndex index;
+	if (freeEntries_.empty()) {
+		index = (EntryIndex)entries_.size();
+		entries_.push_back(Entry{});
+	} else {
+		index = freeEntries_.back();
+		freeEntries_.pop_back();
+	}
+
+	auto& entry = entries_[index];
+	entry.Time = time;
+	// Timers that are already due are placed in the current slot
+	entry.Tick = std::max(ToTick(time), currentTick_);
+	entry.Sequence = nextSequence_++;
+	entry.Handle = handle;
+	Link(index);
+	size_++;
+	return index;
+}
+
+bool TimerWheel::Remove(EntryIndex index, TimerHandle handle)
+{
+	if (index >= entries_.size() || entries_[index].Slot == FreeSlot || entries_[index].Handle != handle) {
+		return false;
+	}
+
+	Unlink(index);
+	entries_[index].Slot = FreeSlot;
+	freeEntries_.push_back(index);
+	size_--;
+	return true;
+}
+
+void TimerWheel::Link(EntryIndex index)
+{
+	auto& entry = entries_[index];
+	auto delta = entry.Tick - currentTick_;
+	uint32_t slot;
+	unsigned level{ 0 };
+	if (delta < Level0Slots) {
+		slot = (uint32_t)(entry.Tick & (Level0Slots - 1));
+	} else {
+		// Timers beyond the range of the wheel wait in the farthest slot until they get closer
+		auto tick = delta < MaxTicks ? entry.Tick : currentTick_ + MaxTicks - 1;
+		level = 1;
+		while (level < NumLevels - 1 && (tick - currentTick_) >= (1ull << LevelShift(level + 1))) {
+			level++;
+		}
+
+		slot = Level0Slots + (level - 1) * LevelSlots + (uint32_t)((tick >> LevelShift(level)) & (LevelSlots - 1));
+	}
+
+	entry.Slot = slot;
+	entry.Prev = InvalidEntry;
+	entry.Next = slots_[slot];
+	if (entry.Next != InvalidEntry) {
+		entries_[entry.Next].Prev = index;
+	}
+	slots_[slot] = index;
+	levelSizes_[level]++;
+}
+
+void TimerWheel::Unlink(EntryIndex index)
+{
+	auto& entry = entries_[index];
+	if (entry.Prev != InvalidEntry) {
+		entries_[entry.Prev].Next = entry.Next;
+	} else {
+		slots_[entry.Slot] = entry.Next;
+	}
+
+	if (entry.Next != InvalidEntry) {
+		entries_[entry.Next].Prev = entry.Prev;
+	}
+
+	levelSizes_[SlotLevel(entry.Slot)]--;
+}
+
+void TimerWheel::CollectSlot(uint32_t slot, double time, bool all)
+{
+	auto index = slots_[slot];
+	while (index != InvalidEntry) {
+		auto& entry = entries_[index];
+		auto next = entry.Next;
+		if (all || entry.Time <= time) {
+			due_.push_back(DueTimer{ entry.Time, entry.Sequence, entry.Handle });
+			Unlink(index);
+			entry.Slot = FreeSlot;
+			freeEntries_.push_back(index);
+			size_--;
+		}
+		index = next;
+	}
+}
+
+void TimerWheel::Cascade()
+{
+	for (unsigned level = 1; level < NumLevels; level++) {
+		auto shift = LevelShift(level);
+		if ((currentTick_ & ((1ull << shift) - 1)) != 0) break;
+
+		auto slot = Level0Slots + (level - 1) * LevelSlots + (uint32_t)((currentTick_ >> shift) & (LevelSlots - 1));
+		auto index = slots_[slot];
+		slots_[slot] = InvalidEntry;
+		while (index != InvalidEntry) {
+			auto next = entries_[index].Next;
+			levelSizes_[level]--;
+			Link(index);
+			index = next;
+		}
+	}
+}
+
+void TimerWheel::CollectDue(double time)
+{
+	auto target = ToTick(time);
+	while (currentTick_ < target) {
+		// Every timer in the slot of an elapsed tick is due
+		CollectSlot((uint32_t)(currentTick_ & (Level0Slots - 1)), time, true);
+
+		auto next = currentTick_ + 1;
+		if (levelSizes_[0] == 0) {
+			// Nothing can fire before the next cascade of the lowest non-empty level, so skip to it
+			unsigned level = 1;
+			while (level < NumLevels && levelSizes_[level] == 0) level++;
+
+			if (level == NumLevels) {
+				next = target;
+			} else {
+				auto span = 1ull << LevelShift(level);
+				next = (currentTick_ / span + 1) * span;
+			}
+		}
+
+		currentTick_ = std::min(next, target);
+		Cascade();
+	}
+
+	// Timers in the current tick may be scheduled later within the tick
+	CollectSlot((uint32_t)(currentTick_ & (Level0Slots - 1)), time, false);
+
+	std::sort(due_.begin(), due_.end(), [](DueTimer const& a, DueTimer const& b) {
+		return a.Time < b.Time || (a.Time == b.Time && a.Sequence < b.Sequence);
+	});
+}
+
 TimerManager::TimerManager(State& state, lua::DeferredLuaDelegateQueue& queue)
 	: state_(state), eventQueue_(queue)
 {}
@@ -14,57 +164,95 @@ TimerHandle TimerManager::Add(double time, Ref callback, float repeat)
 	timer->Time = time;
 	timer->Callback = LuaDelegate<void(TimerHandle)>(state_.GetState(), callback);
 	timer->Repeat = repeat;
+	timer->Mod = GetCallbackMod(callback);
 
 	TimerHandle handle{ id };
-
-	queue_.push(TimerQueueEntry{
-		.Time = time,
-		.Handle = handle
-	});
-
+	timer->WheelEntry = wheel_.Add(time, handle);
 	return handle;
 }
 
-TimerHandle TimerManager::AddPersistent(double time, FixedString const& callback, StringView argsJson)
+TimerHandle TimerManager::AddPersistent(double time, FixedString const& callback, StringView args, ArgsFormat format)
 {
 	uint32_t id;
 	auto timer = persistentTimers_.Add(id);
 	timer->Time = time;
 	timer->Callback = callback;
-	timer->ArgsJson = argsJson;
+	timer->Args = args;
+	timer->Format = format;
 
 	TimerHandle handle{ (uint64_t)id | PersistentFlag };
+	timer->WheelEntry = wheel_.Add(time, handle);
+	return handle;
+}
 
-	queue_.push(TimerQueueEntry{
-		.Time = time,
-		.Handle = handle
-	});
+TimerHandle TimerManager::AddBatched(double time, Ref callback, RegistryEntry&& arg)
+{
+	auto L = state_.GetState();
+	callback.Push(L);
+	auto handler = lua_topointer(L, -1);
+	lua_pop(L, 1);
 
+	uint32_t id;
+	auto timer = batchedTimers_.Add(id);
+	timer->Time = time;
+	timer->Callback = LuaDelegate<void(RegistryEntry, RegistryEntry)>(L, callback);
+	timer->Handler = handler;
+	timer->Arg = std::move(arg);
+	timer->Mod = GetCallbackMod(callback);
+
+	TimerHandle handle{ (uint64_t)id | BatchedFlag };
+	timer->WheelEntry = wheel_.Add(time, handle);
 	return handle;
 }
 
 void TimerManager::RegisterPersistentCallback(FixedString const& name, Ref callback)
 {
-	persistentCallbacks_.set(name, LuaDelegate<void(RegistryEntry, TimerHandle)>(state_.GetState(), callback));
+	persistentCallbacks_.set(name, PersistentCallback{
+		.Callback = LuaDelegate<void(RegistryEntry, TimerHandle)>(state_.GetState(), callback),
+		.Mod = GetCallbackMod(callback)
+	});
+}
+
+ModStats* TimerManager::GetCallbackMod(Ref const& callback)
+{
+	auto L = state_.GetState();
+	callback.Push(L);
+	auto mod = EventDispatcher::GetHandlerMod(L, -1);
+	lua_pop(L, 1);
+	return state_.GetModAccounting().GetStats(mod);
 }
 
 bool TimerManager::Cancel(TimerHandle handle)
 {
+	// The realtime flag is added by WaitForRealtime and isn't part of the handle stored in the wheel
+	handle &= ~RealtimeFlag;
 	if (handle & PersistentFlag) {
+		auto timer = persistentTimers_.Find((uint32_t)handle);
+		if (timer == nullptr) return false;
+		wheel_.Remove(timer->WheelEntry, handle);
 		return persistentTimers_.Free((uint32_t)handle);
+	} else if (handle & BatchedFlag) {
+		auto timer = batchedTimers_.Find((uint32_t)handle);
+		if (timer == nullptr) return false;
+		wheel_.Remove(timer->WheelEntry, handle);
+		// Release the argument now instead of when the slot is reused
+		timer->Arg = RegistryEntry{};
+		return batchedTimers_.Free((uint32_t)handle);
 	} else {
+		auto timer = ephemeralTimers_.Find((uint32_t)handle);
+		if (timer == nullptr) return false;
+		wheel_.Remove(timer->WheelEntry, handle);
 		return ephemeralTimers_.Free((uint32_t)handle);
 	}
 }
 
 void TimerManager::Update(double time)
 {
-	while (!queue_.empty() && queue_.top().Time <= time) {
-		auto handle = queue_.top().Handle;
-		queue_.pop();
-
+	wheel_.Advance(time, [this, time](TimerHandle handle) {
 		FireTimer(handle, time);
-	}
+	});
+
+	DispatchBatches();
 }
 
 void TimerManager::FireTimer(TimerHandle handle, double time)
@@ -75,10 +263,11 @@ void TimerManager::FireTimer(TimerHandle handle, double time)
 			auto callback = persistentCallbacks_.try_get(timer->Callback);
 			if (callback) {
 				auto L = state_.GetState();
-				if (json::Parse(L, timer->ArgsJson)) {
+				if (PushPersistentArgs(*timer)) {
 					RegistryEntry args(L, -1);
 					lua_pop(L, 1);
-					eventQueue_.Call(*callback, std::move(args), handle);
+					auto call = eventQueue_.Call(callback->Callback, std::move(args), handle);
+					if (call) call->Mod = callback->Mod;
 				} else {
 					ERR("Unable to parse persistent timer payload for '%s'!", timer->Callback.GetString());
 				}
@@ -88,59 +277,208 @@ void TimerManager::FireTimer(TimerHandle handle, double time)
 			
 			persistentTimers_.Free((uint32_t)handle);
 		}
+	} else if (handle & BatchedFlag) {
+		FireBatchedTimer(handle);
 	} else {
 		auto timer = ephemeralTimers_.Find((uint32_t)handle);
 		if (timer != nullptr) {
-			eventQueue_.Call(timer->Callback, handle);
-
 			if (timer->Repeat > 0.0f) {
+				auto call = eventQueue_.Call(timer->Callback, handle);
+				if (call) call->Mod = timer->Mod;
 				timer->Time = time + timer->Repeat;
-				queue_.push(TimerQueueEntry{
-					.Time = timer->Time,
-					.Handle = handle
-				});
+				timer->WheelEntry = wheel_.Add(timer->Time, handle);
 			} else {
+				// One-shot timer; the queued call takes over the callback reference
+				auto call = eventQueue_.Call(std::move(timer->Callback), handle);
+				if (call) call->Mod = timer->Mod;
 				ephemeralTimers_.Free((uint32_t)handle);
 			}
 		}
 	}
 }
 
-void TimerManager::SavegameVisit(ObjectVisitor* visitor)
+bool TimerManager::PushPersistentArgs(PersistentTimer const& timer)
+{
+	auto L = state_.GetState();
+	STDString error;
+	auto ok = (timer.Format == ArgsFormat::MsgPack)
+		? msgpack::Unpack(L, timer.Args, error)
+		: json::Parse(L, timer.Args, error);
+
+	if (!ok) {
+		ERR("Persistent timer payload for '%s' is invalid: %s", timer.Callback.GetString(), error.c_str());
+	}
+
+	return ok;
+}
+
+void TimerManager::FireBatchedTimer(TimerHandle handle)
+{
+	auto timer = batchedTimers_.Find((uint32_t)handle);
+	if (timer == nullptr) return;
+
+	TimerBatch* batch;
+	auto it = batchIndices_.find(timer->Handler);
+	if (it != batchIndices_.end()) {
+		batch = &batches_[it->second];
+	} else {
+		batchIndices_.insert(std::make_pair(timer->Handler, (uint32_t)batches_.size()));
+		batch = &batches_.emplace_back();
+		// The batch takes over the callback reference of the first timer
+		batch->Callback = std::move(timer->Callback);
+		batch->Mod = timer->Mod;
+	}
+
+	batch->Handles.push_back(handle);
+	batch->Args.push_back(std::move(timer->Arg));
+	batchedTimers_.Free((uint32_t)handle);
+}
+
+void TimerManager::DispatchBatches()
+{
+	if (batches_.empty()) return;
+
+	auto L = state_.GetState();
+	for (auto& batch : batches_) {
+		lua_createtable(L, (int)batch.Handles.size(), 0);
+		for (uint32_t i = 0; i < batch.Handles.size(); i++) {
+			push(L, batch.Handles[i]);
+			lua_rawseti(L, -2, i + 1);
+		}
+		RegistryEntry handles(L, -1);
+		lua_pop(L, 1);
+
+		// args[i] is the argument of handles[i]; timers without an argument leave a hole
+		lua_createtable(L, (int)batch.Args.size(), 0);
+		for (uint32_t i = 0; i < batch.Args.size(); i++) {
+			if (batch.Args[i]) {
+				batch.Args[i].Push();
+				lua_rawseti(L, -2, i + 1);
+			}
+		}
+		RegistryEntry args(L, -1);
+		lua_pop(L, 1);
+
+		auto call = eventQueue_.Call(std::move(batch.Callback), std::move(handles), std::move(args));
+		if (call) call->Mod = batch.Mod;
+
+		batchingStats_.TimersFired += batch.Handles.size();
+		batchingStats_.Dispatches++;
+	}
+
+	batches_.clear();
+	batchIndices_.clear();
+}
+
+void TimerManager::SavegameVisit(ObjectVisitor* visitor, uint32_t version)
 {
-	STDString nullStr;
 	if (visitor->IsReading()) {
 		uint32_t numVars;
 		visitor->VisitCount(GFS.strTimer, &numVars);
 
 		for (uint32_t i = 0; i < numVars; i++) {
 			if (visitor->EnterNode(GFS.strTimer, GFS.strEmpty)) {
-				PersistentTimer timer;
-				visitor->VisitDouble(GFS.strTime, timer.Time, 0.0);
-				visitor->VisitFixedString(GFS.strHandler, timer.Callback, GFS.strEmpty);
-				visitor->VisitSTDString(GFS.strArgs, timer.ArgsJson, STDString{});
-				AddPersistent(timer.Time, timer.Callback, timer.ArgsJson);
+				PersistentTimerRecord record;
+				visitor->VisitDouble(GFS.strTime, record.Time, 0.0);
+				visitor->VisitFixedString(GFS.strHandler, record.Callback, GFS.strEmpty);
+				if (version >= SavegameVerBinaryTimerArgs) {
+					visitor->VisitSTDString(GFS.strPackedArgs, record.PackedArgs, STDString{});
+				}
+
+				if (record.PackedArgs.empty()) {
+					visitor->VisitSTDString(GFS.strArgs, record.Args, STDString{});
+				}
+
+				LoadPersistent(record);
+				visitor->ExitNode(GFS.strTimer);
 			}
 		}
 	} else {
-		uint32_t index{ 0 };
-		while (true) {
-			auto timer = persistentTimers_.Next(index);
-			if (timer == nullptr) break;
-
+		Vector<PersistentTimerRecord> records;
+		SavePersistent(records);
+		for (auto& record : records) {
 			if (visitor->EnterNode(GFS.strTimer, GFS.strEmpty)) {
-				visitor->VisitDouble(GFS.strTime, timer->Time, 0.0);
-				visitor->VisitFixedString(GFS.strHandler, timer->Callback, GFS.strEmpty);
-				visitor->VisitSTDString(GFS.strArgs, timer->ArgsJson, STDString{});
+				visitor->VisitDouble(GFS.strTime, record.Time, 0.0);
+				visitor->VisitFixedString(GFS.strHandler, record.Callback, GFS.strEmpty);
+				if (!record.PackedArgs.empty()) {
+					visitor->VisitSTDString(GFS.strPackedArgs, record.PackedArgs, STDString{});
+				} else {
+					visitor->VisitSTDString(GFS.strArgs, record.Args, STDString{});
+				}
 				visitor->ExitNode(GFS.strTimer);
 			}
 		}
 	}
 }
 
+bool TimerManager::LoadPersistent(PersistentTimerRecord const& record)
+{
+	if (record.PackedArgs.empty()) {
+		// Timers saved before SavegameVerBinaryTimerArgs are converted to MessagePack when the game is saved
+		AddPersistent(record.Time, record.Callback, record.Args, ArgsFormat::Json);
+		return true;
+	}
+
+	STDString args;
+	if (!DecodeBase64(record.PackedArgs, args)) {
+		ERR("Persistent timer payload for '%s' is corrupted; timer dropped", record.Callback.GetString());
+		return false;
+	}
+
+	AddPersistent(record.Time, record.Callback, args, ArgsFormat::MsgPack);
+	return true;
+}
+
+void TimerManager::SavePersistent(Vector<PersistentTimerRecord>& records)
+{
+	uint32_t index{ 0 };
+	while (true) {
+		auto timer = persistentTimers_.Next(index);
+		if (timer == nullptr) break;
+
+		if (timer->Format == ArgsFormat::Json) {
+			ConvertArgsToMsgPack(*timer);
+		}
+
+		auto& record = records.emplace_back();
+		record.Time = timer->Time;
+		record.Callback = timer->Callback;
+		if (timer->Format == ArgsFormat::MsgPack) {
+			record.PackedArgs = EncodeBase64(timer->Args);
+		} else {
+			// Arguments that couldn't be converted are saved as they were loaded
+			record.Args = timer->Args;
+		}
+	}
+}
+
+bool TimerManager::ConvertArgsToMsgPack(PersistentTimer& timer)
+{
+	auto L = state_.GetState();
+	StackCheck _(L);
+	STDString error;
+	if (!json::Parse(L, timer.Args, error)) {
+		ERR("Persistent timer payload for '%s' is invalid: %s", timer.Callback.GetString(), error.c_str());
+		return false;
+	}
+
+	json::StringifyContext ctx;
+	try {
+		auto packed = msgpack::Pack(L, ctx, lua_absindex(L, -1));
+		timer.Args = STDString(packed.data(), packed.size());
+		timer.Format = ArgsFormat::MsgPack;
+	} catch (std::runtime_error& e) {
+		ERR("Persistent timer payload for '%s' could not be converted: %s", timer.Callback.GetString(), e.what());
+	}
+
+	lua_pop(L, 1);
+	return timer.Format == ArgsFormat::MsgPack;
+}
+
 
 TimerSystem::TimerSystem(State& state, bool isServer)
-	: realtime_(state, eventQueue_),
+	: state_(state),
+	realtime_(state, eventQueue_),
 	game_(state, eventQueue_),
 	isServer_(isServer)
 {}
@@ -149,7 +487,12 @@ void TimerSystem::Update(double time)
 {
 	realtime_.Update(time);
 	game_.Update(time);
-	eventQueue_.Flush();
+
+	auto& accounting = state_.GetModAccounting();
+	eventQueue_.Flush([&accounting](DeferredLuaDelegateCallHeader* call) {
+		ModAccountingScope _(accounting, call->Mod);
+		call->Invoke(call);
+	});
 }
 
 bool TimerSystem::Cancel(TimerHandle handle)
@@ -161,16 +504,16 @@ bool TimerSystem::Cancel(TimerHandle handle)
 	}
 }
 
-void TimerSystem::SavegameVisit(ObjectVisitor* visitor)
+void TimerSystem::SavegameVisit(ObjectVisitor* visitor, uint32_t version)
 {
 	if (visitor->EnterNode(GFS.strPersistentTimers, GFS.strEmpty)) {
 		if (visitor->EnterNode(GFS.strGameTimers, GFS.strEmpty)) {
-			game_.SavegameVisit(visitor);
+			game_.SavegameVisit(visitor, version);
 			visitor->ExitNode(GFS.strGameTimers);
 		}
 		
 		if (visitor->EnterNode(GFS.strRealtimeTimers, GFS.strEmpty)) {
-			realtime_.SavegameVisit(visitor);
+			realtime_.SavegameVisit(visitor, version);
 			visitor->ExitNode(GFS.strRealtimeTimers);
 		}
 
@@ -197,9 +540,8 @@ TimerHandle WaitForPersistent(lua_State* L, float delay, FixedString callback, R
 	}
 
 	json::StringifyContext ctx;
-	ctx.Beautify = false;
-	auto str = json::Stringify(L, ctx, args.Index());
-	return state->GetTimers().GameTimer().AddPersistent(time, callback, str);
+	auto packed = msgpack::Pack(L, ctx, args.Index());
+	return state->GetTimers().GameTimer().AddPersistent(time, callback, packed, TimerManager::ArgsFormat::MsgPack);
 }
 
 TimerHandle WaitForRealtime(lua_State* L, float delay, Ref callback, std::optional<float> repeat)
@@ -211,6 +553,37 @@ TimerHandle WaitForRealtime(lua_State* L, float delay, Ref callback, std::option
 	return handle | TimerManager::RealtimeFlag;
 }
 
+// Starts a one-shot timer that calls callback(handles, args) with the list of batched timers that became due
+// and their arguments. Due timers with the same callback function are dispatched in a single call.
+// If a tolerance (in milliseconds) is specified, the timer is delayed by up to that amount to align it to a
+// multiple of the tolerance, so timers started at slightly different times are merged into one call.
+TimerHandle WaitForBatched(lua_State* L, float delay, FunctionRef callback, std::optional<RegistryEntry> arg, std::optional<float> tolerance)
+{
+	auto state = State::FromLua(L);
+	double time = GetCurrentExtensionState()->Time().Time + delay / 1000.0f;
+
+	if (tolerance && *tolerance > 0.0f) {
+		double window = *tolerance / 1000.0;
+		time = std::ceil(time / window) * window;
+	}
+
+	RegistryEntry timerArg;
+	if (arg) timerArg = std::move(*arg);
+	return state->GetTimers().GameTimer().AddBatched(time, Ref(L, callback.Index), std::move(timerArg));
+}
+
+// Returns the number of batched timers that fired, the number of callback calls made for them
+// and the number of calls saved by batching
+UserReturn GetBatchingStats(lua_State* L)
+{
+	auto const& stats = State::FromLua(L)->GetTimers().GetBatchingStats();
+	lua_newtable(L);
+	setfield(L, "TimersFired", stats.TimersFired);
+	setfield(L, "Dispatches", stats.Dispatches);
+	setfield(L, "DispatchesSaved", stats.TimersFired - stats.Dispatches);
+	return 1;
+}
+
 void RegisterPersistentHandler(lua_State* L, FixedString name, Ref callback)
 {
 	return State::FromLua(L)->GetTimers().GameTimer().RegisterPersistentCallback(name, callback);
@@ -228,6 +601,8 @@ void RegisterTimerLib()
 	MODULE_FUNCTION(WaitFor)
 	MODULE_FUNCTION(WaitForPersistent)
 	MODULE_FUNCTION(WaitForRealtime)
+	MODULE_FUNCTION(WaitForBatched)
+	MODULE_FUNCTION(GetBatchingStats)
 	MODULE_FUNCTION(RegisterPersistentHandler)
 	MODULE_FUNCTION(Cancel)
 	END_MODULE()
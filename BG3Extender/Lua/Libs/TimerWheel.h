@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+
+BEGIN_NS(lua::timer)
+
+using TimerHandle = uint64_t;
+
+// Hierarchical timing wheel with 1 ms resolution.
+// Level 0 has one slot per tick for the next 256 ticks; each higher level has 64 slots, each covering a full
+// revolution of the level below it. When the lower level wraps around, the entries of the next slot of the
+// higher level are moved ("cascaded") to lower levels. Timers further out than the top level can cover are
+// kept in its farthest slot and are re-inserted when that slot is cascaded.
+// Inserting and removing entries is O(1); entries are stored in intrusive linked lists so cancelled timers
+// are removed immediately instead of being left in the queue.
+class TimerWheel
+{
+public:
+	using EntryIndex = uint32_t;
+	static constexpr EntryIndex InvalidEntry = 0xffffffffu;
+	static constexpr double TicksPerSecond = 1000.0;
+
+	EntryIndex Add(double time, TimerHandle handle);
+	// Removes the entry if it still belongs to the timer; returns false if it was already removed
+	bool Remove(EntryIndex entry, TimerHandle handle);
+
+	// Removes all timers that are due at the specified time from the wheel and calls fire(handle) for each,
+	// in order of their scheduled time (timers scheduled for the same time fire in the order they were added).
+	// Timers can be added from the callback.
+	template <class Fun>
+	void Advance(double time, Fun fire)
+	{
+		CollectDue(time);
+		for (auto const& timer : due_) {
+			fire(timer.Handle);
+		}
+		due_.clear();
+	}
+
+	inline std::size_t Size() const
+	{
+		return size_;
+	}
+
+private:
+	static constexpr unsigned Level0Bits = 8;
+	static constexpr unsigned LevelBits = 6;
+	static constexpr unsigned NumLevels = 5;
+	static constexpr uint32_t Level0Slots = 1u << Level0Bits;
+	static constexpr uint32_t LevelSlots = 1u << LevelBits;
+	static constexpr uint32_t NumSlots = Level0Slots + (NumLevels - 1) * LevelSlots;
+	// Number of ticks covered by all levels
+	static constexpr uint64_t MaxTicks = 1ull << (Level0Bits + (NumLevels - 1) * LevelBits);
+	// Slot index of entries on the free list
+	static constexpr uint32_t FreeSlot = 0xffffffffu;
+
+	struct Entry
+	{
+		double Time;
+		uint64_t Tick;
+		// Insertion order, for firing timers with the same time in FIFO order
+		uint64_t Sequence;
+		TimerHandle Handle;
+		EntryIndex Prev;
+		EntryIndex Next;
+		uint32_t Slot;
+	};
+
+	struct DueTimer
+	{
+		double Time;
+		uint64_t Sequence;
+		TimerHandle Handle;
+	};
+
+	Vector<Entry> entries_;
+	Vector<EntryIndex> freeEntries_;
+	std::array<EntryIndex, NumSlots> slots_{ MakeEmptySlots() };
+	std::array<std::size_t, NumLevels> levelSizes_{};
+	Vector<DueTimer> due_;
+	// All ticks before the current tick have been processed
+	uint64_t currentTick_{ 0 };
+	uint64_t nextSequence_{ 0 };
+	std::size_t size_{ 0 };
+
+	static constexpr std::array<EntryIndex, NumSlots> MakeEmptySlots()
+	{
+		std::array<EntryIndex, NumSlots> slots{};
+		for (auto& slot : slots) {
+			slot = InvalidEntry;
+		}
+		return slots;
+	}
+
+	static inline uint64_t ToTick(double time)
+	{
+		return time > 0.0 ? (uint64_t)(time * TicksPerSecond) : 0;
+	}
+
+	static inline unsigned LevelShift(unsigned level)
+	{
+		return level == 0 ? 0 : Level0Bits + (level - 1) * LevelBits;
+	}
+
+	static inline unsigned SlotLevel(uint32_t slot)
+	{
+		return slot < Level0Slots ? 0 : 1 + (slot - Level0Slots) / LevelSlots;
+	}
+
+	void Link(EntryIndex index);
+	void Unlink(EntryIndex index);
+	void CollectSlot(uint32_t slot, double time, bool all);
+	void Cascade();
+	void CollectDue(double time);
+};
+
+END_NS()
@@ -175,7 +175,8 @@ bool IsA(lua_State* L, AnyRef object, FixedString typeName)
 	// Check if both types are part of an inheritance tree
 	if (type->PropertyMap != nullptr && expectedType->PropertyMap != nullptr) {
 		// Yes, check if one of an ancestor of the other
-		return type->PropertyMap->IsA(expectedType->PropertyMap->RegistryIndex);
+		auto pm = gStructRegistry.Get(type->PropertyMap->RegistryIndex);
+		return pm->IsA(expectedType->PropertyMap->RegistryIndex);
 	} else {
 		// No, they cannot be the same type
 		return false;
@@ -306,6 +307,16 @@ UserReturn Serialize(lua_State* L)
 	}
 }
 
+UserReturn ToTable(lua_State* L)
+{
+	auto type = lua_type(L, 1);
+	if (type != LUA_TLIGHTCPPOBJECT) {
+		return luaL_error(L, "Don't know how to convert values of type %s to table", lua_typename(L, type));
+	}
+
+	return ContainerProxyHelpers::ToTableProxy(L);
+}
+
 void Unserialize(lua_State* L)
 {
 	auto type = lua_type(L, 1);
@@ -368,6 +379,243 @@ UserReturn Construct(lua_State* L, FixedString const& typeName)
 	return 0;
 }
 
+CppObjectMetadata GetLiveObjectProxy(lua_State* L, int index, char const* operation)
+{
+	CppObjectMetadata meta;
+	lua_get_cppobject(L, index, MetatableTag::ObjectProxyByRef, meta);
+	if (!meta.Lifetime.IsAlive(L)) {
+		luaL_error(L, "Attempted to %s '%s' whose lifetime has expired", operation, 
+			LightObjectProxyByRefMetatable::GetPropertyMap(meta).Name.GetString());
+	}
+
+	return meta;
+}
+
+// Returns the index of the accessor slot table if the key list at 'keysIndex' was compiled 
+// using CompilePropertyList() for the exact same property map, 0 otherwise.
+int GetCompiledPropertySlots(lua_State* L, int keysIndex, GenericPropertyMap const& pm)
+{
+	lua_pushliteral(L, "TypeId");
+	lua_rawget(L, keysIndex);
+	auto typeId = lua_tointegerx(L, -1, nullptr);
+	lua_pop(L, 1);
+	if (typeId != pm.RegistryIndex + 1) {
+		return 0;
+	}
+
+	lua_pushliteral(L, "Slots");
+	lua_rawget(L, keysIndex);
+	if (lua_type(L, -1) != LUA_TTABLE) {
+		lua_pop(L, 1);
+		return 0;
+	}
+
+	return lua_absindex(L, -1);
+}
+
+// Resolves the i-th entry of a property key list.
+// Returns nullptr if the property has no accessor and must go through the fallback getter/setter.
+RawPropertyAccessors const* ResolvePropertyListEntry(lua_State* L, int keysIndex, int slotsIndex, int i, 
+	GenericPropertyMap const& pm, FixedString& name)
+{
+	lua_Integer slot{ -1 };
+	if (slotsIndex != 0) {
+		lua_rawgeti(L, slotsIndex, i);
+		slot = lua_tointegerx(L, -1, nullptr) - 1;
+		lua_pop(L, 1);
+
+		if (slot >= 0 && slot < (lua_Integer)pm.Properties.size()) {
+			auto const& prop = pm.Properties.values()[(uint32_t)slot];
+			name = prop.Name;
+			return &prop;
+		}
+	}
+
+	lua_rawgeti(L, keysIndex, i);
+	name = get<FixedString>(L, -1);
+	lua_pop(L, 1);
+
+	if (slotsIndex == 0 || slot >= 0) {
+		slot = pm.Properties.find_index(name);
+	}
+
+	if (slot >= 0) {
+		return &pm.Properties.values()[slot];
+	} else {
+		return nullptr;
+	}
+}
+
+void CheckGetPropertyResult(lua_State* L, GenericPropertyMap const& pm, FixedString const& prop, PropertyOperationResult result)
+{
+	switch (result) {
+	case PropertyOperationResult::Success:
+		break;
+
+	case PropertyOperationResult::NoSuchProperty:
+		luaL_error(L, "Property does not exist: %s::%s - property does not exist", pm.Name.GetString(), prop.GetString());
+		break;
+
+	case PropertyOperationResult::Unknown:
+	default:
+		luaL_error(L, "Cannot get property %s::%s - unknown error", pm.Name.GetString(), prop.GetString());
+		break;
+	}
+}
+
+void CheckSetPropertyResult(lua_State* L, GenericPropertyMap const& pm, FixedString const& prop, PropertyOperationResult result)
+{
+	switch (result) {
+	case PropertyOperationResult::Success:
+		break;
+
+	case PropertyOperationResult::NoSuchProperty:
+		luaL_error(L, "Cannot set property %s::%s - property does not exist", pm.Name.GetString(), prop.GetString());
+		break;
+
+	case PropertyOperationResult::ReadOnly:
+		luaL_error(L, "Cannot set property %s::%s - property is read-only", pm.Name.GetString(), prop.GetString());
+		break;
+
+	case PropertyOperationResult::UnsupportedType:
+		luaL_error(L, "Cannot set property %s::%s - cannot write properties of this type", pm.Name.GetString(), prop.GetString());
+		break;
+
+	case PropertyOperationResult::Unknown:
+	default:
+		luaL_error(L, "Cannot set property %s::%s - unknown error", pm.Name.GetString(), prop.GetString());
+		break;
+	}
+}
+
+/// <summary>
+/// Resolves the properties in a key list to their accessors in advance.
+/// The returned list can be passed to GetProperties/SetProperties in place of a plain key list 
+/// to avoid looking up the property names on each call.
+/// </summary>
+/// <param name="object">Type name or an object of the type the list is compiled for</param>
+/// <param name="keys">List of property names</param>
+UserReturn CompilePropertyList(lua_State* L)
+{
+	luaL_checktype(L, 2, LUA_TTABLE);
+
+	GenericPropertyMap const* pm{ nullptr };
+	if (lua_type(L, 1) == LUA_TSTRING) {
+		auto typeName = get<FixedString>(L, 1);
+		auto type = TypeInformationRepository::GetInstance().TryGetType(typeName);
+		if (type == nullptr || type->PropertyMap == nullptr) {
+			return luaL_error(L, "Type '%s' has no properties", typeName.GetString());
+		}
+
+		pm = gStructRegistry.Get(type->PropertyMap->RegistryIndex);
+	} else {
+		CppObjectMetadata meta;
+		lua_get_cppobject(L, 1, MetatableTag::ObjectProxyByRef, meta);
+		pm = &LightObjectProxyByRefMetatable::GetPropertyMap(meta);
+	}
+
+	StackCheck _(L, 1);
+	auto numKeys = (int)lua_rawlen(L, 2);
+	lua_createtable(L, numKeys, 2);
+	lua_createtable(L, numKeys, 0);
+
+	for (int i = 1; i <= numKeys; i++) {
+		lua_rawgeti(L, 2, i);
+		auto name = get<FixedString>(L, -1);
+		lua_rawseti(L, -3, i);
+
+		auto slot = pm->Properties.find_index(name);
+		if (slot < 0 && pm->FallbackGetter == nullptr) {
+			return luaL_error(L, "Property does not exist: %s::%s - property does not exist", pm->Name.GetString(), name.GetString());
+		}
+
+		push(L, slot + 1);
+		lua_rawseti(L, -2, i);
+	}
+
+	lua_setfield(L, -2, "Slots");
+	push(L, pm->RegistryIndex + 1);
+	lua_setfield(L, -2, "TypeId");
+	return 1;
+}
+
+/// <summary>
+/// Reads multiple properties of an object in one call. 
+/// Returns the property values in the same order as they appear in the key list.
+/// </summary>
+/// <param name="object">Object to read</param>
+/// <param name="keys">List of property names or a list returned by CompilePropertyList()</param>
+UserReturn GetProperties(lua_State* L)
+{
+	luaL_checktype(L, 2, LUA_TTABLE);
+	auto self = GetLiveObjectProxy(L, 1, "read");
+	auto& pm = LightObjectProxyByRefMetatable::GetPropertyMap(self);
+
+	auto numKeys = (int)lua_rawlen(L, 2);
+	luaL_checkstack(L, numKeys + 1, "too many properties requested");
+	auto slotsIndex = GetCompiledPropertySlots(L, 2, pm);
+
+	FixedString name;
+	for (int i = 1; i <= numKeys; i++) {
+		auto prop = ResolvePropertyListEntry(L, 2, slotsIndex, i, pm, name);
+		auto result = prop ? prop->Get(L, self.Lifetime, self.Ptr, *prop) : pm.GetRawProperty(L, self.Lifetime, self.Ptr, name);
+		CheckGetPropertyResult(L, pm, name, result);
+	}
+
+	if (slotsIndex != 0) {
+		lua_remove(L, slotsIndex);
+	}
+
+	return numKeys;
+}
+
+/// <summary>
+/// Writes multiple properties of an object in one call.
+/// Properties can either be passed as a name-value table, or as a key list and a list of values.
+/// </summary>
+/// <param name="object">Object to write</param>
+/// <param name="keys">Table of property name-value pairs, or a list of property names or a list returned by CompilePropertyList()</param>
+/// <param name="values">List of property values, if a key list was passed</param>
+void SetProperties(lua_State* L)
+{
+	luaL_checktype(L, 2, LUA_TTABLE);
+	auto self = GetLiveObjectProxy(L, 1, "write");
+	auto& pm = LightObjectProxyByRefMetatable::GetPropertyMap(self);
+	StackCheck _(L);
+
+	if (lua_gettop(L) < 3) {
+		auto slotsIndex = GetCompiledPropertySlots(L, 2, pm);
+		if (slotsIndex != 0) {
+			luaL_error(L, "SetProperties(): A list returned by CompilePropertyList() must be passed with a list of values");
+		}
+
+		for (auto idx : iterate(L, 2)) {
+			auto name = get<FixedString>(L, idx - 1);
+			CheckSetPropertyResult(L, pm, name, pm.SetRawProperty(L, self.Ptr, name, lua_absindex(L, idx)));
+		}
+
+		return;
+	}
+
+	luaL_checktype(L, 3, LUA_TTABLE);
+	auto numKeys = (int)lua_rawlen(L, 2);
+	auto slotsIndex = GetCompiledPropertySlots(L, 2, pm);
+
+	FixedString name;
+	for (int i = 1; i <= numKeys; i++) {
+		auto prop = ResolvePropertyListEntry(L, 2, slotsIndex, i, pm, name);
+		lua_rawgeti(L, 3, i);
+		auto valueIndex = lua_absindex(L, -1);
+		auto result = prop ? prop->Set(L, self.Ptr, valueIndex, *prop) : pm.SetRawProperty(L, self.Ptr, name, valueIndex);
+		CheckSetPropertyResult(L, pm, name, result);
+		lua_pop(L, 1);
+	}
+
+	if (slotsIndex != 0) {
+		lua_remove(L, slotsIndex);
+	}
+}
+
 std::optional<STDString> GetValueType(lua_State* L, AnyRef object)
 {
 	if (lua_type(L, object.Index) == LUA_TLIGHTCPPOBJECT) {
@@ -409,6 +657,10 @@ void RegisterTypesLib()
 	MODULE_FUNCTION(Validate)
 	MODULE_FUNCTION(Serialize)
 	MODULE_FUNCTION(Unserialize)
+	MODULE_FUNCTION(ToTable)
+	MODULE_FUNCTION(CompilePropertyList)
+	MODULE_FUNCTION(GetProperties)
+	MODULE_FUNCTION(SetProperties)
 	MODULE_FUNCTION(Construct)
 	END_MODULE()
 }
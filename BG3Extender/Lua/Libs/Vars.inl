@@ -53,6 +53,17 @@ UserVariableFlags ParseUserVariableFlags(lua_State* L, int index)
 		flags |= UserVariableFlags::SyncOnTick;
 	}
 
+	auto priority = try_gettable<FixedString>(L, "SyncPriority", index);
+	if (priority) {
+		if (*priority == GFS.strHigh) {
+			flags |= UserVariableFlags::SyncPriorityHigh;
+		} else if (*priority == GFS.strLow) {
+			flags |= UserVariableFlags::SyncPriorityLow;
+		} else if (*priority != GFS.strNormal) {
+			luaL_error(L, "Unknown SyncPriority '%s'; expected High, Normal or Low", priority->GetString());
+		}
+	}
+
 	return flags;
 }
 
@@ -169,6 +180,46 @@ void DirtyModVariables(std::optional<Guid> moduleUuid, std::optional<FixedString
 	}
 }
 
+// Returns sync queue and delta encoding statistics of user and mod variables (combined)
+UserReturn GetSyncStats(lua_State* L)
+{
+	using namespace std::chrono;
+
+	auto state = gExtender->GetCurrentExtensionState();
+	auto const& entitySync = state->GetUserVariables().GetSyncWriter();
+	auto const& modSync = state->GetModVariables().GetSyncWriter();
+
+	auto const& entityQueue = entitySync.GetStats();
+	auto const& modQueue = modSync.GetStats();
+	auto sent = entityQueue.Sent + modQueue.Sent;
+	auto totalLatency = duration_cast<microseconds>(entityQueue.TotalLatency + modQueue.TotalLatency).count();
+	auto maxLatency = duration_cast<microseconds>(std::max(entityQueue.MaxLatency, modQueue.MaxLatency)).count();
+
+	auto const& entityDelta = entitySync.GetDeltaStats();
+	auto const& modDelta = modSync.GetDeltaStats();
+	auto fullBytes = entityDelta.FullBytes + modDelta.FullBytes;
+	auto sentBytes = entityDelta.SentBytes + modDelta.SentBytes;
+
+	lua_newtable(L);
+	setfield(L, "QueueDepth", entityQueue.QueueDepth + modQueue.QueueDepth);
+	setfield(L, "PeakQueueDepth", std::max(entityQueue.PeakQueueDepth, modQueue.PeakQueueDepth));
+	setfield(L, "Requests", entityQueue.Requests + modQueue.Requests);
+	setfield(L, "Coalesced", entityQueue.Coalesced + modQueue.Coalesced);
+	setfield(L, "Sent", sent);
+	setfield(L, "BudgetLimitedTicks", entityQueue.BudgetLimitedTicks + modQueue.BudgetLimitedTicks);
+	// Latencies are in milliseconds
+	setfield(L, "AverageLatency", sent > 0 ? totalLatency / 1000.0 / sent : 0.0);
+	setfield(L, "MaxLatency", maxLatency / 1000.0);
+
+	setfield(L, "FullValues", entityDelta.FullValues + modDelta.FullValues);
+	setfield(L, "Patches", entityDelta.Patches + modDelta.Patches);
+	setfield(L, "Resyncs", entityDelta.Resyncs + modDelta.Resyncs);
+	setfield(L, "FullBytes", fullBytes);
+	setfield(L, "SentBytes", sentBytes);
+	setfield(L, "BytesSaved", fullBytes - sentBytes);
+	return 1;
+}
+
 void RegisterVarsLib()
 {
 	DECLARE_MODULE(Vars, Both)
@@ -182,6 +233,7 @@ void RegisterVarsLib()
 	MODULE_FUNCTION(GetModVariables)
 	MODULE_FUNCTION(SyncModVariables)
 	MODULE_FUNCTION(DirtyModVariables)
+	MODULE_FUNCTION(GetSyncStats)
 	END_MODULE()
 }
 
@@ -7,6 +7,11 @@
 #include <lstate.h>
 #include <Lua/Shared/EntityComponentEvents.inl>
 #include <Lua/Shared/EntityEventHelpers.inl>
+#include <Lua/Shared/EventDispatcher.inl>
+#include <Lua/Shared/LuaProfiler.inl>
+#include <Lua/Shared/ModAccounting.inl>
+#include <Lua/Shared/GCScheduler.inl>
+#include <Lua/Shared/LuaAllocator.inl>
 
 // Callback from the Lua runtime when a handled (i.e. pcall/xpcall'd) error was thrown.
 // This is needed to capture errors for the Lua debugger, as there is no
@@ -194,6 +199,7 @@ void PushModFunction(lua_State* L, char const* mod, char const* func)
 void ExtensionLibrary::Register(lua_State * L)
 {
 	RegisterLib(L);
+	RegisterEventsLibrary(L);
 }
 
 
@@ -261,19 +267,11 @@ int LuaPanic(lua_State * L)
 
 void* LuaAlloc(void* ud, void* ptr, size_t osize, size_t nsize)
 {
-	(void)ud; (void)osize;  /* not used */
-	if (nsize == 0) {
-		GameFree(ptr);
-		return NULL;
-	} else {
-		auto newBuf = GameAllocRaw(nsize);
-		if (ptr != nullptr) {
-			memcpy(newBuf, ptr, std::min(nsize, osize));
-			GameFree(ptr);
-		}
-
-		return newBuf;
-	}
+	auto state = static_cast<LuaStateWrapper*>(ud);
+	// When ptr is null, osize is the type of the object being allocated
+	auto oldSize = ptr ? osize : 0;
+	state->Accounting.OnAllocation(oldSize, nsize);
+	return state->Allocator.Reallocate(ptr, oldSize, nsize);
 }
 
 LifetimeHandle GetCurrentLifetime(lua_State* L)
@@ -283,7 +281,7 @@ LifetimeHandle GetCurrentLifetime(lua_State* L)
 
 LuaStateWrapper::LuaStateWrapper()
 {
-	L = lua_newstate(LuaAlloc, nullptr);
+	L = lua_newstate(LuaAlloc, this);
 	Internal = lua_new_internal_state();
 	lua_setup_cppobjects(L, &LuaCppAlloc, &LuaCppFree, &LuaCppGetLightMetatable, &LuaCppGetMetatable, &LuaCppCanonicalize);
 	lua_setup_strcache(L, &LuaCacheString, &LuaReleaseString);
@@ -291,6 +289,7 @@ LuaStateWrapper::LuaStateWrapper()
 	luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_ON);
 #endif
 	lua_atpanic(L, &LuaPanic);
+	Accounting.SetLogging(gExtender->GetConfig().LogModStats);
 }
 
 LuaStateWrapper::~LuaStateWrapper()
@@ -306,6 +305,7 @@ State::State(ExtensionStateBase& state, uint32_t generationId, bool isServer)
 	variableManager_(isServer ? gExtender->GetServer().GetExtensionState().GetUserVariables() : gExtender->GetClient().GetExtensionState().GetUserVariables(), isServer),
 	modVariableManager_(isServer ? gExtender->GetServer().GetExtensionState().GetModVariables() : gExtender->GetClient().GetExtensionState().GetModVariables(), isServer),
 	entityHooks_(*this),
+	eventDispatcher_(state),
 	timers_(*this, isServer)
 {
 	*reinterpret_cast<State**>(lua_getextraspace(L.L)) = this;
@@ -356,6 +356,19 @@ void State::FinishStartup()
 	assert(!startupDone_);
 	startupDone_ = true;
 
+	// Bootstrap scripts are loaded with the default collector, as there are no ticks during module load
+	auto gcBudget = gExtender->GetConfig().LuaGCBudgetUs;
+	if (gcBudget > 0) {
+		gcScheduler_.SetBudget(gcBudget);
+		gcScheduler_.SetMode(L, GCScheduler::Mode::Incremental);
+	}
+
+	auto const& loadStats = scriptLoadStats_;
+	DEBUG("Lua startup loaded %d scripts (%d KB): %d from bytecode in %d us, %d compiled in %d us",
+		loadStats.Hits + loadStats.Misses, (int)(loadStats.SourceBytes / 1024),
+		loadStats.Hits, (int)std::chrono::duration_cast<std::chrono::microseconds>(loadStats.LoadTime).count(),
+		loadStats.Misses, (int)std::chrono::duration_cast<std::chrono::microseconds>(loadStats.CompileTime).count());
+
 #if !defined(OSI_NO_DEBUGGER)
 	auto debugger = gExtender->GetLuaDebugMessageHandler();
 	if (debugger && debugger->IsDebuggerReady()) {
@@ -390,18 +403,43 @@ void State::OpenLibs()
 #endif
 }
 
-std::optional<int> State::LoadScript(STDString const & script, STDString const & name, int globalsIdx)
+std::optional<int> State::LoadScript(std::string_view script, STDString const & name, int globalsIdx)
 {
 	int top = lua_gettop(L);
 
 	/* Load the file containing the script we are going to run */
-	int status = luaL_loadbufferx(L, script.c_str(), script.size(), name.c_str(), "text");
+	int status = gExtender->GetBytecodeCache().Load(L, script, name.c_str(), scriptLoadStats_);
 	if (status != LUA_OK) {
 		LuaError("Failed to parse script: " << lua_tostring(L, -1));
 		lua_pop(L, 1);  /* pop error message from the stack */
 		return {};
 	}
 
+	return RunLoadedScript(top, globalsIdx);
+}
+
+std::optional<int> State::LoadPrefetchedScript(ScriptPrefetcher::Script const& script, STDString const& name, 
+	int globalsIdx, BytecodeCache::Clock::duration& loadTime)
+{
+	int top = lua_gettop(L);
+
+	auto start = BytecodeCache::Clock::now();
+	int status = luaL_loadbufferx(L, script.Bytecode.data(), script.Bytecode.size(), name.c_str(), "b");
+	loadTime = BytecodeCache::Clock::now() - start;
+	if (status != LUA_OK) {
+		// Recompile from source; this also replaces the bad bytecode cache entry
+		lua_pop(L, 1);
+		return LoadScript(script.Source, name, globalsIdx);
+	}
+
+	scriptLoadStats_.Hits++;
+	scriptLoadStats_.SourceBytes += script.Source.size();
+	scriptLoadStats_.LoadTime += loadTime;
+	return RunLoadedScript(top, globalsIdx);
+}
+
+std::optional<int> State::RunLoadedScript(int top, int globalsIdx)
+{
 #if LUA_VERSION_NUM <= 501
 	if (globalsIdx != 0) {
 		lua_pushvalue(L, globalsIdx);
@@ -411,7 +449,7 @@ std::optional<int> State::LoadScript(STDString const & script, STDString const &
 
 	/* Ask Lua to run our little script */
 	LifetimeStackPin _(lifetimeStack_);
-	status = CallWithTraceback(L, 0, LUA_MULTRET);
+	int status = CallWithTraceback(L, 0, LUA_MULTRET);
 	if (status != LUA_OK) {
 		LuaError("Failed to execute script: " << lua_tostring(L, -1));
 		lua_pop(L, 1); // pop error message from the stack
@@ -465,12 +503,22 @@ void State::OnResetCompleted()
 
 void State::OnUpdate(GameTime const& time)
 {
+	auto frameStart = GCScheduler::Clock::now();
 	timers_.Update(time.Time);
 
-	TickEvent params{ .Time = time };
-	ThrowEvent("Tick", params, false, 0);
+	if (state_.HasEventSubscribers(EngineEvent::Tick)) {
+		TickEvent params{ .Time = time };
+		ThrowEvent("Tick", params, false, 0);
+	}
 
-	lua_gc(L, LUA_GCSTEP, 10);
+	gcScheduler_.Update(L, frameStart);
+	// Return slabs emptied by the collector to the game allocator once per completed cycle
+	auto gcCycles = gcScheduler_.GetStats().Cycles;
+	if (gcCycles != trimmedGCCycles_) {
+		L.Allocator.Trim();
+		trimmedGCCycles_ = gcCycles;
+	}
+	L.Accounting.Update();
 	variableManager_.Flush();
 	modVariableManager_.Flush();
 }
@@ -502,17 +550,20 @@ STDString State::GetBuiltinLibrary(int resourceId)
 
 EventResult State::DispatchEvent(EventBase& evt, char const* eventName, bool canPreventAction, uint32_t restrictions)
 {
-	auto stackSize = lua_gettop(L) - 2;
+	auto stackSize = lua_gettop(L) - 1;
 
 	try {
 		Restriction restriction(*this, restrictions);
 		evt.Name = FixedString(eventName);
 		evt.CanPreventAction = canPreventAction;
 
-		if (!CheckedCall(L, 1, "_ThrowEvent")) {
-			return EventResult::Failed;
+		auto event = eventDispatcher_.Get(evt.Name);
+		if (event != nullptr) {
+			event->Throw(L, -1, &evt);
 		}
 
+		lua_pop(L, 1);
+
 		if (evt.ActionPrevented) {
 			return EventResult::ActionPrevented;
 		} else {
@@ -15,7 +15,14 @@
 #include <Lua/Shared/Proxies/LuaImguiProxy.h>
 #endif
 #include <Lua/Shared/EntityComponentEvents.h>
+#include <Lua/Shared/EventDispatcher.h>
 #include <Lua/Shared/EntityEventHelpers.h>
+#include <Lua/Shared/LuaProfiler.h>
+#include <Lua/Shared/ModAccounting.h>
+#include <Lua/Shared/GCScheduler.h>
+#include <Lua/Shared/LuaAllocator.h>
+#include <Lua/Shared/BytecodeCache.h>
+#include <Lua/Shared/ScriptPrefetcher.h>
 #include <Extender/Shared/UserVariables.h>
 #include <Lua/Libs/Timer.h>
 
@@ -58,6 +65,10 @@ namespace bg3se::lua
 
 		lua_State* L;
 		LuaInternalState* Internal;
+		LuaPoolAllocator Allocator;
+		ScriptOriginMap ScriptOrigins;
+		LuaProfiler Profiler{ ScriptOrigins };
+		ModAccounting Accounting;
 	};
 
 	class State : Noncopyable<State>
@@ -172,6 +183,41 @@ namespace bg3se::lua
 			return entityHooks_;
 		}
 
+		inline EventDispatcher& GetEventDispatcher()
+		{
+			return eventDispatcher_;
+		}
+
+		inline ScriptOriginMap& GetScriptOrigins()
+		{
+			return L.ScriptOrigins;
+		}
+
+		inline LuaProfiler& GetProfiler()
+		{
+			return L.Profiler;
+		}
+
+		inline ModAccounting& GetModAccounting()
+		{
+			return L.Accounting;
+		}
+
+		inline LuaPoolAllocator const& GetAllocator() const
+		{
+			return L.Allocator;
+		}
+
+		inline GCScheduler& GetGCScheduler()
+		{
+			return gcScheduler_;
+		}
+
+		inline BytecodeCache::Stats const& GetScriptLoadStats() const
+		{
+			return scriptLoadStats_;
+		}
+
 		void FinishStartup();
 		void LoadBootstrap(STDString const& path, STDString const& modTable);
 		virtual void OnGameSessionLoading();
@@ -215,12 +261,14 @@ namespace bg3se::lua
 			static_assert(std::is_base_of_v<EventBase, TEvent>, "Event object must be a descendant of EventBase");
 			StackCheck _(L, 0);
 			LifetimeStackPin _p(GetStack());
-			PushInternalFunction(L, "_ThrowEvent");
 			MakeObjectRef(L, &evt);
 			return DispatchEvent(evt, eventName, canPreventAction, restrictions);
 		}
 
-		std::optional<int> LoadScript(STDString const & script, STDString const & name = "", int globalsIdx = 0);
+		std::optional<int> LoadScript(std::string_view script, STDString const & name = "", int globalsIdx = 0);
+		// Loads a script compiled by the script prefetcher; loadTime receives the time taken to load the bytecode
+		std::optional<int> LoadPrefetchedScript(ScriptPrefetcher::Script const& script, STDString const& name, 
+			int globalsIdx, BytecodeCache::Clock::duration& loadTime);
 
 		/*void OnNetMessageReceived(STDString const & channel, STDString const & payload, UserId userId);*/
 
@@ -241,9 +289,15 @@ namespace bg3se::lua
 		CachedUserVariableManager variableManager_;
 		CachedModVariableManager modVariableManager_;
 		EntityComponentEventHooks entityHooks_;
+		EventDispatcher eventDispatcher_;
 		timer::TimerSystem timers_;
+		GCScheduler gcScheduler_;
+		// Number of GC cycles completed when the allocator was last trimmed
+		uint64_t trimmedGCCycles_{ 0 };
+		BytecodeCache::Stats scriptLoadStats_;
 
 		void OpenLibs();
+		std::optional<int> RunLoadedScript(int top, int globalsIdx);
 		EventResult DispatchEvent(EventBase& evt, char const* eventName, bool canPreventAction, uint32_t restrictions);
 	};
 
@@ -74,7 +74,7 @@ public:
 	OsirisCallbackManager(ExtensionState& state);
 	~OsirisCallbackManager();
 
-	SubscriptionId Subscribe(STDString const& name, uint32_t arity, OsirisHookSignature::HookType type, RegistryEntry handler);
+	SubscriptionId Subscribe(STDString const& name, uint32_t arity, OsirisHookSignature::HookType type, RegistryEntry handler, ModStats* mod);
 	bool Unsubscribe(SubscriptionId id);
 
 	void StoryLoaded();
@@ -98,6 +98,8 @@ private:
 	struct Subscription
 	{
 		RegistryEntry Callback;
+		// Mod that registered the listener
+		ModStats* Mod;
 		OsirisHookSignature Signature;
 		std::optional<uint64_t> Node;
 	};
@@ -45,13 +45,14 @@ OsirisCallbackManager::~OsirisCallbackManager()
 	}
 }
 
-OsirisCallbackManager::SubscriptionId OsirisCallbackManager::Subscribe(STDString const& name, uint32_t arity, OsirisHookSignature::HookType type, RegistryEntry handler)
+OsirisCallbackManager::SubscriptionId OsirisCallbackManager::Subscribe(STDString const& name, uint32_t arity, OsirisHookSignature::HookType type, RegistryEntry handler, ModStats* mod)
 {
 	OsirisHookSignature sig{ name, arity, type };
 	SubscriptionId id;
 
 	auto sub = subscriptions_.Add(id);
 	sub->Callback = std::move(handler);
+	sub->Mod = mod;
 	sub->Signature = sig;
 
 	nameSubscriberRefs_.insert(std::make_pair(sig, id));
@@ -115,6 +116,7 @@ void OsirisCallbackManager::RunHandlers(uint64_t nodeRef, TuplePtrLL* tuple)
 		for (auto index : *indices) {
 			auto sub = subscriptions_.Find(index);
 			if (sub) {
+				ModAccountingScope _(lua->GetModAccounting(), sub->Mod);
 				RunHandler(lua.Get(), sub->Callback, tuple);
 			}
 		}
@@ -183,6 +185,7 @@ void OsirisCallbackManager::RunHandlers(uint64_t nodeRef, OsiArgumentDesc* args)
 		for (auto index : *indices) {
 			auto sub = subscriptions_.Find(index);
 			if (sub) {
+				ModAccountingScope _(lua->GetModAccounting(), sub->Mod);
 				RunHandler(lua.Get(), sub->Callback, args);
 			}
 		}
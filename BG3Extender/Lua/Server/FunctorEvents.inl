@@ -32,9 +32,16 @@ void LuaTriggerFunctorPostExecEvent(bg3se::stats::Functors* self, TParams* param
 template <class TParams>
 void FunctorEventHooks::OnFunctorExecute(bg3se::stats::ExecuteFunctorProc<TParams>* next, HitResult* hit, bg3se::stats::Functors* self, TParams* params)
 {
-	LuaTriggerFunctorPreExecEvent<TParams>(self, params);
+	auto& state = gExtender->GetServer().GetExtensionState();
+	if (state.HasEventSubscribers(EngineEvent::ExecuteFunctor)) {
+		LuaTriggerFunctorPreExecEvent<TParams>(self, params);
+	}
+
 	next(hit, self, params);
-	LuaTriggerFunctorPostExecEvent<TParams>(self, params, hit);
+
+	if (state.HasEventSubscribers(EngineEvent::AfterExecuteFunctor)) {
+		LuaTriggerFunctorPostExecEvent<TParams>(self, params, hit);
+	}
 }
 
 FunctorEventHooks::FunctorEventHooks()
@@ -78,8 +85,9 @@ HitResult* FunctorEventHooks::OnDealDamage(bg3se::stats::DealDamageFunctor::Appl
 	HitDesc* hit, AttackDesc* attack, EntityHandle* sourceHandle2, HitWith hitWith, int conditionRollIndex,
 	bool entityDamagedEventParam, __int64 a17, SpellId* spellId2)
 {
-	{
-		LuaServerPin lua(gExtender->GetServer().GetExtensionState());
+	auto& state = gExtender->GetServer().GetExtensionState();
+	if (state.HasEventSubscribers(EngineEvent::DealDamage)) {
+		LuaServerPin lua(state);
 		if (lua) {
 			DealDamageEvent evt;
 			evt.Functor = functor;
@@ -102,8 +110,8 @@ HitResult* FunctorEventHooks::OnDealDamage(bg3se::stats::DealDamageFunctor::Appl
 	auto ret = next(result, functor, casterHandle, targetHandle, position, isFromItem, spellId, storyActionId, originator, classResourceMgr, 
 		hit, attack, sourceHandle2, hitWith, conditionRollIndex, entityDamagedEventParam, a17, spellId2);
 
-	{
-		LuaServerPin lua(gExtender->GetServer().GetExtensionState());
+	if (state.HasEventSubscribers(EngineEvent::DealtDamage)) {
+		LuaServerPin lua(state);
 		if (lua) {
 			DealtDamageEvent evt;
 			evt.Functor = functor;
@@ -130,8 +138,9 @@ HitResult* FunctorEventHooks::OnDealDamage(bg3se::stats::DealDamageFunctor::Appl
 void FunctorEventHooks::OnEntityDamageEvent(bg3se::stats::StatsSystem_ThrowDamageEventProc* next, void* statsSystem,
 	void* temp5, HitDesc* hit, AttackDesc* attack, bool a5, bool a6)
 {
-	{
-		LuaServerPin lua(gExtender->GetServer().GetExtensionState());
+	auto& state = gExtender->GetServer().GetExtensionState();
+	if (state.HasEventSubscribers(EngineEvent::BeforeDealDamage)) {
+		LuaServerPin lua(state);
 		if (lua) {
 			BeforeDealDamageEvent evt;
 			evt.Hit = hit;
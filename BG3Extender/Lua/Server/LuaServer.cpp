@@ -79,7 +79,8 @@ namespace bg3se::esv::lua
 
 		LuaServerPin lua(ExtensionState::Get());
 		RegistryEntry handler(L, 4);
-		auto subscriberId = lua->Osiris().GetOsirisCallbacks().Subscribe(name, arity, type, std::move(handler));
+		auto mod = lua->GetModAccounting().GetStats(EventDispatcher::GetHandlerMod(L, 4));
+		auto subscriberId = lua->Osiris().GetOsirisCallbacks().Subscribe(name, arity, type, std::move(handler), mod);
 		push(L, subscriberId);
 		return 1;
 	}
@@ -0,0 +1,345 @@
+#include <stdafx.h>
+#include <Lua/Shared/BytecodeCache.h>
+#include <Extender/Version.h>
+#include <GameDefinitions/Symbols.h>
+#include <lua.h>
+#include <lauxlib.h>
+#include <filesystem>
+#include <fstream>
+
+BEGIN_NS(lua)
+
+void BytecodeCache::Stats::Add(Stats const& o)
+{
+	Hits += o.Hits;
+	Misses += o.Misses;
+	Rejected += o.Rejected;
+	SourceBytes += o.SourceBytes;
+	LoadTime += o.LoadTime;
+	CompileTime += o.CompileTime;
+}
+
+int BytecodeWriter(lua_State* L, void const* p, size_t sz, void* ud)
+{
+	reinterpret_cast<STDString*>(ud)->append(reinterpret_cast<char const*>(p), sz);
+	return 0;
+}
+
+int BytecodeCache::Load(lua_State* L, std::string_view source, char const* chunkName, Stats& stats)
+{
+	auto start = Clock::now();
+	stats.SourceBytes += source.size();
+
+	if (!enabled_) {
+		auto status = luaL_loadbufferx(L, source.data(), source.size(), chunkName, "t");
+		stats.Misses++;
+		stats.CompileTime += Clock::now() - start;
+		return status;
+	}
+
+	auto key = MakeKey(source, chunkName);
+	auto bytecode = ReadEntry(key, source.size());
+	if (bytecode) {
+		if (luaL_loadbufferx(L, bytecode->data(), bytecode->size(), chunkName, "b") == LUA_OK) {
+			stats.Hits++;
+			stats.LoadTime += Clock::now() - start;
+			return LUA_OK;
+		}
+
+		// Entry was written by an incompatible Lua build or is corrupted; recompile and overwrite it
+		WARN("Discarding invalid bytecode cache entry for '%s': %s", chunkName, lua_tostring(L, -1));
+		lua_pop(L, 1);
+		stats.Rejected++;
+	}
+
+	STDString compiled;
+	auto status = Compile(L, source, chunkName, compiled);
+	if (status == LUA_OK) {
+		WriteEntry(key, source.size(), compiled);
+	}
+
+	stats.Misses++;
+	stats.CompileTime += Clock::now() - start;
+	return status;
+}
+
+bool BytecodeCache::GetBytecode(lua_State* L, std::string_view source, char const* chunkName, STDString& bytecode, Stats& stats)
+{
+	auto start = Clock::now();
+	stats.SourceBytes += source.size();
+
+	Key key{};
+	if (enabled_) {
+		key = MakeKey(source, chunkName);
+		auto cached = ReadEntry(key, source.size());
+		if (cached) {
+			bytecode = std::move(*cached);
+			stats.Hits++;
+			stats.LoadTime += Clock::now() - start;
+			return true;
+		}
+	}
+
+	auto status = Compile(L, source, chunkName, bytecode);
+	lua_pop(L, 1);
+	if (status == LUA_OK && enabled_) {
+		WriteEntry(key, source.size(), bytecode);
+	}
+
+	stats.Misses++;
+	stats.CompileTime += Clock::now() - start;
+	return status == LUA_OK;
+}
+
+int BytecodeCache::Compile(lua_State* L, std::string_view source, char const* chunkName, STDString& bytecode)
+{
+	auto status = luaL_loadbufferx(L, source.data(), source.size(), chunkName, "t");
+	if (status == LUA_OK) {
+		// Debug info is kept, as it is needed for tracebacks and the debugger
+		lua_dump(L, &BytecodeWriter, &bytecode, 0);
+	}
+
+	return status;
+}
+
+unsigned BytecodeCache::Clear()
+{
+	auto dir = GetDirectory();
+	if (dir.empty()) return 0;
+
+	unsigned removed{ 0 };
+	std::error_code ec;
+	for (auto const& entry : std::filesystem::directory_iterator(dir, ec)) {
+		if (entry.is_regular_file(ec) && std::filesystem::remove(entry.path(), ec)) {
+			removed++;
+		}
+	}
+
+	return removed;
+}
+
+BytecodeCache::Key BytecodeCache::MakeKey(std::string_view source, char const* chunkName)
+{
+	Key sourceKey;
+	MurmurHash3_x64_128(source.data(), (int)source.size(), 0, sourceKey.Hash);
+
+	// Bytecode is only valid for the Lua build it was compiled with
+	STDString keyData(reinterpret_cast<char const*>(sourceKey.Hash), sizeof(sourceKey.Hash));
+	keyData += chunkName;
+	keyData.push_back('\0');
+	keyData += LUA_RELEASE;
+	keyData.push_back('\0');
+	uint32_t versions[] = { CurrentVersion, FormatVersion };
+	keyData.append(reinterpret_cast<char const*>(versions), sizeof(versions));
+	// Dev and nightly builds share the same version number
+	auto buildId = GetBuildId();
+	keyData.append(reinterpret_cast<char const*>(&buildId), sizeof(buildId));
+
+	Key key;
+	MurmurHash3_x64_128(keyData.data(), (int)keyData.size(), 0, key.Hash);
+	return key;
+}
+
+uint64_t BytecodeCache::GetBuildId()
+{
+	static uint64_t buildId = []() -> uint64_t {
+		// The link timestamp of the extender DLL changes with every build
+		HMODULE module{ NULL };
+		if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+			reinterpret_cast<LPCWSTR>(&BytecodeCache::GetBuildId), &module)) {
+			return 0;
+		}
+
+		auto dosHeader = reinterpret_cast<IMAGE_DOS_HEADER const*>(module);
+		auto ntHeaders = reinterpret_cast<IMAGE_NT_HEADERS const*>(reinterpret_cast<uint8_t const*>(module) + dosHeader->e_lfanew);
+		uint64_t id = ntHeaders->FileHeader.TimeDateStamp;
+#if defined(SE_IS_DEVELOPER_BUILD)
+		id |= 1ull << 32;
+#endif
+		return id;
+	}();
+
+	return buildId;
+}
+
+void BytecodeCache::Prune(std::wstring const& dir)
+{
+	struct Entry
+	{
+		std::filesystem::path Path;
+		// Time of the last write or cache hit (see TouchEntry())
+		std::filesystem::file_time_type WriteTime;
+		uint64_t Size;
+	};
+
+	std::vector<Entry> entries;
+	uint64_t totalSize{ 0 };
+	unsigned removed{ 0 };
+	auto expiry = std::filesystem::file_time_type::clock::now() - MaxEntryAge;
+
+	std::error_code ec;
+	for (auto const& file : std::filesystem::directory_iterator(dir, ec)) {
+		if (!file.is_regular_file(ec)) continue;
+
+		auto writeTime = file.last_write_time(ec);
+		if (ec) continue;
+
+		// Leftover temp files are from writes interrupted by a crash
+		if (writeTime < expiry || file.path().extension() == L".tmp") {
+			if (std::filesystem::remove(file.path(), ec)) removed++;
+			continue;
+		}
+
+		auto size = file.file_size(ec);
+		if (ec) continue;
+
+		entries.push_back(Entry{ file.path(), writeTime, size });
+		totalSize += size;
+	}
+
+	if (totalSize > MaxCacheSize) {
+		std::sort(entries.begin(), entries.end(), [](Entry const& a, Entry const& b) {
+			return a.WriteTime < b.WriteTime;
+		});
+
+		for (auto const& entry : entries) {
+			if (totalSize <= MaxCacheSize) break;
+			if (std::filesystem::remove(entry.Path, ec)) {
+				totalSize -= entry.Size;
+				removed++;
+			}
+		}
+	}
+
+	if (removed > 0) {
+		DEBUG("Pruned %d stale bytecode cache entries", removed);
+	}
+}
+
+std::wstring BytecodeCache::GetDirectory()
+{
+	std::lock_guard _(directoryMutex_);
+	if (directory_.empty()) {
+		// Not placed under "Script Extender", as that directory is writable by mods through Ext.IO
+		auto path = GetStaticSymbols().ToPath("/Script Extender Cache/Bytecode", PathRootType::UserProfile);
+		if (path.empty()) {
+			return L"";
+		}
+
+		std::wstring dir = FromUTF8(path).c_str();
+		std::error_code ec;
+		std::filesystem::create_directories(dir, ec);
+		if (ec) {
+			ERR("Could not create bytecode cache directory '%s': %s", path.c_str(), ec.message().c_str());
+			enabled_ = false;
+			return L"";
+		}
+
+		directory_ = dir;
+		Prune(directory_);
+	}
+
+	return directory_;
+}
+
+std::wstring BytecodeCache::GetEntryPath(Key const& key)
+{
+	auto dir = GetDirectory();
+	if (dir.empty()) return L"";
+
+	wchar_t name[40];
+	swprintf_s(name, L"%016llx%016llx.luac", key.Hash[0], key.Hash[1]);
+	return dir + L"/" + name;
+}
+
+std::optional<STDString> BytecodeCache::ReadEntry(Key const& key, std::size_t sourceSize)
+{
+	auto path = GetEntryPath(key);
+	if (path.empty()) return {};
+
+	std::ifstream f(path, std::ios::in | std::ios::binary);
+	if (!f.good()) return {};
+
+	f.seekg(0, std::ios::end);
+	uint64_t fileSize = f.tellg();
+	f.seekg(0, std::ios::beg);
+
+	EntryHeader header;
+	if (fileSize < sizeof(header) || !f.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+		return {};
+	}
+
+	if (header.Magic != Magic
+		|| header.Version != FormatVersion
+		|| memcmp(&header.CacheKey, &key, sizeof(key)) != 0
+		|| header.SourceSize != sourceSize
+		|| header.BytecodeSize != fileSize - sizeof(header)) {
+		return {};
+	}
+
+	STDString bytecode;
+	bytecode.resize((std::size_t)header.BytecodeSize);
+	if (!f.read(bytecode.data(), bytecode.size())) {
+		return {};
+	}
+
+	// Binary chunks are not validated by Lua, so make sure the entry is exactly what we wrote
+	uint64_t hash[2];
+	MurmurHash3_x64_128(bytecode.data(), (int)bytecode.size(), 0, hash);
+	if (memcmp(hash, header.BytecodeHash, sizeof(hash)) != 0) {
+		WARN("Bytecode cache entry '%s' is corrupted", ToUTF8(path).c_str());
+		return {};
+	}
+
+	f.close();
+	TouchEntry(path);
+	return bytecode;
+}
+
+void BytecodeCache::TouchEntry(std::wstring const& path)
+{
+	// Prune() evicts entries by write time, so bump it to keep frequently loaded entries in the cache
+	std::error_code ec;
+	auto now = std::filesystem::file_time_type::clock::now();
+	auto writeTime = std::filesystem::last_write_time(path, ec);
+	if (!ec && writeTime < now - TouchInterval) {
+		std::filesystem::last_write_time(path, now, ec);
+	}
+}
+
+void BytecodeCache::WriteEntry(Key const& key, std::size_t sourceSize, std::string_view bytecode)
+{
+	auto path = GetEntryPath(key);
+	if (path.empty()) return;
+
+	EntryHeader header{
+		.Magic = Magic,
+		.Version = FormatVersion,
+		.CacheKey = key,
+		.SourceSize = sourceSize,
+		.BytecodeSize = bytecode.size()
+	};
+	MurmurHash3_x64_128(bytecode.data(), (int)bytecode.size(), 0, header.BytecodeHash);
+
+	// The server and client states may compile the same script concurrently, so each thread writes to
+	// its own temp file and atomically replaces the entry
+	auto tempPath = path + L"." + std::to_wstring(GetCurrentThreadId()) + L".tmp";
+	{
+		std::ofstream f(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!f.good()) return;
+
+		f.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		f.write(bytecode.data(), bytecode.size());
+		if (!f.good()) {
+			f.close();
+			DeleteFileW(tempPath.c_str());
+			return;
+		}
+	}
+
+	if (!MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+		DeleteFileW(tempPath.c_str());
+	}
+}
+
+END_NS()
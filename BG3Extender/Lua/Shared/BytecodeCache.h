@@ -0,0 +1,103 @@
+#pragma once
+
+#include <GameDefinitions/Base/Base.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string_view>
+
+BEGIN_NS(lua)
+
+// Content-addressed on-disk cache of compiled Lua chunks.
+// Entries are keyed on a hash of the script source, the chunk name, the Lua version and the extender build,
+// so a change to any of them results in a new key; stale entries are never loaded, and are deleted once they
+// get old or the cache grows too large.
+// Bytecode is only ever produced by compiling source in text mode; binary chunks are only loaded from the cache
+// directory, which is outside the directory mods can write to via Ext.IO, and only if they match the hash
+// stored when the entry was written.
+class BytecodeCache : Noncopyable<BytecodeCache>
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr uint32_t Magic = 0x43425342; // "BSBC"
+	static constexpr uint32_t FormatVersion = 2;
+	// Entries that weren't used for this long are deleted when the cache is first used
+	static constexpr auto MaxEntryAge = std::chrono::hours(24 * 30);
+	// Least recently used entries are deleted when the cache is first used until it is below this size
+	static constexpr uint64_t MaxCacheSize = 256 * 1024 * 1024;
+	// The write time of entries doubles as their last use time; it is only updated on a cache hit
+	// if it is older than this, so loading unchanged scripts doesn't write to the disk every time
+	static constexpr auto TouchInterval = std::chrono::hours(24);
+
+	struct Stats
+	{
+		// Chunks loaded from cached bytecode
+		uint32_t Hits{ 0 };
+		// Chunks compiled from source
+		uint32_t Misses{ 0 };
+		// Cache entries that failed validation or couldn't be loaded
+		uint32_t Rejected{ 0 };
+		uint64_t SourceBytes{ 0 };
+		// Time spent loading chunks from the cache (including file IO)
+		Clock::duration LoadTime{ 0 };
+		// Time spent compiling chunks from source (including storing the bytecode)
+		Clock::duration CompileTime{ 0 };
+
+		void Add(Stats const& o);
+	};
+
+	inline bool IsEnabled() const
+	{
+		return enabled_;
+	}
+
+	inline void SetEnabled(bool enabled)
+	{
+		enabled_ = enabled;
+	}
+
+	// Loads a text chunk, using cached bytecode if available.
+	// Returns the same status and leaves the same values on the stack as luaL_loadbufferx().
+	int Load(lua_State* L, std::string_view source, char const* chunkName, Stats& stats);
+	// Returns the bytecode of a text chunk from the cache, or compiles it and stores the bytecode in the cache.
+	// Returns false if the chunk has syntax errors; the stack is left unchanged.
+	bool GetBytecode(lua_State* L, std::string_view source, char const* chunkName, STDString& bytecode, Stats& stats);
+	// Compiles a text chunk and returns its bytecode in the format stored in the cache.
+	// Leaves the compiled function (or the error message) on the stack.
+	static int Compile(lua_State* L, std::string_view source, char const* chunkName, STDString& bytecode);
+	// Deletes all cache entries; returns the number of entries deleted
+	unsigned Clear();
+
+private:
+	struct Key
+	{
+		uint64_t Hash[2];
+	};
+
+	struct EntryHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		Key CacheKey;
+		uint64_t SourceSize;
+		uint64_t BytecodeSize;
+		// Hash of the bytecode following the header
+		uint64_t BytecodeHash[2];
+	};
+
+	std::atomic<bool> enabled_{ true };
+	std::mutex directoryMutex_;
+	std::wstring directory_;
+
+	static Key MakeKey(std::string_view source, char const* chunkName);
+	static uint64_t GetBuildId();
+	static void Prune(std::wstring const& dir);
+	std::wstring GetDirectory();
+	std::wstring GetEntryPath(Key const& key);
+	std::optional<STDString> ReadEntry(Key const& key, std::size_t sourceSize);
+	static void TouchEntry(std::wstring const& path);
+	void WriteEntry(Key const& key, std::size_t sourceSize, std::string_view bytecode);
+};
+
+END_NS()
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <unordered_map>
+
+BEGIN_NS(lua)
+
+struct EventBase;
+struct ModStats;
+class EventDispatcher;
+
+// Events thrown from frequently called engine hooks.
+// The hook sites check whether these events have any subscribers before constructing the event object
+// (see ExtensionStateBase::HasEventSubscribers()).
+enum class EngineEvent : uint32_t
+{
+	Tick,
+	DealDamage,
+	DealtDamage,
+	BeforeDealDamage,
+	ExecuteFunctor,
+	AfterExecuteFunctor,
+	Max = AfterExecuteFunctor
+};
+
+static_assert((uint32_t)EngineEvent::Max < 64, "Engine event mask must fit in an uint64_t");
+
+// Subscriber list of a single engine or mod event.
+// Subscribers are kept in a contiguous array sorted by descending priority
+// (subscribers with the same priority are called in subscription order).
+// The array is copy-on-write while a dispatch is in progress, so handlers may
+// freely subscribe or unsubscribe without invalidating the running dispatch.
+class SubscribableEvent : Noncopyable<SubscribableEvent>
+{
+public:
+	using SubscriptionIndex = uint32_t;
+	static constexpr int32_t DefaultPriority = 100;
+
+	struct Subscriber
+	{
+		int32_t Priority;
+		SubscriptionIndex Index;
+		// Registry reference of the handler function
+		int Handler;
+		bool Once;
+		// Mod that registered the handler (determined from the chunk name of the handler)
+		FixedString Mod;
+		// Usage stats entry of the mod
+		ModStats* Stats;
+	};
+
+	SubscribableEvent(EventDispatcher& dispatcher, FixedString const& name, std::optional<EngineEvent> engineEvent);
+
+	inline FixedString const& GetName() const
+	{
+		return name_;
+	}
+
+	inline bool HasSubscribers() const
+	{
+		return !subscribers_.empty();
+	}
+
+	inline Vector<Subscriber> const& GetSubscribers() const
+	{
+		return subscribers_;
+	}
+
+	SubscriptionIndex Subscribe(lua_State* L, int handlerIndex, int32_t priority, bool once);
+	bool Unsubscribe(lua_State* L, SubscriptionIndex index);
+	// Calls all subscribers with the event object at eventIndex.
+	// nativeEvent is only set when the event object is a C++ event, and is used for checking the propagation status
+	// without going through the property map.
+	void Throw(lua_State* L, int eventIndex, EventBase* nativeEvent);
+
+private:
+	EventDispatcher& dispatcher_;
+	FixedString name_;
+	std::optional<EngineEvent> engineEvent_;
+	Vector<Subscriber> subscribers_;
+	// Subscriber arrays that were replaced while a dispatch was iterating them
+	Vector<Vector<Subscriber>> retired_;
+	// Registry references of removed subscribers; released after the outermost dispatch finishes
+	Array<int> pendingReleases_;
+	SubscriptionIndex nextIndex_{ 1 };
+	uint32_t generation_{ 0 };
+	uint32_t enterCount_{ 0 };
+	// Is the current subscriber array referenced by an active dispatch?
+	bool shared_{ false };
+
+	// Marks the subscriber array as being iterated for the lifetime of the scope.
+	// The dispatch is finished even if a handler error unwinds the stack.
+	class DispatchScope : Noncopyable<DispatchScope>
+	{
+	public:
+		DispatchScope(SubscribableEvent& evt, lua_State* L);
+		~DispatchScope();
+
+	private:
+		SubscribableEvent& evt_;
+		lua_State* L_;
+	};
+
+	void BeginModification();
+	Subscriber const* FindSubscriber(SubscriptionIndex index) const;
+	bool IsStopped(lua_State* L, int eventIndex, EventBase* nativeEvent) const;
+	void CallSubscriber(lua_State* L, Subscriber const& sub, int eventIndex);
+	void FinishDispatch(lua_State* L);
+	void UpdateSubscriptionState();
+};
+
+class EventDispatcher
+{
+public:
+	EventDispatcher(ExtensionStateBase& state);
+	~EventDispatcher();
+
+	SubscribableEvent& GetOrCreate(FixedString const& name);
+	SubscribableEvent* Get(FixedString const& name);
+	void OnSubscriptionStateChanged(EngineEvent evt, bool hasSubscribers);
+
+	static FixedString GetHandlerMod(lua_State* L, int handlerIndex);
+
+private:
+	ExtensionStateBase& state_;
+	std::unordered_map<FixedString, std::unique_ptr<SubscribableEvent>> events_;
+};
+
+void RegisterEventsLibrary(lua_State* L);
+
+END_NS()
@@ -0,0 +1,343 @@
+BEGIN_NS(lua)
+
+static char const* EngineEventNames[] = {
+	"Tick",
+	"DealDamage",
+	"DealtDamage",
+	"BeforeDealDamage",
+	"ExecuteFunctor",
+	"AfterExecuteFunctor"
+};
+
+static_assert(std::size(EngineEventNames) == (std::size_t)EngineEvent::Max + 1, "Engine event name table out of sync");
+
+SubscribableEvent::SubscribableEvent(EventDispatcher& dispatcher, FixedString const& name, std::optional<EngineEvent> engineEvent)
+	: dispatcher_(dispatcher),
+	name_(name),
+	engineEvent_(engineEvent)
+{}
+
+SubscribableEvent::SubscriptionIndex SubscribableEvent::Subscribe(lua_State* L, int handlerIndex, int32_t priority, bool once)
+{
+	auto mod = EventDispatcher::GetHandlerMod(L, handlerIndex);
+	lua_pushvalue(L, handlerIndex);
+	auto handler = luaL_ref(L, LUA_REGISTRYINDEX);
+
+	BeginModification();
+
+	// Insert after all subscribers with the same or higher priority to keep subscription order
+	auto it = subscribers_.begin();
+	while (it != subscribers_.end() && it->Priority >= priority) {
+		it++;
+	}
+
+	auto index = nextIndex_++;
+	subscribers_.insert(it, Subscriber{
+		.Priority = priority,
+		.Index = index,
+		.Handler = handler,
+		.Once = once,
+		.Mod = mod,
+		.Stats = State::FromLua(L)->GetModAccounting().GetStats(mod)
+	});
+
+	UpdateSubscriptionState();
+	return index;
+}
+
+bool SubscribableEvent::Unsubscribe(lua_State* L, SubscriptionIndex index)
+{
+	for (std::size_t i = 0; i < subscribers_.size(); i++) {
+		if (subscribers_[i].Index == index) {
+			auto handler = subscribers_[i].Handler;
+			BeginModification();
+			subscribers_.erase(subscribers_.begin() + i);
+
+			if (enterCount_ > 0) {
+				pendingReleases_.push_back(handler);
+			} else {
+				luaL_unref(L, LUA_REGISTRYINDEX, handler);
+			}
+
+			UpdateSubscriptionState();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void SubscribableEvent::BeginModification()
+{
+	if (shared_) {
+		// An active dispatch is iterating the current array; keep it alive until the dispatch ends
+		// and continue working on a copy
+		retired_.push_back(std::move(subscribers_));
+		subscribers_ = retired_.back();
+		shared_ = false;
+	}
+
+	generation_++;
+}
+
+SubscribableEvent::Subscriber const* SubscribableEvent::FindSubscriber(SubscriptionIndex index) const
+{
+	for (auto const& sub : subscribers_) {
+		if (sub.Index == index) {
+			return &sub;
+		}
+	}
+
+	return nullptr;
+}
+
+bool SubscribableEvent::IsStopped(lua_State* L, int eventIndex, EventBase* nativeEvent) const
+{
+	if (nativeEvent != nullptr) {
+		return nativeEvent->Stopped;
+	}
+
+	if (lua_type(L, eventIndex) != LUA_TTABLE) {
+		return false;
+	}
+
+	lua_getfield(L, eventIndex, "Stopped");
+	bool stopped = lua_toboolean(L, -1);
+	lua_pop(L, 1);
+	return stopped;
+}
+
+void SubscribableEvent::CallSubscriber(lua_State* L, Subscriber const& sub, int eventIndex)
+{
+	ModAccountingScope _(State::FromLua(L)->GetModAccounting(), sub.Stats);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, sub.Handler);
+	lua_pushvalue(L, eventIndex);
+	if (CallWithTraceback(L, 1, 0) != 0) { // stack: errmsg
+		std::stringstream ss;
+		ss << "Error while dispatching event " << name_.GetStringView();
+		if (sub.Mod) {
+			ss << " (handler registered by " << sub.Mod.GetStringView() << ")";
+		}
+		ss << ": " << lua_tostring(L, -1);
+		LogLuaError(ss.str());
+		lua_pop(L, 1);
+	}
+}
+
+void SubscribableEvent::Throw(lua_State* L, int eventIndex, EventBase* nativeEvent)
+{
+	if (subscribers_.empty()) return;
+
+	eventIndex = lua_absindex(L, eventIndex);
+
+	// Iterate a snapshot of the subscriber list; any modification made by the handlers
+	// will copy the array instead of modifying it in-place
+	auto subscribers = subscribers_.data();
+	auto numSubscribers = subscribers_.size();
+	auto generation = generation_;
+	DispatchScope dispatch(*this, L);
+
+	for (std::size_t i = 0; i < numSubscribers; i++) {
+		if (IsStopped(L, eventIndex, nativeEvent)) {
+			break;
+		}
+
+		auto const& sub = subscribers[i];
+		// Skip handlers that were unsubscribed by a previous handler
+		if (generation != generation_ && FindSubscriber(sub.Index) == nullptr) {
+			continue;
+		}
+
+		if (sub.Once) {
+			// Removal is done before the call so reentrant throws won't call the handler again;
+			// the registry reference is only released after the dispatch finishes
+			Unsubscribe(L, sub.Index);
+		}
+
+		CallSubscriber(L, sub, eventIndex);
+	}
+}
+
+SubscribableEvent::DispatchScope::DispatchScope(SubscribableEvent& evt, lua_State* L)
+	: evt_(evt),
+	L_(L)
+{
+	evt_.shared_ = true;
+	evt_.enterCount_++;
+}
+
+SubscribableEvent::DispatchScope::~DispatchScope()
+{
+	evt_.FinishDispatch(L_);
+}
+
+void SubscribableEvent::FinishDispatch(lua_State* L)
+{
+	if (--enterCount_ > 0) return;
+
+	retired_.clear();
+	shared_ = false;
+
+	for (auto handler : pendingReleases_) {
+		luaL_unref(L, LUA_REGISTRYINDEX, handler);
+	}
+
+	pendingReleases_.clear();
+}
+
+void SubscribableEvent::UpdateSubscriptionState()
+{
+	if (engineEvent_) {
+		dispatcher_.OnSubscriptionStateChanged(*engineEvent_, !subscribers_.empty());
+	}
+}
+
+
+EventDispatcher::EventDispatcher(ExtensionStateBase& state)
+	: state_(state)
+{}
+
+EventDispatcher::~EventDispatcher()
+{
+	// Subscriptions of this Lua state are going away; make sure that hooks don't dispatch to the next state
+	for (uint32_t i = 0; i <= (uint32_t)EngineEvent::Max; i++) {
+		state_.SetEventSubscribers((EngineEvent)i, false);
+	}
+}
+
+SubscribableEvent& EventDispatcher::GetOrCreate(FixedString const& name)
+{
+	auto it = events_.find(name);
+	if (it != events_.end()) {
+		return *it->second;
+	}
+
+	std::optional<EngineEvent> engineEvent;
+	for (uint32_t i = 0; i <= (uint32_t)EngineEvent::Max; i++) {
+		if (name.GetStringView() == EngineEventNames[i]) {
+			engineEvent = (EngineEvent)i;
+			break;
+		}
+	}
+
+	auto evt = std::make_unique<SubscribableEvent>(*this, name, engineEvent);
+	auto& ref = *evt;
+	events_.insert(std::make_pair(name, std::move(evt)));
+	return ref;
+}
+
+SubscribableEvent* EventDispatcher::Get(FixedString const& name)
+{
+	auto it = events_.find(name);
+	if (it != events_.end()) {
+		return it->second.get();
+	} else {
+		return nullptr;
+	}
+}
+
+void EventDispatcher::OnSubscriptionStateChanged(EngineEvent evt, bool hasSubscribers)
+{
+	state_.SetEventSubscribers(evt, hasSubscribers);
+}
+
+FixedString EventDispatcher::GetHandlerMod(lua_State* L, int handlerIndex)
+{
+	lua_Debug ar;
+	lua_pushvalue(L, handlerIndex);
+	if (!lua_getinfo(L, ">S", &ar) || ar.source == nullptr) {
+		return FixedString{};
+	}
+
+	// Use the mod that loaded the chunk if it is known
+	auto mod = State::FromLua(L)->GetScriptOrigins().Find(ar.source);
+	if (mod) {
+		return mod;
+	}
+
+	// Mod scripts are loaded with a "<Mod directory>/<Script path>" chunk name
+	std::string_view source(ar.source);
+
+	if (source.starts_with("@")) {
+		source = source.substr(1);
+	} else if (source.starts_with("=")) {
+		return FixedString{};
+	}
+
+	auto sep = source.find('/');
+	if (sep == std::string_view::npos) {
+		return FixedString{};
+	}
+
+	return FixedString{ source.substr(0, sep) };
+}
+
+
+int SubscribeToEvent(lua_State* L)
+{
+	auto name = get<FixedString>(L, 1);
+	luaL_checktype(L, 2, LUA_TFUNCTION);
+	auto priority = (int32_t)luaL_optnumber(L, 3, SubscribableEvent::DefaultPriority);
+	auto once = lua_toboolean(L, 4) != 0;
+
+	auto& evt = State::FromLua(L)->GetEventDispatcher().GetOrCreate(name);
+	push(L, evt.Subscribe(L, 2, priority, once));
+	return 1;
+}
+
+int UnsubscribeFromEvent(lua_State* L)
+{
+	auto name = get<FixedString>(L, 1);
+	auto index = get<SubscribableEvent::SubscriptionIndex>(L, 2);
+
+	auto evt = State::FromLua(L)->GetEventDispatcher().Get(name);
+	push(L, evt != nullptr && evt->Unsubscribe(L, index));
+	return 1;
+}
+
+int ThrowLuaEvent(lua_State* L)
+{
+	auto name = get<FixedString>(L, 1);
+	luaL_checkany(L, 2);
+
+	auto evt = State::FromLua(L)->GetEventDispatcher().Get(name);
+	if (evt != nullptr) {
+		evt->Throw(L, 2, nullptr);
+	}
+
+	return 0;
+}
+
+// Calls a handler that is dispatched from Lua (eg. net listeners) and charges its usage to the mod that defined it.
+// Returns true on success, or false and the error message on failure.
+int CallModHandler(lua_State* L)
+{
+	luaL_checktype(L, 1, LUA_TFUNCTION);
+	auto numArgs = lua_gettop(L) - 1;
+	auto mod = EventDispatcher::GetHandlerMod(L, 1);
+
+	ModAccountingScope _(State::FromLua(L)->GetModAccounting(), mod);
+	if (CallWithTraceback(L, numArgs, 0) != 0) { // stack: errmsg
+		push(L, false);
+		lua_insert(L, -2);
+		return 2;
+	}
+
+	push(L, true);
+	return 1;
+}
+
+void RegisterEventsLibrary(lua_State* L)
+{
+	static const luaL_Reg eventsLib[] = {
+		{"Subscribe", SubscribeToEvent},
+		{"Unsubscribe", UnsubscribeFromEvent},
+		{"Throw", ThrowLuaEvent},
+		{"CallHandler", CallModHandler},
+		{0,0}
+	};
+
+	RegisterLib(L, "_Events", eventsLib);
+}
+
+END_NS()
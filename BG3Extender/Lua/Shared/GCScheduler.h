@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+
+BEGIN_NS(lua)
+
+// Runs the Lua garbage collector in time-budgeted slices at the end of each extender tick.
+// In the Incremental and Generational modes the automatic collector is tuned to start much later than
+// the scheduler does, so GC work normally happens in Update() and not during allocations in engine hooks;
+// it only acts as a backstop when Lua code allocates faster than the per-tick slices can keep up with.
+// The Automatic mode keeps the default Lua behavior (collection during allocations plus a fixed step each tick).
+class GCScheduler : Noncopyable<GCScheduler>
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	enum class Mode
+	{
+		Automatic,
+		Incremental,
+		Generational
+	};
+
+	static constexpr uint32_t DefaultBudgetUs = 1000;
+	// Minimum amount of GC work per tick, even if extender work used up the whole budget
+	static constexpr uint32_t MinSliceUs = 100;
+	// Amount of allocation debt (in KB) paid by a single incremental step
+	static constexpr int StepSizeKB = 16;
+	// Start a new incremental cycle when the heap has grown to this percentage of the live size after the last cycle
+	static constexpr int CyclePause = 150;
+	// Run a minor collection in generational mode when the heap has grown by this percentage
+	static constexpr int MinorCollectionGrowth = 20;
+	// If the heap grows beyond this percentage of the live size after the last cycle, the budget is ignored
+	// and the current cycle is completed in a single tick
+	static constexpr int EmergencyPause = 400;
+	// Don't enter emergency mode for small heaps
+	static constexpr int EmergencyMinHeapKB = 64 * 1024;
+	// Default pause of the Lua collector (LUAI_GCPAUSE), restored in Automatic mode
+	static constexpr int DefaultPause = 200;
+	// Pause of the automatic collector in Incremental mode
+	static constexpr int BackstopPause = EmergencyPause;
+	// Minor collection growth threshold of the automatic collector in Generational mode
+	static constexpr int BackstopMinorCollectionGrowth = 100;
+	// Lower bound of the live heap size used for the thresholds above, so small heaps aren't collected constantly
+	static constexpr int MinLiveHeapKB = 1024;
+
+	struct Stats
+	{
+		// Time spent in GC during the last tick
+		Clock::duration LastFrameTime{ 0 };
+		// Longest GC time during a single tick since the last ResetStats() call
+		Clock::duration MaxFrameTime{ 0 };
+		// Exponential moving average of the GC time per tick, in microseconds
+		double AverageFrameUs{ 0.0 };
+		uint32_t LastFrameSteps{ 0 };
+		uint64_t Frames{ 0 };
+		uint64_t Cycles{ 0 };
+		uint64_t EmergencyFrames{ 0 };
+	};
+
+	inline Mode GetMode() const
+	{
+		return mode_;
+	}
+
+	inline uint32_t GetBudget() const
+	{
+		return budgetUs_;
+	}
+
+	inline void SetBudget(uint32_t budgetUs)
+	{
+		budgetUs_ = budgetUs;
+	}
+
+	inline Stats const& GetStats() const
+	{
+		return stats_;
+	}
+
+	inline void ResetStats()
+	{
+		stats_.MaxFrameTime = Clock::duration{ 0 };
+	}
+
+	void SetMode(lua_State* L, Mode mode);
+	// Runs GC work in the time left from the tick budget; frameStart is the time when extender work started in this tick
+	void Update(lua_State* L, Clock::time_point frameStart);
+
+private:
+	Mode mode_{ Mode::Automatic };
+	uint32_t budgetUs_{ DefaultBudgetUs };
+	bool cycleActive_{ false };
+	// Heap size after the last completed cycle (or minor collection in generational mode)
+	int lastLiveKB_{ 0 };
+	// Measured duration of a generational step, in microseconds
+	double generationalStepUs_{ 0.0 };
+	Stats stats_;
+
+	uint32_t RunIncremental(lua_State* L, Clock::time_point deadline, bool emergency);
+	uint32_t RunGenerational(lua_State* L, Clock::time_point deadline, bool emergency);
+	void OnCycleCompleted(lua_State* L);
+};
+
+END_NS()
@@ -0,0 +1,114 @@
+#include <Lua/Shared/GCScheduler.h>
+
+BEGIN_NS(lua)
+
+void GCScheduler::SetMode(lua_State* L, Mode mode)
+{
+	switch (mode) {
+	case Mode::Automatic:
+		lua_gc(L, LUA_GCINC, DefaultPause, 0, 0);
+		lua_gc(L, LUA_GCRESTART);
+		break;
+
+	// The automatic collector keeps running with thresholds well above the ones used by Update(),
+	// so heap growth between ticks is still bounded
+	case Mode::Incremental:
+		lua_gc(L, LUA_GCINC, BackstopPause, 0, 0);
+		lua_gc(L, LUA_GCRESTART);
+		break;
+
+	case Mode::Generational:
+		lua_gc(L, LUA_GCGEN, BackstopMinorCollectionGrowth, 0);
+		lua_gc(L, LUA_GCRESTART);
+		break;
+	}
+
+	mode_ = mode;
+	cycleActive_ = false;
+	lastLiveKB_ = lua_gc(L, LUA_GCCOUNT);
+}
+
+void GCScheduler::Update(lua_State* L, Clock::time_point frameStart)
+{
+	auto start = Clock::now();
+	uint32_t steps{ 0 };
+
+	if (mode_ == Mode::Automatic) {
+		// Returns 1 when the step finished a cycle
+		if (lua_gc(L, LUA_GCSTEP, 10)) {
+			OnCycleCompleted(L);
+		}
+		steps = 1;
+	} else {
+		int64_t heapKB = lua_gc(L, LUA_GCCOUNT);
+		int64_t liveKB = std::max(lastLiveKB_, MinLiveHeapKB);
+		bool emergency = heapKB >= EmergencyMinHeapKB && heapKB * 100 >= liveKB * EmergencyPause;
+		if (emergency) {
+			stats_.EmergencyFrames++;
+		}
+
+		// Use the time left from the budget after extender work in this tick
+		auto deadline = std::max(frameStart + std::chrono::microseconds(budgetUs_), start + std::chrono::microseconds(MinSliceUs));
+
+		if (mode_ == Mode::Incremental) {
+			if (cycleActive_ || emergency || heapKB * 100 >= liveKB * CyclePause) {
+				steps = RunIncremental(L, deadline, emergency);
+			}
+		} else {
+			if (emergency || heapKB * 100 >= liveKB * (100 + MinorCollectionGrowth)) {
+				steps = RunGenerational(L, deadline, emergency);
+			}
+		}
+	}
+
+	auto time = Clock::now() - start;
+	auto timeUs = std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(time).count();
+	stats_.LastFrameTime = time;
+	stats_.MaxFrameTime = std::max(stats_.MaxFrameTime, time);
+	stats_.AverageFrameUs = stats_.AverageFrameUs * 0.95 + timeUs * 0.05;
+	stats_.LastFrameSteps = steps;
+	stats_.Frames++;
+}
+
+uint32_t GCScheduler::RunIncremental(lua_State* L, Clock::time_point deadline, bool emergency)
+{
+	uint32_t steps{ 0 };
+	cycleActive_ = true;
+	do {
+		steps++;
+		// Returns 1 when the step finished a cycle
+		if (lua_gc(L, LUA_GCSTEP, StepSizeKB)) {
+			OnCycleCompleted(L);
+			break;
+		}
+	} while (emergency || Clock::now() < deadline);
+
+	return steps;
+}
+
+uint32_t GCScheduler::RunGenerational(lua_State* L, Clock::time_point deadline, bool emergency)
+{
+	// Minor collections cannot be split into slices; skip the collection if the last one
+	// took longer than the time left in this tick
+	auto start = Clock::now();
+	auto remainingUs = std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(deadline - start).count();
+	if (!emergency && generationalStepUs_ > remainingUs) {
+		// Decay the estimate so a single slow collection doesn't block collections indefinitely
+		generationalStepUs_ *= 0.9;
+		return 0;
+	}
+
+	lua_gc(L, LUA_GCSTEP, 0);
+	generationalStepUs_ = std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(Clock::now() - start).count();
+	OnCycleCompleted(L);
+	return 1;
+}
+
+void GCScheduler::OnCycleCompleted(lua_State* L)
+{
+	cycleActive_ = false;
+	lastLiveKB_ = lua_gc(L, LUA_GCCOUNT);
+	stats_.Cycles++;
+}
+
+END_NS()
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+
+BEGIN_NS(lua)
+
+// Size-class pooled allocator for Lua VM memory.
+// Small blocks (up to MaxSmallSize bytes) are carved from fixed size slabs and recycled through per-class
+// free lists; larger blocks go to the game allocator. Since Lua passes the old block size on free/realloc,
+// blocks don't need a header to determine their size class.
+// Slabs are only returned to the game allocator by Trim(), which is called after completed GC cycles.
+// A Lua state is only accessed by one thread at a time (see LuaStatePin), so the pools aren't synchronized.
+class LuaPoolAllocator : Noncopyable<LuaPoolAllocator>
+{
+public:
+	static constexpr std::size_t Granularity = 16;
+	static constexpr std::size_t MaxSmallSize = 256;
+	static constexpr std::size_t NumSizeClasses = MaxSmallSize / Granularity;
+	static constexpr std::size_t SlabSize = 0x10000;
+
+	struct SizeClassStats
+	{
+		// Number of blocks currently allocated from the class
+		uint64_t Blocks{ 0 };
+		// Number of bytes requested by Lua for the allocated blocks
+		uint64_t RequestedBytes{ 0 };
+		// Number of bytes reserved by slabs of this class
+		uint64_t SlabBytes{ 0 };
+		uint64_t TotalAllocations{ 0 };
+	};
+
+	struct Stats
+	{
+		std::array<SizeClassStats, NumSizeClasses> SizeClasses;
+		uint64_t LargeBlocks{ 0 };
+		uint64_t LargeBytes{ 0 };
+		// Number of bytes currently allocated by Lua (small and large)
+		uint64_t UsedBytes{ 0 };
+		uint64_t PeakUsedBytes{ 0 };
+		// Number of bytes reserved from the game allocator (slabs and large blocks)
+		uint64_t ReservedBytes{ 0 };
+		uint64_t PeakReservedBytes{ 0 };
+		// Number of slab bytes returned to the game allocator by Trim()
+		uint64_t TrimmedBytes{ 0 };
+	};
+
+	LuaPoolAllocator();
+	~LuaPoolAllocator();
+
+	void* Reallocate(void* ptr, std::size_t oldSize, std::size_t newSize);
+	// Returns slabs that have no allocated blocks to the game allocator; returns the number of bytes released.
+	// Walks the free lists, so it should only be called when a lot of memory may have been freed (eg. after a GC cycle).
+	std::size_t Trim();
+
+	inline Stats const& GetStats() const
+	{
+		return stats_;
+	}
+
+	inline static constexpr std::size_t GetClassSize(std::size_t sizeClass)
+	{
+		return (sizeClass + 1) * Granularity;
+	}
+
+	// lua_Alloc function using a LuaPoolAllocator instance as userdata
+	static void* LuaAlloc(void* ud, void* ptr, std::size_t osize, std::size_t nsize);
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* Next;
+	};
+
+	struct SizeClass
+	{
+		FreeBlock* FreeList{ nullptr };
+		// Unused tail of the current slab
+		uint8_t* Bump{ nullptr };
+		uint8_t* BumpEnd{ nullptr };
+		std::vector<uint8_t*> Slabs;
+	};
+
+	std::array<SizeClass, NumSizeClasses> classes_;
+	Stats stats_;
+
+	inline static std::size_t GetSizeClass(std::size_t size)
+	{
+		return (size - 1) / Granularity;
+	}
+
+	void* AllocateSmall(std::size_t sizeClass, std::size_t size);
+	void FreeSmall(void* ptr, std::size_t sizeClass, std::size_t size);
+	void* AllocateLarge(std::size_t size);
+	void FreeLarge(void* ptr, std::size_t size);
+	void AllocateSlab(SizeClass& cls, std::size_t sizeClass);
+	std::size_t TrimClass(SizeClass& cls, std::size_t sizeClass);
+	void OnUsageChanged();
+};
+
+END_NS()
@@ -0,0 +1,236 @@
+#include <Lua/Shared/LuaAllocator.h>
+
+BEGIN_NS(lua)
+
+LuaPoolAllocator::LuaPoolAllocator()
+{}
+
+LuaPoolAllocator::~LuaPoolAllocator()
+{
+	for (auto const& cls : classes_) {
+		for (auto slab : cls.Slabs) {
+			GameFree(slab);
+		}
+	}
+}
+
+void* LuaPoolAllocator::Reallocate(void* ptr, std::size_t oldSize, std::size_t newSize)
+{
+	if (newSize == 0) {
+		if (ptr != nullptr) {
+			if (oldSize <= MaxSmallSize) {
+				FreeSmall(ptr, GetSizeClass(oldSize), oldSize);
+			} else {
+				FreeLarge(ptr, oldSize);
+			}
+		}
+
+		return nullptr;
+	}
+
+	if (ptr == nullptr) {
+		if (newSize <= MaxSmallSize) {
+			return AllocateSmall(GetSizeClass(newSize), newSize);
+		} else {
+			return AllocateLarge(newSize);
+		}
+	}
+
+	// Resizing within the same size class doesn't need to move the block
+	if (oldSize <= MaxSmallSize && newSize <= MaxSmallSize && GetSizeClass(oldSize) == GetSizeClass(newSize)) {
+		auto& stats = stats_.SizeClasses[GetSizeClass(oldSize)];
+		stats.RequestedBytes += newSize - oldSize;
+		stats_.UsedBytes += newSize - oldSize;
+		OnUsageChanged();
+		return ptr;
+	}
+
+	void* newBuf;
+	if (newSize <= MaxSmallSize) {
+		newBuf = AllocateSmall(GetSizeClass(newSize), newSize);
+	} else {
+		newBuf = AllocateLarge(newSize);
+	}
+
+	if (newBuf == nullptr) {
+		// Lua expects the old block to remain valid if the reallocation fails
+		return nullptr;
+	}
+
+	memcpy(newBuf, ptr, std::min(oldSize, newSize));
+
+	if (oldSize <= MaxSmallSize) {
+		FreeSmall(ptr, GetSizeClass(oldSize), oldSize);
+	} else {
+		FreeLarge(ptr, oldSize);
+	}
+
+	return newBuf;
+}
+
+void* LuaPoolAllocator::AllocateSmall(std::size_t sizeClass, std::size_t size)
+{
+	auto& cls = classes_[sizeClass];
+	void* block;
+	if (cls.FreeList != nullptr) {
+		block = cls.FreeList;
+		cls.FreeList = cls.FreeList->Next;
+	} else {
+		if (cls.Bump == cls.BumpEnd) {
+			AllocateSlab(cls, sizeClass);
+			if (cls.Bump == nullptr) return nullptr;
+		}
+
+		block = cls.Bump;
+		cls.Bump += GetClassSize(sizeClass);
+	}
+
+	auto& stats = stats_.SizeClasses[sizeClass];
+	stats.Blocks++;
+	stats.RequestedBytes += size;
+	stats.TotalAllocations++;
+	stats_.UsedBytes += size;
+	OnUsageChanged();
+	return block;
+}
+
+void LuaPoolAllocator::FreeSmall(void* ptr, std::size_t sizeClass, std::size_t size)
+{
+	auto& cls = classes_[sizeClass];
+	auto block = reinterpret_cast<FreeBlock*>(ptr);
+	block->Next = cls.FreeList;
+	cls.FreeList = block;
+
+	auto& stats = stats_.SizeClasses[sizeClass];
+	stats.Blocks--;
+	stats.RequestedBytes -= size;
+	stats_.UsedBytes -= size;
+}
+
+void* LuaPoolAllocator::AllocateLarge(std::size_t size)
+{
+	auto block = GameAllocRaw(size);
+	if (block == nullptr) return nullptr;
+
+	stats_.LargeBlocks++;
+	stats_.LargeBytes += size;
+	stats_.UsedBytes += size;
+	stats_.ReservedBytes += size;
+	OnUsageChanged();
+	return block;
+}
+
+void LuaPoolAllocator::FreeLarge(void* ptr, std::size_t size)
+{
+	GameFree(ptr);
+	stats_.LargeBlocks--;
+	stats_.LargeBytes -= size;
+	stats_.UsedBytes -= size;
+	stats_.ReservedBytes -= size;
+}
+
+void LuaPoolAllocator::AllocateSlab(SizeClass& cls, std::size_t sizeClass)
+{
+	auto slab = reinterpret_cast<uint8_t*>(GameAllocRaw(SlabSize));
+	if (slab == nullptr) {
+		cls.Bump = cls.BumpEnd = nullptr;
+		return;
+	}
+
+	cls.Slabs.push_back(slab);
+	auto classSize = GetClassSize(sizeClass);
+	cls.Bump = slab;
+	cls.BumpEnd = slab + (SlabSize / classSize) * classSize;
+
+	stats_.SizeClasses[sizeClass].SlabBytes += SlabSize;
+	stats_.ReservedBytes += SlabSize;
+}
+
+std::size_t LuaPoolAllocator::Trim()
+{
+	std::size_t released{ 0 };
+	for (std::size_t i = 0; i < NumSizeClasses; i++) {
+		released += TrimClass(classes_[i], i);
+	}
+
+	stats_.TrimmedBytes += released;
+	return released;
+}
+
+std::size_t LuaPoolAllocator::TrimClass(SizeClass& cls, std::size_t sizeClass)
+{
+	auto classSize = GetClassSize(sizeClass);
+	auto blocksPerSlab = SlabSize / classSize;
+	auto carvedBlocks = cls.Slabs.size() * blocksPerSlab - (cls.BumpEnd - cls.Bump) / classSize;
+	if (carvedBlocks == stats_.SizeClasses[sizeClass].Blocks) {
+		// Nothing on the free list
+		return 0;
+	}
+
+	// Count free blocks per slab; a slab can be released if all blocks carved from it are free
+	std::sort(cls.Slabs.begin(), cls.Slabs.end());
+	std::vector<std::size_t> freeBlocks(cls.Slabs.size());
+	auto findSlab = [&cls](void* block) {
+		return std::upper_bound(cls.Slabs.begin(), cls.Slabs.end(), reinterpret_cast<uint8_t*>(block)) - cls.Slabs.begin() - 1;
+	};
+
+	for (auto block = cls.FreeList; block != nullptr; block = block->Next) {
+		freeBlocks[findSlab(block)]++;
+	}
+
+	std::ptrdiff_t currentSlab = (cls.Bump != cls.BumpEnd) ? findSlab(cls.Bump) : -1;
+	std::vector<bool> releasable(cls.Slabs.size());
+	bool anyReleasable{ false };
+	for (std::size_t i = 0; i < cls.Slabs.size(); i++) {
+		auto slabCarved = ((std::ptrdiff_t)i == currentSlab) ? (cls.Bump - cls.Slabs[i]) / classSize : blocksPerSlab;
+		releasable[i] = (freeBlocks[i] == slabCarved);
+		anyReleasable = anyReleasable || releasable[i];
+	}
+
+	if (!anyReleasable) {
+		return 0;
+	}
+
+	// Unlink blocks of released slabs, keeping the order of the remaining free list entries
+	FreeBlock** link = &cls.FreeList;
+	while (*link != nullptr) {
+		if (releasable[findSlab(*link)]) {
+			*link = (*link)->Next;
+		} else {
+			link = &(*link)->Next;
+		}
+	}
+
+	if (currentSlab >= 0 && releasable[currentSlab]) {
+		cls.Bump = cls.BumpEnd = nullptr;
+	}
+
+	std::size_t kept{ 0 };
+	for (std::size_t i = 0; i < cls.Slabs.size(); i++) {
+		if (releasable[i]) {
+			GameFree(cls.Slabs[i]);
+		} else {
+			cls.Slabs[kept++] = cls.Slabs[i];
+		}
+	}
+
+	auto released = (cls.Slabs.size() - kept) * SlabSize;
+	cls.Slabs.resize(kept);
+	stats_.SizeClasses[sizeClass].SlabBytes -= released;
+	stats_.ReservedBytes -= released;
+	return released;
+}
+
+void LuaPoolAllocator::OnUsageChanged()
+{
+	stats_.PeakUsedBytes = std::max(stats_.PeakUsedBytes, stats_.UsedBytes);
+	stats_.PeakReservedBytes = std::max(stats_.PeakReservedBytes, stats_.ReservedBytes);
+}
+
+void* LuaPoolAllocator::LuaAlloc(void* ud, void* ptr, std::size_t osize, std::size_t nsize)
+{
+	// When ptr is null, osize is the type of the object being allocated
+	return static_cast<LuaPoolAllocator*>(ud)->Reallocate(ptr, ptr ? osize : 0, nsize);
+}
+
+END_NS()
@@ -1,5 +1,6 @@
 #include <stdafx.h>
 #include <Lua/Shared/LuaBundle.h>
+#include <Lua/Shared/LuaBundleFormat.h>
 #include <filesystem>
 
 BEGIN_NS(lua)
@@ -11,48 +12,171 @@ void LuaBundle::SetResourcePath(std::wstring const& path)
 
 bool LuaBundle::LoadBuiltinResource(int resourceId)
 {
-	auto res = GetExeResource(resourceId);
+	auto res = GetExeResourceView(resourceId);
 	if (res) {
-		LoadBuffer(std::span((uint8_t*)res->data(), res->size()));
-		return true;
+		return LoadBuffer(std::span((uint8_t const*)res->data(), res->size()));
 	} else {
 		return false;
 	}
 }
 
-void LuaBundle::LoadBuffer(std::span<uint8_t> const& buf)
+bool LuaBundle::LoadBuffer(std::span<uint8_t const> const& buf)
+{
+	index_.clear();
+	decompressed_.clear();
+
+	bool loaded;
+	if (buf.size() >= sizeof(bundle::Header) && reinterpret_cast<bundle::Header const*>(buf.data())->Magic == bundle::Magic) {
+		loaded = LoadV2(buf);
+	} else {
+		loaded = LoadV1(buf);
+	}
+
+	if (!loaded) {
+		index_.clear();
+		return false;
+	}
+
+	std::sort(index_.begin(), index_.end(), [](IndexEntry const& a, IndexEntry const& b) {
+		return a.PathHash < b.PathHash;
+	});
+	return true;
+}
+
+bool LuaBundle::LoadV1(std::span<uint8_t const> const& buf)
 {
 	std::size_t offset = 0;
-	while (offset < buf.size()) {
-		auto hdr = reinterpret_cast<ResourceHeader*>(buf.data() + offset);
-		STDString path((char const*)buf.data() + offset + sizeof(ResourceHeader), hdr->FileNameSize);
-		STDString body((char const*)buf.data() + offset + sizeof(ResourceHeader) + hdr->FileNameSize, hdr->FileSize);
-		resources_.insert(std::make_pair(path, body));
-		offset += sizeof(ResourceHeader) + hdr->FileNameSize + hdr->FileSize;
+	while (offset + sizeof(bundle::V1RecordHeader) <= buf.size()) {
+		auto hdr = reinterpret_cast<bundle::V1RecordHeader const*>(buf.data() + offset);
+		auto pathOffset = offset + sizeof(bundle::V1RecordHeader);
+		auto bodyOffset = pathOffset + hdr->FileNameSize;
+		if (bodyOffset + hdr->FileSize > buf.size()) {
+			ERR("Lua bundle truncated at offset %d", (int)offset);
+			return false;
+		}
+
+		std::string_view path((char const*)buf.data() + pathOffset, hdr->FileNameSize);
+		index_.push_back(IndexEntry{
+			.PathHash = bundle::HashPath(path),
+			.Path = path,
+			.Body = std::string_view((char const*)buf.data() + bodyOffset, hdr->FileSize)
+		});
+		offset = bodyOffset + hdr->FileSize;
+	}
+
+	return true;
+}
+
+bool LuaBundle::LoadV2(std::span<uint8_t const> const& buf)
+{
+	auto header = reinterpret_cast<bundle::Header const*>(buf.data());
+	if (header->Version != bundle::Version) {
+		ERR("Unsupported Lua bundle version %d", header->Version);
+		return false;
+	}
+
+	if (header->DataSize != buf.size() - sizeof(bundle::Header)
+		|| header->NumEntries > header->DataSize / sizeof(bundle::TocEntry)) {
+		ERR("Lua bundle size mismatch");
+		return false;
+	}
+
+	if (bundle::Crc32(buf.data() + sizeof(bundle::Header), buf.size() - sizeof(bundle::Header)) != header->Crc) {
+		ERR("Lua bundle CRC mismatch");
+		return false;
 	}
+
+	std::span<bundle::TocEntry const> toc(
+		reinterpret_cast<bundle::TocEntry const*>(buf.data() + sizeof(bundle::Header)), header->NumEntries);
+
+	std::size_t decompressedSize{ 0 };
+	for (auto const& entry : toc) {
+		if ((std::size_t)entry.PathOffset + entry.PathSize > buf.size()
+			|| (std::size_t)entry.Offset + entry.Size > buf.size()) {
+			ERR("Lua bundle entry out of bounds");
+			return false;
+		}
+
+		if (entry.Flags & bundle::EntryCompressed) {
+			decompressedSize += entry.UncompressedSize;
+		}
+	}
+
+	// Views point into this buffer, so it must not be resized after decompression starts
+	decompressed_.resize(decompressedSize);
+	std::size_t decompressedOffset{ 0 };
+	index_.reserve(toc.size());
+	for (auto const& entry : toc) {
+		std::string_view path((char const*)buf.data() + entry.PathOffset, entry.PathSize);
+		std::string_view body;
+		if (entry.Flags & bundle::EntryCompressed) {
+			auto out = decompressed_.data() + decompressedOffset;
+			if (!bundle::DecompressEntry(buf.data() + entry.Offset, entry.Size, out, entry.UncompressedSize)) {
+				ERR("Failed to decompress Lua bundle entry '%s'", STDString(path).c_str());
+				return false;
+			}
+
+			body = std::string_view(out, entry.UncompressedSize);
+			decompressedOffset += entry.UncompressedSize;
+		} else {
+			body = std::string_view((char const*)buf.data() + entry.Offset, entry.Size);
+		}
+
+		index_.push_back(IndexEntry{
+			.PathHash = entry.PathHash,
+			.Path = path,
+			.Body = body
+		});
+	}
+
+	return true;
 }
 
-std::optional<STDString> LuaBundle::GetResource(STDString const& path) const
+std::optional<std::string_view> LuaBundle::GetResource(std::string_view path) const
 {
 	if (!resourcePath_.empty()) {
-		auto resPath = resourcePath_ + L"/" + FromUTF8(path).c_str();
-		std::ifstream f(resPath.c_str(), std::ios::in | std::ios::binary);
-		if (f.good()) {
-			STDString body;
-			f.seekg(0, std::ios::end);
-			body.resize((uint32_t)f.tellg());
-			f.seekg(0, std::ios::beg);
-			f.read(body.data(), body.size());
-			return body;
+		auto overridden = GetOverride(path);
+		if (overridden) {
+			return overridden;
 		}
 	}
 
-	auto it = resources_.find(path);
-	if (it != resources_.end()) {
-		return it->second;
-	} else {
+	auto hash = bundle::HashPath(path);
+	auto it = std::lower_bound(index_.begin(), index_.end(), hash, [](IndexEntry const& entry, uint64_t hash) {
+		return entry.PathHash < hash;
+	});
+
+	for (; it != index_.end() && it->PathHash == hash; ++it) {
+		if (it->Path == path) {
+			return it->Body;
+		}
+	}
+
+	return {};
+}
+
+std::optional<std::string_view> LuaBundle::GetOverride(std::string_view path) const
+{
+	auto resPath = resourcePath_ + L"/" + FromUTF8(path).c_str();
+	std::ifstream f(resPath.c_str(), std::ios::in | std::ios::binary);
+	if (!f.good()) {
 		return {};
 	}
+
+	STDString body;
+	f.seekg(0, std::ios::end);
+	body.resize((uint32_t)f.tellg());
+	f.seekg(0, std::ios::beg);
+	f.read(body.data(), body.size());
+
+	// Keep the previous copy if the file didn't change, so views returned earlier remain valid
+	std::lock_guard _(overridesMutex_);
+	auto& cached = overrides_[STDString(path)];
+	if (cached != body) {
+		cached = std::move(body);
+	}
+
+	return std::string_view(cached);
 }
 
 END_NS()
@@ -1,30 +1,56 @@
 #pragma once
 
 #include <GameDefinitions/Base/Base.h>
+#include <mutex>
 #include <unordered_map>
 #include <span>
+#include <string_view>
 #include <vector>
 
 BEGIN_NS(lua)
 
+// Bundle of builtin Lua scripts.
+// Both the legacy (v1) and indexed (v2) bundle formats are supported (see LuaBundleFormat.h).
+// Uncompressed resources are not copied out of the bundle buffer; the buffer is indexed by a table sorted by
+// path hash and GetResource() returns views into it.
 class LuaBundle
 {
 public:
 	void SetResourcePath(std::wstring const& path);
 	bool LoadBuiltinResource(int resourceId);
-	void LoadBuffer(std::span<uint8_t> const& buf);
+	// Indexes a bundle buffer; the buffer must stay valid while the bundle is in use
+	bool LoadBuffer(std::span<uint8_t const> const& buf);
 
-	std::optional<STDString> GetResource(STDString const& path) const;
+	// Returns the contents of a resource. If a resource path override is set, files found in the override directory
+	// take precedence; views of overridden files stay valid until the file is reloaded with different contents.
+	std::optional<std::string_view> GetResource(std::string_view path) const;
 
-private:
-	std::unordered_map<STDString, STDString> resources_;
-	std::wstring resourcePath_;
+	template <class Fun>
+	void ForEach(Fun fun) const
+	{
+		for (auto const& entry : index_) {
+			fun(entry.Path, entry.Body);
+		}
+	}
 
-	struct ResourceHeader
+private:
+	struct IndexEntry
 	{
-		uint32_t FileNameSize;
-		uint32_t FileSize;
+		uint64_t PathHash;
+		std::string_view Path;
+		std::string_view Body;
 	};
+
+	std::vector<IndexEntry> index_;
+	// Storage of compressed resources after decompression
+	std::vector<char> decompressed_;
+	std::wstring resourcePath_;
+	mutable std::mutex overridesMutex_;
+	mutable std::unordered_map<STDString, STDString> overrides_;
+
+	bool LoadV1(std::span<uint8_t const> const& buf);
+	bool LoadV2(std::span<uint8_t const> const& buf);
+	std::optional<std::string_view> GetOverride(std::string_view path) const;
 };
 
 END_NS()
@@ -0,0 +1,229 @@
+#pragma once
+
+// Builtin Lua bundle format; shared by ResourceBundler and LuaBundle.
+//
+// Version 1 bundles are a sequence of {FileNameSize, FileSize, name, body} records without a header.
+// Version 2 bundles start with a Header, followed by a table of contents sorted by path hash, the path strings
+// and the file data. Entries can be compressed individually. The CRC covers everything after the header.
+
+#include <Windows.h>
+#include <compressapi.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bg3se::lua::bundle
+{
+	static constexpr uint32_t Magic = 0x42455342; // "BSEB"
+	static constexpr uint32_t Version = 2;
+	static constexpr DWORD CompressionAlgorithm = COMPRESS_ALGORITHM_XPRESS_HUFF;
+
+	enum EntryFlags : uint32_t
+	{
+		EntryCompressed = 1 << 0
+	};
+
+	struct V1RecordHeader
+	{
+		uint32_t FileNameSize;
+		uint32_t FileSize;
+	};
+
+	struct Header
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t NumEntries;
+		uint32_t Crc;
+		// Size of the bundle after the header
+		uint64_t DataSize;
+	};
+
+	struct TocEntry
+	{
+		uint64_t PathHash;
+		// Offsets are relative to the start of the bundle
+		uint32_t PathOffset;
+		uint32_t PathSize;
+		uint32_t Offset;
+		// Size of the data stored in the bundle
+		uint32_t Size;
+		uint32_t UncompressedSize;
+		uint32_t Flags;
+	};
+
+	// 64-bit FNV-1a
+	inline uint64_t HashPath(std::string_view path)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (auto c : path) {
+			hash = (hash ^ (uint8_t)c) * 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	inline constexpr std::array<uint32_t, 256> MakeCrcTable()
+	{
+		std::array<uint32_t, 256> table{};
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++) {
+				c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+			}
+			table[i] = c;
+		}
+		return table;
+	}
+
+	inline constexpr std::array<uint32_t, 256> CrcTable = MakeCrcTable();
+
+	inline uint32_t Crc32(uint8_t const* data, std::size_t size)
+	{
+		uint32_t crc = 0xFFFFFFFFu;
+		for (std::size_t i = 0; i < size; i++) {
+			crc = CrcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return crc ^ 0xFFFFFFFFu;
+	}
+
+	inline bool CompressEntry(std::string_view data, std::vector<uint8_t>& out)
+	{
+		COMPRESSOR_HANDLE compressor;
+		if (!CreateCompressor(CompressionAlgorithm, nullptr, &compressor)) {
+			return false;
+		}
+
+		// Query the required buffer size first
+		SIZE_T compressedSize{ 0 };
+		Compress(compressor, data.data(), data.size(), nullptr, 0, &compressedSize);
+		out.resize(compressedSize);
+		auto ok = Compress(compressor, data.data(), data.size(), out.data(), out.size(), &compressedSize);
+		CloseCompressor(compressor);
+
+		out.resize(ok ? compressedSize : 0);
+		return ok == TRUE;
+	}
+
+	inline bool DecompressEntry(uint8_t const* data, std::size_t size, char* out, std::size_t uncompressedSize)
+	{
+		DECOMPRESSOR_HANDLE decompressor;
+		if (!CreateDecompressor(CompressionAlgorithm, nullptr, &decompressor)) {
+			return false;
+		}
+
+		SIZE_T written{ 0 };
+		auto ok = Decompress(decompressor, data, size, out, uncompressedSize, &written);
+		CloseDecompressor(decompressor);
+		return ok == TRUE && written == uncompressedSize;
+	}
+
+	class Writer
+	{
+	public:
+		void Add(std::string path, std::string body)
+		{
+			files_.push_back({ std::move(path), std::move(body) });
+		}
+
+		std::vector<uint8_t> WriteV1() const
+		{
+			std::vector<uint8_t> bundle;
+			for (auto const& file : files_) {
+				V1RecordHeader hdr{ (uint32_t)file.Path.size(), (uint32_t)file.Body.size() };
+				Append(bundle, &hdr, sizeof(hdr));
+				Append(bundle, file.Path.data(), file.Path.size());
+				Append(bundle, file.Body.data(), file.Body.size());
+			}
+
+			return bundle;
+		}
+
+		std::vector<uint8_t> WriteV2(bool compress) const
+		{
+			struct PendingEntry
+			{
+				File const* Source;
+				uint64_t Hash;
+				std::vector<uint8_t> Compressed;
+			};
+
+			std::vector<PendingEntry> entries;
+			for (auto const& file : files_) {
+				PendingEntry entry{ &file, HashPath(file.Path) };
+				// Only keep the compressed data if it is actually smaller
+				if (compress && (!CompressEntry(file.Body, entry.Compressed) || entry.Compressed.size() >= file.Body.size())) {
+					entry.Compressed.clear();
+				}
+				entries.push_back(std::move(entry));
+			}
+
+			std::sort(entries.begin(), entries.end(), [](PendingEntry const& a, PendingEntry const& b) {
+				return a.Hash < b.Hash;
+			});
+
+			std::vector<TocEntry> toc;
+			std::size_t pathOffset = sizeof(Header) + entries.size() * sizeof(TocEntry);
+			std::size_t dataOffset = pathOffset;
+			for (auto const& entry : entries) {
+				dataOffset += entry.Source->Path.size();
+			}
+
+			for (auto const& entry : entries) {
+				auto compressed = !entry.Compressed.empty();
+				TocEntry tocEntry{
+					.PathHash = entry.Hash,
+					.PathOffset = (uint32_t)pathOffset,
+					.PathSize = (uint32_t)entry.Source->Path.size(),
+					.Offset = (uint32_t)dataOffset,
+					.Size = (uint32_t)(compressed ? entry.Compressed.size() : entry.Source->Body.size()),
+					.UncompressedSize = (uint32_t)entry.Source->Body.size(),
+					.Flags = compressed ? EntryCompressed : 0u
+				};
+				pathOffset += tocEntry.PathSize;
+				dataOffset += tocEntry.Size;
+				toc.push_back(tocEntry);
+			}
+
+			std::vector<uint8_t> bundle;
+			Header header{ Magic, Version, (uint32_t)entries.size(), 0, 0 };
+			Append(bundle, &header, sizeof(header));
+			Append(bundle, toc.data(), toc.size() * sizeof(TocEntry));
+			for (auto const& entry : entries) {
+				Append(bundle, entry.Source->Path.data(), entry.Source->Path.size());
+			}
+			for (auto const& entry : entries) {
+				if (entry.Compressed.empty()) {
+					Append(bundle, entry.Source->Body.data(), entry.Source->Body.size());
+				} else {
+					Append(bundle, entry.Compressed.data(), entry.Compressed.size());
+				}
+			}
+
+			auto hdr = reinterpret_cast<Header*>(bundle.data());
+			hdr->DataSize = bundle.size() - sizeof(Header);
+			hdr->Crc = Crc32(bundle.data() + sizeof(Header), bundle.size() - sizeof(Header));
+			return bundle;
+		}
+
+	private:
+		struct File
+		{
+			std::string Path;
+			std::string Body;
+		};
+
+		std::vector<File> files_;
+
+		static void Append(std::vector<uint8_t>& buf, void const* data, std::size_t size)
+		{
+			auto offset = buf.size();
+			buf.resize(offset + size);
+			if (size > 0) {
+				memcpy(buf.data() + offset, data, size);
+			}
+		}
+	};
+}
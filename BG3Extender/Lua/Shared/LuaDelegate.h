@@ -2,6 +2,8 @@
 
 BEGIN_NS(lua)
 
+struct ModStats;
+
 template <class TArgs, class TReturn>
 struct ProtectedFunctionCaller;
 
@@ -57,6 +59,16 @@ public:
         ref_.Push();
     }
 
+    inline RegistryEntry const& GetRegistryEntry() const
+    {
+        return ref_;
+    }
+
+    inline RegistryEntry& GetRegistryEntry()
+    {
+        return ref_;
+    }
+
     TRet Call(TArgs... args)
     {
 		if constexpr (std::is_same_v<TRet, void>) {
@@ -90,81 +102,273 @@ private:
     RegistryEntry ref_;
 };
 
-template <class T>
-class DeferredLuaDelegateCall;
+// Header of a deferred delegate call in the command buffer.
+// Arguments are stored inline after the header (see DeferredLuaDelegateCall).
+struct DeferredLuaDelegateCallHeader
+{
+    using InvokeProc = void (DeferredLuaDelegateCallHeader* call);
+    using DestroyProc = void (DeferredLuaDelegateCallHeader* call);
+
+    InvokeProc* Invoke;
+    DestroyProc* Destroy;
+    lua_State* L;
+    // Registry slot of the delegate function; owned by the call and released after the call
+    int FunctionRef;
+    // Size of the whole call, including arguments
+    uint32_t Size;
+    // Mod that the call is attributed to (if any)
+    ModStats* Mod;
+
+    void ReleaseRef()
+    {
+        luaL_unref(L, LUA_REGISTRYINDEX, FunctionRef);
+    }
+};
 
 template <class TRet, class... TArgs>
-class DeferredLuaDelegateCall<TRet (TArgs...)>
+struct DeferredLuaDelegateCall : public DeferredLuaDelegateCallHeader
 {
-public:
-    DeferredLuaDelegateCall(LuaDelegate<TRet (TArgs...)> delegate, TArgs... args)
-        : delegate_(delegate), args_(std::tuple(args...))
+    using ArgumentTuple = std::tuple<TArgs...>;
+
+    ArgumentTuple Args;
+
+    DeferredLuaDelegateCall(TArgs&&... args)
+        : Args(std::forward<TArgs>(args)...)
     {}
 
-    TRet Call()
+    static void InvokeImpl(DeferredLuaDelegateCallHeader* header)
     {
-        if constexpr (std::is_same_v<TRet, void>) {
-            delegate_.Call(args_);
-        } else {
-            return delegate_.Call(args_);
-        }
+        auto self = static_cast<DeferredLuaDelegateCall*>(header);
+        auto L = self->L;
+        StackCheck _(L);
+
+        lua_rawgeti(L, LUA_REGISTRYINDEX, self->FunctionRef);
+        Ref func(L, lua_absindex(L, -1));
+        ProtectedFunctionCaller<ArgumentTuple, TRet> caller{ func, std::move(self->Args) };
+        caller.Call(L);
+        lua_pop(L, 1);
     }
 
-private:
-    LuaDelegate<TRet(TArgs...)> delegate_;
-    std::tuple<TArgs...> args_;
+    static void DestroyImpl(DeferredLuaDelegateCallHeader* header)
+    {
+        auto self = static_cast<DeferredLuaDelegateCall*>(header);
+        self->ReleaseRef();
+        self->~DeferredLuaDelegateCall();
+    }
 };
 
-class GenericDeferredLuaDelegateCall
+// Arena for deferred calls. Memory is allocated in fixed size blocks that are kept after a flush,
+// so queueing calls doesn't allocate after the first few frames.
+class DeferredLuaDelegateArena : Noncopyable<DeferredLuaDelegateArena>
 {
 public:
-    virtual ~GenericDeferredLuaDelegateCall() {}
-    virtual void Call() = 0;
-};
+    static constexpr uint32_t BlockSize = 0x10000;
+    static constexpr uint32_t Alignment = 16;
 
-template <class TRet, class... TArgs>
-class DeferredLuaDelegateCallImpl : public GenericDeferredLuaDelegateCall
-{
-public:
-    DeferredLuaDelegateCallImpl(LuaDelegate<TRet(TArgs...)> const& delegate, TArgs... args)
-        : call_(delegate, args...)
-    {}
+    DeferredLuaDelegateArena() {}
 
-    ~DeferredLuaDelegateCallImpl() override {}
+    void* Allocate(uint32_t size)
+    {
+        size = (size + Alignment - 1) & ~(Alignment - 1);
 
-    void Call() override
+        while (current_ < blocks_.size()) {
+            auto& block = blocks_[current_];
+            if (block.Used + size <= block.Capacity) {
+                auto ptr = block.Data.get() + block.Used;
+                block.Used += size;
+                return ptr;
+            }
+
+            current_++;
+        }
+
+        // Oversized calls get a dedicated block
+        auto capacity = std::max(size, BlockSize);
+        auto data = static_cast<uint8_t*>(::operator new[](capacity, std::align_val_t(Alignment)));
+        current_ = blocks_.size();
+        blocks_.push_back(Block{
+            .Data = std::unique_ptr<uint8_t[], AlignedDelete>(data),
+            .Capacity = capacity,
+            .Used = size
+        });
+        return blocks_.back().Data.get();
+    }
+
+    inline bool IsEmpty() const
     {
-        call_.Call();
+        // Oversized calls may be placed in a later block while the earlier ones are still empty
+        for (auto const& block : blocks_) {
+            if (block.Used != 0) return false;
+        }
+
+        return true;
+    }
+
+    template <class Fun>
+    void ForEach(Fun fun)
+    {
+        for (auto& block : blocks_) {
+            uint32_t offset = 0;
+            while (offset < block.Used) {
+                auto call = reinterpret_cast<DeferredLuaDelegateCallHeader*>(block.Data.get() + offset);
+                offset += (call->Size + Alignment - 1) & ~(Alignment - 1);
+                fun(call);
+            }
+        }
+    }
+
+    void Reset()
+    {
+        for (auto& block : blocks_) {
+            block.Used = 0;
+        }
+
+        current_ = 0;
     }
 
 private:
-    DeferredLuaDelegateCall<TRet(TArgs...)> call_;
+    struct AlignedDelete
+    {
+        void operator () (uint8_t* p) const
+        {
+            ::operator delete[](p, std::align_val_t(Alignment));
+        }
+    };
+
+    struct Block
+    {
+        std::unique_ptr<uint8_t[], AlignedDelete> Data;
+        uint32_t Capacity;
+        uint32_t Used;
+    };
+
+    std::vector<Block> blocks_;
+    std::size_t current_{ 0 };
 };
 
-class DeferredLuaDelegateQueue
+// Queue of Lua calls that are executed later from a safe location (i.e. outside of engine callbacks).
+// Calls are stored in an arena-backed command buffer with inline arguments. Each call holds its own reference
+// to the delegate function, so the call is executed even if the delegate is released or reassigned before
+// the queue is flushed; queueing from an rvalue delegate takes over its registry slot instead of duplicating it.
+class DeferredLuaDelegateQueue : Noncopyable<DeferredLuaDelegateQueue>
 {
 public:
+    DeferredLuaDelegateQueue() {}
+
+    ~DeferredLuaDelegateQueue()
+    {
+        for (auto& arena : arenas_) {
+            arena.ForEach([](DeferredLuaDelegateCallHeader* call) {
+                call->Destroy(call);
+            });
+        }
+    }
+
+    // Queues a call that holds a new reference to the delegate function
     template <class TRet, class... TArgs>
-    void Call(LuaDelegate<TRet(TArgs...)> const& delegate, TArgs... args)
+    DeferredLuaDelegateCallHeader* Call(LuaDelegate<TRet(TArgs...)> const& delegate, TArgs... args)
     {
-        if (!delegate) return;
+        if (!delegate) return nullptr;
 
-        auto call = new DeferredLuaDelegateCallImpl<TRet, TArgs...>(delegate, args...);
-        queue_.push_back(call);
+        auto const& ref = delegate.GetRegistryEntry();
+        auto L = ref.GetState();
+        ref.Push();
+
+        auto call = AllocateCall<TRet, TArgs...>(std::forward<TArgs>(args)...);
+        call->L = L;
+        call->FunctionRef = luaL_ref(L, LUA_REGISTRYINDEX);
+        return call;
+    }
+
+    // Queues a call that takes over the registry slot of the delegate
+    template <class TRet, class... TArgs>
+    DeferredLuaDelegateCallHeader* Call(LuaDelegate<TRet(TArgs...)>&& delegate, TArgs... args)
+    {
+        if (!delegate) return nullptr;
+
+        auto& ref = delegate.GetRegistryEntry();
+        auto call = AllocateCall<TRet, TArgs...>(std::forward<TArgs>(args)...);
+        call->L = ref.GetState();
+        call->FunctionRef = ref.GetRef();
+        ref.ResetWithoutUnbind();
+        return call;
     }
 
     void Flush()
     {
-        Array<GenericDeferredLuaDelegateCall*> cur;
-        std::swap(cur, queue_);
-        for (auto const& call : cur) {
-            call->Call();
-            delete call;
-        }
+        Flush([](DeferredLuaDelegateCallHeader* call) {
+            call->Invoke(call);
+        });
+    }
+
+    // Executes queued calls through the specified invoker function
+    template <class Fun>
+    void Flush(Fun invoke)
+    {
+        if (flushing_) return;
+
+        // Calls queued by the handlers go to the other arena and are executed on the next flush
+        auto& arena = arenas_[current_];
+        if (arena.IsEmpty()) return;
+
+        current_ ^= 1;
+        FlushScope scope(*this, arena);
+        arena.ForEach([&invoke, &scope](DeferredLuaDelegateCallHeader* call) {
+            invoke(call);
+            call->Destroy(call);
+            scope.Destroyed++;
+        });
     }
 
 private:
-    Array<GenericDeferredLuaDelegateCall*> queue_;
+    // Resets the flushed arena when the flush ends, even if an invoker threw;
+    // calls that weren't executed are destroyed without being called
+    class FlushScope : Noncopyable<FlushScope>
+    {
+    public:
+        uint32_t Destroyed{ 0 };
+
+        FlushScope(DeferredLuaDelegateQueue& queue, DeferredLuaDelegateArena& arena)
+            : queue_(queue), arena_(arena)
+        {
+            queue_.flushing_ = true;
+        }
+
+        ~FlushScope()
+        {
+            uint32_t index{ 0 };
+            arena_.ForEach([this, &index](DeferredLuaDelegateCallHeader* call) {
+                if (index++ >= Destroyed) {
+                    call->Destroy(call);
+                }
+            });
+            arena_.Reset();
+            queue_.flushing_ = false;
+        }
+
+    private:
+        DeferredLuaDelegateQueue& queue_;
+        DeferredLuaDelegateArena& arena_;
+    };
+
+    DeferredLuaDelegateArena arenas_[2];
+    uint32_t current_{ 0 };
+    bool flushing_{ false };
+
+    template <class TRet, class... TArgs>
+    DeferredLuaDelegateCall<TRet, TArgs...>* AllocateCall(TArgs&&... args)
+    {
+        using CallType = DeferredLuaDelegateCall<TRet, TArgs...>;
+        static_assert(alignof(CallType) <= DeferredLuaDelegateArena::Alignment, "Call arguments overaligned");
+
+        auto buf = arenas_[current_].Allocate((uint32_t)sizeof(CallType));
+        auto call = new (buf) CallType(std::forward<TArgs>(args)...);
+        call->Invoke = &CallType::InvokeImpl;
+        call->Destroy = &CallType::DestroyImpl;
+        call->Size = (uint32_t)sizeof(CallType);
+        call->Mod = nullptr;
+        return call;
+    }
 };
 
 END_NS()
@@ -24,6 +24,8 @@ struct ModuleDefinition
 	ModuleRole Role;
 	FixedString Table;
 	FixedString SubTable;
+	// Test and benchmark helpers that are only exposed in developer mode
+	bool DeveloperOnly{ false };
 	std::vector<ModuleFunction> Functions;
 };
 
@@ -11,7 +11,10 @@ void ModuleRegistry::RegisterModule(ModuleDefinition const& module)
 
 void ModuleRegistry::ConstructState(lua_State* L, ModuleRole role)
 {
+	auto developerMode = gExtender->GetConfig().DeveloperMode;
 	for (auto const& module : modules_) {
+		if (module.DeveloperOnly && !developerMode) continue;
+
 		if (role == module.Role || module.Role == ModuleRole::Both) {
 			InstantiateModule(L, module);
 		}
@@ -22,7 +25,9 @@ void ModuleRegistry::RegisterTypeInformation()
 {
 	assert(!modules_.empty());
 	for (auto const& module : modules_) {
-		RegisterModuleTypeInformation(module);
+		if (!module.DeveloperOnly) {
+			RegisterModuleTypeInformation(module);
+		}
 	}
 }
 
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <Lua/Shared/ScriptOrigins.h>
+#include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+
+BEGIN_NS(lua)
+
+// Sampling profiler for Lua code.
+// Installs a count hook that checks the elapsed time every N VM instructions and records the current
+// Lua call stack when the sampling interval has passed. No hook is installed when the profiler is not running.
+class LuaProfiler : Noncopyable<LuaProfiler>
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr uint32_t DefaultSampleIntervalUs = 1000;
+	static constexpr uint32_t DefaultInstructionCount = 1000;
+	// Maximum number of samples kept for the timeline (Chrome trace) export;
+	// folded stacks are still aggregated after the limit is reached
+	static constexpr std::size_t MaxTimelineSamples = 1000000;
+
+	LuaProfiler(ScriptOriginMap const& origins);
+
+	inline bool IsRunning() const
+	{
+		return running_;
+	}
+
+	inline std::size_t GetNumSamples() const
+	{
+		return numSamples_;
+	}
+
+	bool Start(lua_State* L, uint32_t sampleIntervalUs, uint32_t instructionCount);
+	void Stop(lua_State* L);
+	void Clear();
+
+	// Exports samples in the "folded stacks" format used by flamegraph.pl / speedscope / inferno
+	STDString ExportFolded() const;
+	// Exports samples in the Chrome trace event format (chrome://tracing, Perfetto)
+	STDString ExportChromeTrace() const;
+	// Exports samples in the specified format ("folded" or "chrome"); returns nothing if the format is unknown
+	std::optional<STDString> Export(std::string_view format) const;
+
+private:
+	// Frames are keyed on the contents of the source and function names, as the strings returned by
+	// lua_getinfo() can be collected and their memory reused for other strings while the profiler is running.
+	// Lookups use the strings of the Lua state; keys stored in frameIds_ point to copies in strings_.
+	struct FrameKey
+	{
+		std::string_view Source;
+		std::string_view Name;
+		int Line;
+
+		inline bool operator == (FrameKey const& o) const
+		{
+			return Source == o.Source && Name == o.Name && Line == o.Line;
+		}
+	};
+
+	struct FrameKeyHash
+	{
+		std::size_t operator () (FrameKey const& k) const;
+	};
+
+	struct StackHash
+	{
+		std::size_t operator () (std::vector<uint32_t> const& stack) const;
+	};
+
+	struct Sample
+	{
+		Clock::time_point Time;
+		uint32_t Stack;
+	};
+
+	ScriptOriginMap const& origins_;
+	bool running_{ false };
+	Clock::duration sampleInterval_;
+	Clock::time_point startTime_;
+	Clock::time_point lastSample_;
+	std::size_t numSamples_{ 0 };
+
+	std::unordered_map<FrameKey, uint32_t, FrameKeyHash> frameIds_;
+	std::unordered_set<std::string> strings_;
+	std::unordered_map<FixedString, uint32_t> modFrameIds_;
+	std::vector<STDString> frameNames_;
+	std::unordered_map<std::vector<uint32_t>, uint32_t, StackHash> stackIds_;
+	std::vector<std::vector<uint32_t>> stacks_;
+	std::vector<uint32_t> stackCounts_;
+	std::vector<Sample> samples_;
+	std::vector<uint32_t> frameBuf_;
+
+	static void Hook(lua_State* L, lua_Debug* ar);
+	void TakeSample(lua_State* L);
+	uint32_t GetFrameId(lua_Debug const& ar);
+	std::string_view InternString(std::string_view str);
+	uint32_t GetModFrameId(FixedString const& mod);
+};
+
+END_NS()
@@ -0,0 +1,291 @@
+#include <Lua/Shared/LuaProfiler.h>
+
+BEGIN_NS(lua)
+
+std::size_t LuaProfiler::FrameKeyHash::operator () (FrameKey const& k) const
+{
+	return std::hash<std::string_view>()(k.Source) ^ (std::hash<std::string_view>()(k.Name) << 1) ^ ((std::size_t)k.Line << 32);
+}
+
+std::size_t LuaProfiler::StackHash::operator () (std::vector<uint32_t> const& stack) const
+{
+	std::size_t hash = stack.size();
+	for (auto frame : stack) {
+		hash ^= frame + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	}
+
+	return hash;
+}
+
+LuaProfiler::LuaProfiler(ScriptOriginMap const& origins)
+	: origins_(origins)
+{}
+
+bool LuaProfiler::Start(lua_State* L, uint32_t sampleIntervalUs, uint32_t instructionCount)
+{
+	if (running_) {
+		OsiError("Profiler is already running");
+		return false;
+	}
+
+	if (lua_gethook(L) != nullptr) {
+		OsiError("Cannot start profiler: another Lua hook is already installed (is the debugger attached?)");
+		return false;
+	}
+
+	sampleInterval_ = std::chrono::microseconds(sampleIntervalUs > 0 ? sampleIntervalUs : DefaultSampleIntervalUs);
+	startTime_ = Clock::now();
+	lastSample_ = startTime_;
+	running_ = true;
+	lua_sethook(L, &LuaProfiler::Hook, LUA_MASKCOUNT, instructionCount > 0 ? (int)instructionCount : (int)DefaultInstructionCount);
+	return true;
+}
+
+void LuaProfiler::Stop(lua_State* L)
+{
+	if (!running_) return;
+
+	// Leave hooks that were installed by someone else (eg. the debugger) while the profiler was running
+	if (lua_gethook(L) == &LuaProfiler::Hook) {
+		lua_sethook(L, nullptr, 0, 0);
+	}
+	running_ = false;
+}
+
+void LuaProfiler::Clear()
+{
+	numSamples_ = 0;
+	frameIds_.clear();
+	strings_.clear();
+	modFrameIds_.clear();
+	frameNames_.clear();
+	stackIds_.clear();
+	stacks_.clear();
+	stackCounts_.clear();
+	samples_.clear();
+}
+
+void LuaProfiler::Hook(lua_State* L, lua_Debug* ar)
+{
+	auto& profiler = State::FromLua(L)->GetProfiler();
+	auto now = Clock::now();
+	if (now - profiler.lastSample_ >= profiler.sampleInterval_) {
+		profiler.lastSample_ = now;
+		profiler.TakeSample(L);
+	}
+}
+
+uint32_t LuaProfiler::GetFrameId(lua_Debug const& ar)
+{
+	FrameKey key{
+		ar.source ? std::string_view(ar.source) : std::string_view{},
+		ar.name ? std::string_view(ar.name) : std::string_view{},
+		ar.linedefined
+	};
+	auto it = frameIds_.find(key);
+	if (it != frameIds_.end()) {
+		return it->second;
+	}
+
+	STDString name;
+	if (*ar.what == 'C') {
+		name = "[C] ";
+		name += ar.name ? ar.name : "?";
+	} else {
+		name = ar.name ? ar.name : (*ar.what == 'm' ? "(main chunk)" : "(anonymous)");
+		name += " (";
+		name += ar.short_src;
+		name += ":";
+		name += std::to_string(ar.linedefined).c_str();
+		name += ")";
+	}
+
+	auto id = (uint32_t)frameNames_.size();
+	frameNames_.push_back(std::move(name));
+	key.Source = InternString(key.Source);
+	key.Name = InternString(key.Name);
+	frameIds_.insert(std::make_pair(key, id));
+	return id;
+}
+
+std::string_view LuaProfiler::InternString(std::string_view str)
+{
+	// Set nodes are never moved, so views of the stored strings stay valid until Clear()
+	return *strings_.emplace(str).first;
+}
+
+uint32_t LuaProfiler::GetModFrameId(FixedString const& mod)
+{
+	auto it = modFrameIds_.find(mod);
+	if (it != modFrameIds_.end()) {
+		return it->second;
+	}
+
+	auto id = (uint32_t)frameNames_.size();
+	frameNames_.push_back(STDString("[") + (mod ? mod.GetString() : "unknown") + "]");
+	modFrameIds_.insert(std::make_pair(mod, id));
+	return id;
+}
+
+void LuaProfiler::TakeSample(lua_State* L)
+{
+	frameBuf_.clear();
+
+	// Attribute the sample to the innermost frame that belongs to a mod; builtin code called from
+	// a mod is accounted to the mod that called it
+	FixedString mod;
+	bool builtin{ false };
+	lua_Debug ar;
+	for (int level = 0; lua_getstack(L, level, &ar); level++) {
+		lua_getinfo(L, "Sn", &ar);
+		frameBuf_.push_back(GetFrameId(ar));
+
+		if (!mod && *ar.what != 'C') {
+			auto origin = origins_.Find(ar.source);
+			if (origin && origin.GetStringView() != "builtin") {
+				mod = origin;
+			} else if (origin) {
+				builtin = true;
+			}
+		}
+	}
+
+	if (frameBuf_.empty()) return;
+
+	if (!mod && builtin) {
+		mod = FixedString{ "builtin" };
+	}
+
+	frameBuf_.push_back(GetModFrameId(mod));
+	std::reverse(frameBuf_.begin(), frameBuf_.end());
+
+	uint32_t stackId;
+	auto it = stackIds_.find(frameBuf_);
+	if (it != stackIds_.end()) {
+		stackId = it->second;
+	} else {
+		stackId = (uint32_t)stacks_.size();
+		stacks_.push_back(frameBuf_);
+		stackCounts_.push_back(0);
+		stackIds_.insert(std::make_pair(frameBuf_, stackId));
+	}
+
+	stackCounts_[stackId]++;
+	numSamples_++;
+
+	if (samples_.size() < MaxTimelineSamples) {
+		samples_.push_back(Sample{ lastSample_, stackId });
+	}
+}
+
+STDString LuaProfiler::ExportFolded() const
+{
+	std::stringstream ss;
+	for (std::size_t i = 0; i < stacks_.size(); i++) {
+		auto const& stack = stacks_[i];
+		for (std::size_t frame = 0; frame < stack.size(); frame++) {
+			if (frame > 0) ss << ';';
+			// Semicolons are frame separators in the folded format
+			for (auto c : frameNames_[stack[frame]]) {
+				ss << (c == ';' ? ':' : c);
+			}
+		}
+
+		ss << ' ' << stackCounts_[i] << '\n';
+	}
+
+	return ss.str().c_str();
+}
+
+namespace
+{
+	void WriteJsonString(std::stringstream& ss, STDString const& s)
+	{
+		ss << '"';
+		for (auto c : s) {
+			switch (c) {
+			case '"': ss << "\\\""; break;
+			case '\\': ss << "\\\\"; break;
+			case '\n': ss << "\\n"; break;
+			case '\r': ss << "\\r"; break;
+			case '\t': ss << "\\t"; break;
+			default:
+				if ((unsigned char)c < 0x20) {
+					ss << ' ';
+				} else {
+					ss << c;
+				}
+			}
+		}
+		ss << '"';
+	}
+
+	void WriteTraceEvent(std::stringstream& ss, bool& first, STDString const& name, char phase, int64_t timeUs)
+	{
+		if (!first) ss << ",\n";
+		first = false;
+		ss << "{\"name\":";
+		WriteJsonString(ss, name);
+		ss << ",\"cat\":\"lua\",\"ph\":\"" << phase << "\",\"ts\":" << timeUs << ",\"pid\":1,\"tid\":1}";
+	}
+}
+
+STDString LuaProfiler::ExportChromeTrace() const
+{
+	// Reconstructs begin/end events from consecutive samples: frames shared with the previous sample
+	// are kept open, the rest are closed/opened at the time of the sample.
+	// If there was a gap between two samples (i.e. no Lua code was running), all frames are closed.
+	std::stringstream ss;
+	ss << "{\"traceEvents\":[\n";
+	bool first{ true };
+
+	std::vector<uint32_t> const* prev{ nullptr };
+	int64_t prevTime{ 0 };
+	auto intervalUs = std::chrono::duration_cast<std::chrono::microseconds>(sampleInterval_).count();
+
+	auto closeFrames = [&](std::size_t keep, int64_t time) {
+		if (prev == nullptr) return;
+		for (auto i = prev->size(); i > keep; i--) {
+			WriteTraceEvent(ss, first, frameNames_[(*prev)[i - 1]], 'E', time);
+		}
+	};
+
+	for (auto const& sample : samples_) {
+		auto time = std::chrono::duration_cast<std::chrono::microseconds>(sample.Time - startTime_).count();
+		auto const& stack = stacks_[sample.Stack];
+
+		std::size_t common{ 0 };
+		if (prev != nullptr && time - prevTime <= intervalUs * 2) {
+			while (common < prev->size() && common < stack.size() && (*prev)[common] == stack[common]) {
+				common++;
+			}
+			closeFrames(common, time);
+		} else {
+			closeFrames(0, prevTime + intervalUs);
+		}
+
+		for (auto i = common; i < stack.size(); i++) {
+			WriteTraceEvent(ss, first, frameNames_[stack[i]], 'B', time);
+		}
+
+		prev = &stack;
+		prevTime = time;
+	}
+
+	closeFrames(0, prevTime + intervalUs);
+	ss << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return ss.str().c_str();
+}
+
+std::optional<STDString> LuaProfiler::Export(std::string_view format) const
+{
+	if (format == "folded") {
+		return ExportFolded();
+	} else if (format == "chrome") {
+		return ExportChromeTrace();
+	} else {
+		return {};
+	}
+}
+
+END_NS()
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <chrono>
+#include <unordered_map>
+
+BEGIN_NS(lua)
+
+// Resource usage counters of a single mod
+struct ModUsageCounters
+{
+	// Number of handler invocations (events, timers, net messages, Osiris listeners)
+	uint64_t Calls{ 0 };
+	// Time spent in handlers of the mod, excluding handlers of other mods that were called from them
+	std::chrono::steady_clock::duration Time{ 0 };
+	// Lua memory allocated and freed while the mod was running
+	uint64_t AllocatedBytes{ 0 };
+	uint64_t FreedBytes{ 0 };
+
+	inline void Add(ModUsageCounters const& o)
+	{
+		Calls += o.Calls;
+		Time += o.Time;
+		AllocatedBytes += o.AllocatedBytes;
+		FreedBytes += o.FreedBytes;
+	}
+};
+
+struct ModStats
+{
+	FixedString Mod;
+	// Counters of the current (incomplete) window
+	ModUsageCounters Window;
+	// Counters of the last completed window
+	ModUsageCounters LastWindow;
+	// Counters of all completed windows
+	ModUsageCounters Completed;
+
+	inline ModUsageCounters GetTotal() const
+	{
+		auto total = Completed;
+		total.Add(Window);
+		return total;
+	}
+};
+
+// Attributes Lua CPU time and allocations to mods.
+// Handler invocations are wrapped in a ModAccountingScope that switches the current mod;
+// time and allocations are charged to the current mod. Counters are collected in fixed length windows,
+// so rolling (last window) values are available in addition to totals.
+class ModAccounting : Noncopyable<ModAccounting>
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr Clock::duration DefaultWindowLength = std::chrono::seconds(10);
+	static constexpr unsigned MaxLoggedMods = 5;
+
+	ModAccounting();
+
+	// Returns the stats entry of a mod; entries are never removed, so the pointer remains valid
+	// for the lifetime of the Lua state
+	ModStats* GetStats(FixedString const& mod);
+
+	inline ModStats* GetCurrent() const
+	{
+		return current_;
+	}
+
+	// Makes the specified mod the current one; returns the previously active mod
+	ModStats* Enter(ModStats* mod);
+	void Exit(ModStats* previous);
+
+	inline void OnAllocation(std::size_t oldSize, std::size_t newSize)
+	{
+		if (newSize > oldSize) {
+			current_->Window.AllocatedBytes += newSize - oldSize;
+		} else {
+			current_->Window.FreedBytes += oldSize - newSize;
+		}
+	}
+
+	// Completes the current window if it has elapsed; called once per tick
+	void Update();
+
+	inline void SetWindowLength(Clock::duration length)
+	{
+		windowLength_ = length;
+	}
+
+	// Enables printing a summary of the most expensive mods after each window
+	inline void SetLogging(bool enabled)
+	{
+		logSummary_ = enabled;
+	}
+
+	template <class Fun>
+	void ForEach(Fun fun) const
+	{
+		for (auto const& mod : mods_) {
+			fun(mod.second);
+		}
+	}
+
+private:
+	std::unordered_map<FixedString, ModStats> mods_;
+	// Entry for code that doesn't belong to any known mod
+	ModStats* unattributed_;
+	ModStats* current_;
+	uint32_t depth_{ 0 };
+	Clock::time_point lastSwitch_;
+	Clock::time_point windowStart_;
+	Clock::duration windowLength_{ DefaultWindowLength };
+	bool logSummary_{ false };
+
+	void CompleteWindow();
+	void LogSummary();
+};
+
+// Charges the time and allocations of a handler invocation to a mod
+class ModAccountingScope : Noncopyable<ModAccountingScope>
+{
+public:
+	inline ModAccountingScope(ModAccounting& accounting, ModStats* mod)
+		: accounting_(accounting), previous_(accounting.Enter(mod))
+	{}
+
+	inline ModAccountingScope(ModAccounting& accounting, FixedString const& mod)
+		: accounting_(accounting), previous_(accounting.Enter(accounting.GetStats(mod)))
+	{}
+
+	inline ~ModAccountingScope()
+	{
+		accounting_.Exit(previous_);
+	}
+
+private:
+	ModAccounting& accounting_;
+	ModStats* previous_;
+};
+
+END_NS()
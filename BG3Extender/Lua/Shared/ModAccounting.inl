@@ -0,0 +1,98 @@
+#include <Lua/Shared/ModAccounting.h>
+
+BEGIN_NS(lua)
+
+ModAccounting::ModAccounting()
+{
+	unattributed_ = GetStats(FixedString{});
+	current_ = unattributed_;
+	windowStart_ = Clock::now();
+}
+
+ModStats* ModAccounting::GetStats(FixedString const& mod)
+{
+	auto it = mods_.find(mod);
+	if (it != mods_.end()) {
+		return &it->second;
+	}
+
+	auto& stats = mods_.insert(std::make_pair(mod, ModStats{})).first->second;
+	stats.Mod = mod;
+	return &stats;
+}
+
+ModStats* ModAccounting::Enter(ModStats* mod)
+{
+	auto now = Clock::now();
+	auto previous = current_;
+	// Time is only charged while a handler is running; the time spent so far is charged to the outer handler
+	if (depth_ > 0) {
+		previous->Window.Time += now - lastSwitch_;
+	}
+
+	current_ = mod ? mod : unattributed_;
+	current_->Window.Calls++;
+	lastSwitch_ = now;
+	depth_++;
+	return previous;
+}
+
+void ModAccounting::Exit(ModStats* previous)
+{
+	auto now = Clock::now();
+	current_->Window.Time += now - lastSwitch_;
+	current_ = previous;
+	lastSwitch_ = now;
+	depth_--;
+}
+
+void ModAccounting::Update()
+{
+	auto now = Clock::now();
+	if (now - windowStart_ < windowLength_) return;
+
+	CompleteWindow();
+	windowStart_ = now;
+}
+
+void ModAccounting::CompleteWindow()
+{
+	for (auto& it : mods_) {
+		auto& mod = it.second;
+		mod.LastWindow = mod.Window;
+		mod.Completed.Add(mod.Window);
+		mod.Window = ModUsageCounters{};
+	}
+
+	if (logSummary_) {
+		LogSummary();
+	}
+}
+
+void ModAccounting::LogSummary()
+{
+	Vector<ModStats const*> mods;
+	for (auto const& it : mods_) {
+		if (it.second.LastWindow.Calls > 0 || it.second.LastWindow.AllocatedBytes > 0) {
+			mods.push_back(&it.second);
+		}
+	}
+
+	if (mods.empty()) return;
+
+	std::sort(mods.begin(), mods.end(), [](ModStats const* a, ModStats const* b) {
+		return a->LastWindow.Time > b->LastWindow.Time;
+	});
+
+	auto windowSecs = std::chrono::duration_cast<std::chrono::duration<double>>(windowLength_).count();
+	INFO("Lua usage by mod in the last %.0f seconds:", windowSecs);
+	for (std::size_t i = 0; i < mods.size() && i < MaxLoggedMods; i++) {
+		auto const& counters = mods[i]->LastWindow;
+		auto timeMs = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(counters.Time).count();
+		INFO("  %s: %.2f ms, %llu calls, %llu KB allocated, %llu KB freed",
+			mods[i]->Mod ? mods[i]->Mod.GetString() : "(unknown)", timeMs, counters.Calls,
+			counters.AllocatedBytes / 1024, counters.FreedBytes / 1024);
+	}
+}
+
+END_NS()
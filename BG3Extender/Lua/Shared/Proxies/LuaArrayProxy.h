@@ -53,6 +53,13 @@ END_SE()
 
 BEGIN_NS(lua)
 
+struct ContainerProxyHelpers
+{
+	static bool ToTable(lua_State* L, CppObjectMetadata& self, int depth);
+	static void ExpandNested(lua_State* L, int depth);
+	static int ToTableProxy(lua_State* L);
+};
+
 class ArrayProxyImplBase
 {
 public:
@@ -68,6 +75,7 @@ public:
 	virtual unsigned Length(CppObjectMetadata& self) = 0;
 	virtual bool Unserialize(lua_State* L, CppObjectMetadata& self, int index) = 0;
 	virtual void Serialize(lua_State* L, CppObjectMetadata& self) = 0;
+	virtual void ToTable(lua_State* L, CppObjectMetadata& self, int depth) = 0;
 
 private:
 	int registryIndex_{ -1 };
@@ -155,6 +163,20 @@ public:
 		lua::Serialize(L, obj);
 	}
 
+	void ToTable(lua_State* L, CppObjectMetadata& self, int depth) override
+	{
+		auto obj = reinterpret_cast<TContainer*>(self.Ptr);
+		auto size = (unsigned)obj->size();
+		lua_createtable(L, (int)size, 0);
+		for (unsigned i = 0; i < size; i++) {
+			push(L, &(*obj)[i], self.Lifetime);
+			if constexpr (!IsByVal<T>) {
+				if (depth > 1) ContainerProxyHelpers::ExpandNested(L, depth - 1);
+			}
+			lua_rawseti(L, -2, i + 1);
+		}
+	}
+
 	int Next(lua_State* L, CppObjectMetadata& self, int key) override
 	{
 		auto obj = reinterpret_cast<TContainer*>(self.Ptr);
@@ -251,6 +273,20 @@ public:
 		lua::Serialize(L, obj);
 	}
 
+	void ToTable(lua_State* L, CppObjectMetadata& self, int depth) override
+	{
+		auto obj = reinterpret_cast<TContainer*>(self.Ptr);
+		auto size = (unsigned)obj->Size();
+		lua_createtable(L, (int)size, 0);
+		for (unsigned i = 0; i < size; i++) {
+			push(L, &(*obj)[i], self.Lifetime);
+			if constexpr (!IsByVal<T>) {
+				if (depth > 1) ContainerProxyHelpers::ExpandNested(L, depth - 1);
+			}
+			lua_rawseti(L, -2, i + 1);
+		}
+	}
+
 	int Next(lua_State* L, CppObjectMetadata& self, int key) override
 	{
 		auto obj = reinterpret_cast<TContainer*>(self.Ptr);
@@ -348,6 +384,18 @@ public:
 		lua::Serialize(L, obj);
 	}
 
+	void ToTable(lua_State* L, CppObjectMetadata& self, int depth) override
+	{
+		auto obj = reinterpret_cast<TContainer*>(self.Ptr);
+		auto size = (unsigned)obj->Count();
+		lua_createtable(L, (int)size, 0);
+		for (unsigned i = 0; i < size; i++) {
+			auto ref = obj->GetComponent(i);
+			push(L, ref.GetPtr(), self.Lifetime);
+			lua_rawseti(L, -2, i + 1);
+		}
+	}
+
 	int Next(lua_State* L, CppObjectMetadata& self, int key) override
 	{
 		auto obj = reinterpret_cast<TContainer*>(self.Ptr);
@@ -437,6 +485,20 @@ public:
 		lua::Serialize(L, obj);
 	}
 
+	void ToTable(lua_State* L, CppObjectMetadata& self, int depth) override
+	{
+		auto obj = reinterpret_cast<TContainer*>(self.Ptr);
+		auto size = (unsigned)obj->size();
+		lua_createtable(L, (int)size, 0);
+		for (unsigned i = 0; i < size; i++) {
+			push(L, &(*obj)[i], self.Lifetime);
+			if constexpr (!IsByVal<T>) {
+				if (depth > 1) ContainerProxyHelpers::ExpandNested(L, depth - 1);
+			}
+			lua_rawseti(L, -2, i + 1);
+		}
+	}
+
 	int Next(lua_State* L, CppObjectMetadata& self, int key) override
 	{
 		auto obj = reinterpret_cast<TContainer*>(self.Ptr);
@@ -519,6 +581,17 @@ public:
 		lua::Serialize(L, obj);
 	}
 
+	void ToTable(lua_State* L, CppObjectMetadata& self, int depth) override
+	{
+		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
+		auto size = (unsigned)obj->size();
+		lua_createtable(L, (int)size, 0);
+		for (unsigned i = 0; i < size; i++) {
+			push(L, obj->IsSet(i));
+			lua_rawseti(L, -2, i + 1);
+		}
+	}
+
 	int Next(lua_State* L, CppObjectMetadata& self, int key) override
 	{
 		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
@@ -2,6 +2,55 @@
 
 BEGIN_NS(lua)
 
+bool ContainerProxyHelpers::ToTable(lua_State* L, CppObjectMetadata& self, int depth)
+{
+	switch (self.MetatableTag) {
+	case MetatableTag::ArrayProxy:
+		ArrayProxyMetatable::GetImpl(self)->ToTable(L, self, depth);
+		return true;
+
+	case MetatableTag::MapProxy:
+		MapProxyMetatable::GetImpl(self)->ToTable(L, self, depth);
+		return true;
+
+	case MetatableTag::SetProxy:
+		SetProxyMetatable::GetImpl(self)->ToTable(L, self, depth);
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+void ContainerProxyHelpers::ExpandNested(lua_State* L, int depth)
+{
+	if (lua_type(L, -1) != LUA_TLIGHTCPPOBJECT) return;
+
+	CppObjectMetadata meta;
+	lua_get_cppobject(L, -1, meta);
+	if (ToTable(L, meta, depth)) {
+		lua_replace(L, -2);
+	}
+}
+
+int ContainerProxyHelpers::ToTableProxy(lua_State* L)
+{
+	StackCheck _(L, 1);
+	CppObjectMetadata self;
+	lua_get_cppobject(L, 1, self);
+	auto depth = lua_isnoneornil(L, 2) ? 1 : get<int>(L, 2);
+
+	if (!self.Lifetime.IsAlive(L)) {
+		return luaL_error(L, "Attempted to convert container whose lifetime has expired");
+	}
+
+	if (!ToTable(L, self, depth)) {
+		return luaL_error(L, "ToTable() can only be called on arrays, maps and sets");
+	}
+
+	return 1;
+}
+
 
 ArrayProxyImplBase::ArrayProxyImplBase()
 {
@@ -52,6 +101,11 @@ ArrayProxyImplBase* ArrayProxyMetatable::GetImpl(int propertyMapIndex)
 int ArrayProxyMetatable::Index(lua_State* L, CppObjectMetadata& self)
 {
 	auto impl = gExtender->GetPropertyMapManager().GetArrayProxy(self.PropertyMapTag);
+	if (lua_type(L, 2) == LUA_TSTRING && get<FixedString>(L, 2) == GFS.strToTable) {
+		lua_pushcfunction(L, &ContainerProxyHelpers::ToTableProxy);
+		return 1;
+	}
+
 	auto index = get<int>(L, 2);
 	if (!impl->GetElement(L, self, index)) {
 		push(L, nullptr);
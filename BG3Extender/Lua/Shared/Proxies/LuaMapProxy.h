@@ -12,12 +12,15 @@ public:
 	virtual TypeInformation const& GetContainerType() const = 0;
 	virtual TypeInformation const& GetKeyType() const = 0;
 	virtual TypeInformation const& GetValueType() const = 0;
+	// Whether string keys can refer to map entries (i.e. they may shadow container methods)
+	virtual bool HasStringKeys() const = 0;
 	virtual bool GetValue(lua_State* L, CppObjectMetadata& self, int luaKeyIndex) = 0;
 	virtual bool SetValue(lua_State* L, CppObjectMetadata& self, int luaKeyIndex, int luaValueIndex) = 0;
 	virtual int Next(lua_State* L, CppObjectMetadata& self, int luaKeyIndex) = 0;
 	virtual unsigned Length(CppObjectMetadata& self) = 0;
 	virtual bool Unserialize(lua_State* L, CppObjectMetadata& self, int index) = 0;
 	virtual void Serialize(lua_State* L, CppObjectMetadata& self) = 0;
+	virtual void ToTable(lua_State* L, CppObjectMetadata& self, int depth) = 0;
 
 private:
 	int registryIndex_{ -1 };
@@ -53,6 +56,11 @@ public:
 		return GetTypeInfo<TValue>();
 	}
 
+	bool HasStringKeys() const override
+	{
+		return std::is_same_v<TKey, FixedString> || std::is_same_v<TKey, STDString>;
+	}
+
 	bool GetValue(lua_State* L, CppObjectMetadata& self, int luaKeyIndex) override
 	{
 		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
@@ -130,6 +138,22 @@ public:
 		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
 		lua::Serialize(L, obj);
 	}
+
+	void ToTable(lua_State* L, CppObjectMetadata& self, int depth) override
+	{
+		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
+		auto size = obj->size();
+		lua_createtable(L, 0, (int)size);
+		for (uint32_t i = 0; i < size; i++) {
+			// TODO - jank, but const proxies are not supported yet
+			push(L, const_cast<TKey*>(&obj->keys()[i]), self.Lifetime);
+			push(L, &obj->values()[i], self.Lifetime);
+			if constexpr (!IsByVal<TValue>) {
+				if (depth > 1) ContainerProxyHelpers::ExpandNested(L, depth - 1);
+			}
+			lua_rawset(L, -3);
+		}
+	}
 };
 
 	
@@ -162,6 +186,11 @@ public:
 		return GetTypeInfo<TValue>();
 	}
 
+	bool HasStringKeys() const override
+	{
+		return std::is_same_v<TKey, FixedString> || std::is_same_v<TKey, STDString>;
+	}
+
 	bool GetValue(lua_State* L, CppObjectMetadata& self, int luaKeyIndex) override
 	{
 		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
@@ -243,6 +272,20 @@ public:
 		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
 		lua::Serialize(L, obj);
 	}
+
+	void ToTable(lua_State* L, CppObjectMetadata& self, int depth) override
+	{
+		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
+		lua_createtable(L, 0, (int)obj->size());
+		for (auto it = obj->begin(); it != obj->end(); it++) {
+			push(L, &it.Key(), self.Lifetime);
+			push(L, &it.Value(), self.Lifetime);
+			if constexpr (!IsByVal<TValue>) {
+				if (depth > 1) ContainerProxyHelpers::ExpandNested(L, depth - 1);
+			}
+			lua_rawset(L, -3);
+		}
+	}
 };
 
 
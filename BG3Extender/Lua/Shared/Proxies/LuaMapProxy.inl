@@ -23,8 +23,19 @@ int MapProxyImplBase::GetRegistryIndex() const
 int MapProxyMetatable::Index(lua_State* L, CppObjectMetadata& self)
 {
 	auto impl = gExtender->GetPropertyMapManager().GetMapProxy(self.PropertyMapTag);
+	auto isToTable = lua_type(L, 2) == LUA_TSTRING && get<FixedString>(L, 2) == GFS.strToTable;
+	// Entries of string-keyed maps take precedence over the ToTable() method
+	if (isToTable && !impl->HasStringKeys()) {
+		lua_pushcfunction(L, &ContainerProxyHelpers::ToTableProxy);
+		return 1;
+	}
+
 	if (!impl->GetValue(L, self, 2)) {
-		push(L, nullptr);
+		if (isToTable) {
+			lua_pushcfunction(L, &ContainerProxyHelpers::ToTableProxy);
+		} else {
+			push(L, nullptr);
+		}
 	}
 
 	return 1;
@@ -58,13 +58,11 @@ void InheritProperties(GenericPropertyMap const& base, GenericPropertyMap& child
 	// Check to make sure that the property map we're inheriting from is already initialized
 	assert(base.Initialized);
 	assert(base.InheritanceUpdated);
-	assert(child.Initialized);
-	assert(!child.IsInitializing);
+	assert(!child.Initialized);
+	assert(child.IsInitializing);
 	assert(!child.InheritanceUpdated);
 	assert(child.Parent == &base);
 
-	child.IsInitializing = true;
-
 	for (auto prop : base.Properties) {
 		auto const& p = prop.Value();
 		child.AddRawProperty(prop.Key().GetString(), p.Get, p.Set, p.Serialize, p.Offset, p.Flag, 
@@ -98,7 +96,6 @@ void InheritProperties(GenericPropertyMap const& base, GenericPropertyMap& child
 		child.FallbackNext = base.FallbackNext;
 	}
 
-	child.IsInitializing = false;
 	child.InheritanceUpdated = true;
 }
 
@@ -152,6 +149,8 @@ struct PropertyMapClassEntry
 	GenericPropertyMap::TAssigner* Assign{ nullptr };
 	GenericPropertyMap::TSerializer* Serialize{ nullptr };
 	GenericPropertyMap::TUnserializer* Unserialize{ nullptr };
+	GenericPropertyMap::TSerializer* SerializeFields{ nullptr };
+	GenericPropertyMap::TUnserializer* UnserializeFields{ nullptr };
 };
 
 struct PropertyMapInheritanceEntry
@@ -281,59 +280,65 @@ inline constexpr GenericPropertyMap::TAssigner* GetAssigner()
 }
 
 
-void ProcessPropertyMapDefinitions(PropertyMapRegistrationEntry const* defn)
+void RegisterPropertyMap(PropertyMapRegistrationEntry const* defn)
+{
+	assert(defn->Type == PropertyMapEntryType::Class);
+	auto const& cls = defn->Cls;
+	auto pm = new GenericPropertyMap();
+
+	/*auto& ty = TypeInformationRepository::GetInstance().RegisterType(FixedString(cls.TypeName));
+	ty.Kind = LuaTypeId::Object;
+	ty.PropertyMap = pm;
+	if (cls.ComponentName != nullptr) {			
+		ty.ComponentName = FixedString(cls.ComponentName);
+	}*/
+
+	pm->Name = FixedString(cls.Name);
+	if (cls.ComponentType != (ExtComponentType)0xffffffff) {
+		pm->ComponentType = cls.ComponentType;
+	}
+	pm->Construct = cls.Construct;
+	pm->Destroy = cls.Destroy;
+	pm->Assign = cls.Assign;
+	pm->Serialize = cls.Serialize;
+	pm->Unserialize = cls.Unserialize;
+	pm->SerializeFields = cls.SerializeFields;
+	pm->UnserializeFields = cls.UnserializeFields;
+	//pm->TypeInfo = typeInfo;
+	pm->Definitions = defn;
+	gStructRegistry.Register(pm, cls.Id);
+}
+
+
+// Registers the properties, parents and validators of a property map.
+// Called by StructRegistry::Get() on first lookup of the map.
+void InitializePropertyMap(GenericPropertyMap& pm)
 {
-	GenericPropertyMap* pm{ nullptr };
-	TypeInformation* typeInfo{ nullptr };
+	assert(pm.Definitions != nullptr);
+	pm.Init();
 
-	while (defn->Type != PropertyMapEntryType::End) {
+	for (auto defn = pm.Definitions + 1; defn->Type != PropertyMapEntryType::End; defn++) {
 		auto const& entry = *defn;
 		switch (entry.Type) {
-		case PropertyMapEntryType::Class:
-		{
-			pm = new GenericPropertyMap();
-
-			/*auto& ty = TypeInformationRepository::GetInstance().RegisterType(FixedString(entry.Cls.TypeName));
-			ty.Kind = LuaTypeId::Object;
-			ty.PropertyMap = pm;
-			if (entry.Cls.ComponentName != nullptr) {			
-				ty.ComponentName = FixedString(entry.Cls.ComponentName);
-			}*/
-
-			pm->Init();
-			pm->Name = FixedString(entry.Cls.Name);
-			if (entry.Cls.ComponentType != (ExtComponentType)0xffffffff) {
-				pm->ComponentType = entry.Cls.ComponentType;
-			}
-			pm->Construct = entry.Cls.Construct;
-			pm->Destroy = entry.Cls.Destroy;
-			pm->Assign = entry.Cls.Assign;
-			pm->Serialize = entry.Cls.Serialize;
-			pm->Unserialize = entry.Cls.Unserialize;
-			//pm->TypeInfo = typeInfo;
-			gStructRegistry.Register(pm, entry.Cls.Id);
-			break;
-		}
-
 		case PropertyMapEntryType::Inheritance:
 		{
 			auto parent = gStructRegistry.Get(entry.Inherit.ParentId);
-			MarkAsInherited(*parent, *pm);
+			MarkAsInherited(*parent, pm);
 			break;
 		}
 
 		case PropertyMapEntryType::Fallback:
 		{
-			pm->FallbackGetter = (GenericPropertyMap::TFallbackGetter*)entry.Fallback.Getter;
-			pm->FallbackSetter = (GenericPropertyMap::TFallbackSetter*)entry.Fallback.Setter;
-			pm->FallbackNext = (GenericPropertyMap::TFallbackNext*)entry.Fallback.Next;
+			pm.FallbackGetter = (GenericPropertyMap::TFallbackGetter*)entry.Fallback.Getter;
+			pm.FallbackSetter = (GenericPropertyMap::TFallbackSetter*)entry.Fallback.Setter;
+			pm.FallbackNext = (GenericPropertyMap::TFallbackNext*)entry.Fallback.Next;
 			break;
 		}
 
 		case PropertyMapEntryType::Property:
 		{
 			auto const& p = entry.Property;
-			pm->AddRawProperty(p.Name, p.Getter, p.Setter,
+			pm.AddRawProperty(p.Name, p.Getter, p.Setter,
 				p.Validate, p.Serialize, p.Offset, p.Flag,
 				p.Notification, p.NewName, p.Iterable
 			);
@@ -343,7 +348,7 @@ void ProcessPropertyMapDefinitions(PropertyMapRegistrationEntry const* defn)
 		case PropertyMapEntryType::Bitfield:
 		{
 			auto const& bf = entry.Bitfield;
-			AddBitfieldProperty(*pm, bf.TypeId,
+			AddBitfieldProperty(pm, bf.TypeId,
 				bf.Offset, bf.Getter, bf.Setter
 			);
 			break;
@@ -352,80 +357,99 @@ void ProcessPropertyMapDefinitions(PropertyMapRegistrationEntry const* defn)
 		default:
 			assert(false);
 		}
+	}
 
-		defn++;
+	if (pm.Parent != nullptr) {
+		InheritProperties(*pm.Parent, pm);
+	} else {
+		pm.InheritanceUpdated = true;
 	}
 
-	pm->Finish();
+	pm.Finish();
 }
 
 
-bool IsResolved(PropertyMapRegistrationEntry const* defn)
-{
-	while (defn->Type != PropertyMapEntryType::End) {
-		if (defn->Type == PropertyMapEntryType::Inheritance) {
-			if (defn->Inherit.ParentId >= (int)gStructRegistry.StructsById.size()
-				|| gStructRegistry.StructsById[defn->Inherit.ParentId] == nullptr) {
-				return false;
-			}
-		}
+// Forward declarations for the generated field serializers of each property map class
+#define DECLARE_CLS(id, ...) \
+	void SerializeGeneratedFields(lua_State* L, __VA_ARGS__ const* obj); \
+	void UnserializeGeneratedFields(lua_State* L, int index, __VA_ARGS__* obj, GenericPropertyMap const& pm);
+#define DECLARE_CLS_FWD(id, cls) DECLARE_CLS(id, cls)
+#define DECLARE_CLS_NS_FWD(id, ns, cls) DECLARE_CLS(id, ns::cls)
+#define DECLARE_CLS_BARE_NS_FWD(id, ns, cls) DECLARE_CLS(id, ::ns::cls)
+#define DECLARE_STRUCT_BARE_NS_FWD(id, ns, cls) DECLARE_CLS(id, ::ns::cls)
+#include <GameDefinitions/Generated/PropertyMapNames.inl>
+#undef DECLARE_CLS
+#undef DECLARE_CLS_FWD
+#undef DECLARE_CLS_NS_FWD
+#undef DECLARE_CLS_BARE_NS_FWD
+#undef DECLARE_STRUCT_BARE_NS_FWD
 
-		defn++;
-	}
+template <class T>
+void GeneratedSerializeFields(lua_State* L, void const* obj)
+{
+	SerializeGeneratedFields(L, reinterpret_cast<T const*>(obj));
+}
 
-	return true;
+template <class T>
+void GeneratedUnserializeFields(lua_State* L, int index, void* obj)
+{
+	UnserializeGeneratedFields(L, index, reinterpret_cast<T*>(obj), GetStaticPropertyMap<T>());
 }
 
+template <class T>
+inline void SerializeGeneratedField(lua_State* L, T const* value, char const* name)
+{
+	// Pointer properties are skipped, same as in GenericSerializeOffsetProperty()
+	if constexpr (!std::is_pointer_v<T>) {
+		Serialize(L, value);
+		lua_setfield(L, -2, name);
+	}
+}
 
-void ProcessClassRegistrations(std::span<PropertyMapRegistrationEntry const* const> const& classDefns)
+template <class T>
+inline void UnserializeGeneratedField(lua_State* L, int index, T* value, char const* name)
 {
-	Array<PropertyMapRegistrationEntry const*> pending;
-	for (auto defn : classDefns) pending.push_back(defn);
-
-	while (!pending.empty()) {
-		Array<PropertyMapRegistrationEntry const*> nextGen;
-
-		for (auto cls : pending) {
-			if (!IsResolved(cls)) {
-				nextGen.push_back(cls);
-			} else {
-				ProcessPropertyMapDefinitions(cls);
-			}
+	if constexpr (IsByVal<T>) {
+		if (lua_getfield(L, index, name) != LUA_TNIL) {
+			*value = get<T>(L, -1);
 		}
-
-		pending = nextGen;
+		lua_pop(L, 1);
+	} else if constexpr (!std::is_pointer_v<T>) {
+		if (lua_getfield(L, index, name) != LUA_TNIL) {
+			Unserialize(L, -1, value);
+		}
+		lua_pop(L, 1);
 	}
 }
 
-
-void UpdateInheritance()
+// Emits the warnings of a P_NOTIFY property if it is present in the table,
+// same as GenericSetOffsetProperty() does when unserializing through the property map
+void ProcessGeneratedFieldNotifications(lua_State* L, int index, GenericPropertyMap const& pm, char const* name)
 {
-	auto pendingUpdates = gStructRegistry.StructsById;
-	Array<GenericPropertyMap*> nextBatchUpdates;
-
-	do {
-		bool progressed{ false };
-		for (auto pm : pendingUpdates) {
-			if (pm == nullptr) continue;
-
-			assert(!pm->InheritanceUpdated);
-			if (pm->Parent == nullptr) {
-				pm->InheritanceUpdated = true;
-				progressed = true;
-			} else if (pm->Parent->InheritanceUpdated) {
-				InheritProperties(*pm->Parent, *pm);
-				progressed = true;
-			} else {
-				nextBatchUpdates.push_back(pm);
-			}
+	if (lua_getfield(L, index, name) != LUA_TNIL) {
+		auto prop = pm.Properties.try_get(FixedString(name));
+		if (prop != nullptr && prop->PendingNotifications != PropertyNotification::None) {
+			ProcessPropertyNotifications(*prop, true);
 		}
-
-		pendingUpdates = nextBatchUpdates;
-		nextBatchUpdates.clear();
-		assert(progressed && "Recursion in property map inheritance tree?");
-	} while (!pendingUpdates.empty());
+	}
+	lua_pop(L, 1);
 }
 
+void UnserializeGeneratedBitmask(lua_State* L, int index, void* obj, BitfieldTypeId typeId, 
+	std::size_t offset, RawPropertyAccessors::Setter* setter)
+{
+	RawPropertyAccessors prop{};
+	prop.Offset = offset;
+
+	auto store = BitfieldRegistry::Get().BitfieldsById[typeId];
+	for (auto const& label : store->Values) {
+		if (lua_getfield(L, index, label.Key.GetString()) != LUA_TNIL) {
+			prop.Flag = (uint64_t)label.Value;
+			setter(L, obj, lua_absindex(L, -1), prop);
+		}
+		lua_pop(L, 1);
+	}
+}
 
 template <class T>
 struct PropertyMapRegistrations;
@@ -446,7 +470,9 @@ struct PropertyMapRegistrations;
 			.Destroy = GetDestructor<cls>(), \
 			.Assign = GetAssigner<cls>(), \
 			.Serialize = &(DefaultSerialize<cls>), \
-			.Unserialize = &(DefaultUnserialize<cls>) \
+			.Unserialize = &(DefaultUnserialize<cls>), \
+			.SerializeFields = &(GeneratedSerializeFields<cls>), \
+			.UnserializeFields = &(GeneratedUnserializeFields<cls>) \
 		} },
 
 #define BEGIN_CLS(cls, id) BEGIN_CLS_TN(cls, cls, id)
@@ -595,6 +621,94 @@ struct PropertyMapRegistrations;
 #undef P_FALLBACK
 
 
+// Generated field serializers; these do the same work as SerializeRawObject() and
+// UnserializeRawObjectFromTable() without going through the property table
+
+#define BEGIN_CLS_TN(cls, typeName, id) void SerializeGeneratedFields(lua_State* L, cls const* obj) { \
+	using ObjectType = cls;
+#define BEGIN_CLS(cls, id) BEGIN_CLS_TN(cls, cls, id)
+#define END_CLS() }
+#define INHERIT(base) SerializeGeneratedFields(L, static_cast<base const*>(obj));
+#define PN(name, prop) SerializeGeneratedField(L, &obj->prop, #name);
+#define PN_RO(name, prop) PN(name, prop)
+#define P(prop) PN(prop, prop)
+#define P_NOTIFY(prop, notify) PN(prop, prop)
+#define P_RENAMED(prop, oldName) PN(prop, prop)
+#define P_RO(prop) PN(prop, prop)
+#define P_BITMASK_GETTER_SETTER(prop, getter, setter)
+#define P_BITMASK(prop)
+#define P_FREE_GETTER(name, fun)
+#define P_GETTER(name, fun)
+#define P_GETTER_SETTER(name, getter, setter)
+#define P_FUN(name, fun)
+#define P_FALLBACK(getter, setter, next)
+
+#include <GameDefinitions/Generated/PropertyMaps.inl>
+
+#undef BEGIN_CLS
+#undef BEGIN_CLS_TN
+#undef END_CLS
+#undef INHERIT
+#undef P
+#undef P_NOTIFY
+#undef P_RENAMED
+#undef P_RO
+#undef P_BITMASK
+#undef P_BITMASK_GETTER_SETTER
+#undef PN
+#undef PN_RO
+#undef P_GETTER
+#undef P_FREE_GETTER
+#undef P_GETTER_SETTER
+#undef P_FUN
+#undef P_FALLBACK
+
+#define BEGIN_CLS_TN(cls, typeName, id) void UnserializeGeneratedFields(lua_State* L, int index, cls* obj, GenericPropertyMap const& pm) { \
+	using ObjectType = cls;
+#define BEGIN_CLS(cls, id) BEGIN_CLS_TN(cls, cls, id)
+#define END_CLS() }
+#define INHERIT(base) UnserializeGeneratedFields(L, index, static_cast<base*>(obj), pm);
+#define PN(name, prop) UnserializeGeneratedField(L, index, &obj->prop, #name);
+#define PN_RO(name, prop)
+#define P(prop) PN(prop, prop)
+// pm is the property map of the type being unserialized, so the warnings name the same class as on the generic path
+#define P_NOTIFY(prop, notify) ProcessGeneratedFieldNotifications(L, index, pm, #prop); PN(prop, prop)
+#define P_RENAMED(prop, oldName) PN(prop, prop)
+#define P_RO(prop)
+#define P_BITMASK_GETTER_SETTER(prop, getter, setter) \
+	UnserializeGeneratedBitmask(L, index, obj, BitfieldID<decltype(ObjectType::prop)>::ID, offsetof(ObjectType, prop), &setter);
+#define P_BITMASK(prop) P_BITMASK_GETTER_SETTER(prop, (GenericSetOffsetBitmaskFlag<std::underlying_type_t<decltype(ObjectType::prop)>>), (GenericSetOffsetBitmaskFlag<std::underlying_type_t<decltype(ObjectType::prop)>>))
+#define P_FREE_GETTER(name, fun)
+#define P_GETTER(name, fun)
+#define P_GETTER_SETTER(name, getter, setter) \
+	if (lua_getfield(L, index, #name) != LUA_TNIL) { \
+		CallSetter(L, obj, lua_absindex(L, -1), &ObjectType::setter); \
+	} \
+	lua_pop(L, 1);
+#define P_FUN(name, fun)
+#define P_FALLBACK(getter, setter, next)
+
+#include <GameDefinitions/Generated/PropertyMaps.inl>
+
+#undef BEGIN_CLS
+#undef BEGIN_CLS_TN
+#undef END_CLS
+#undef INHERIT
+#undef P
+#undef P_NOTIFY
+#undef P_RENAMED
+#undef P_RO
+#undef P_BITMASK
+#undef P_BITMASK_GETTER_SETTER
+#undef PN
+#undef PN_RO
+#undef P_GETTER
+#undef P_FREE_GETTER
+#undef P_GETTER_SETTER
+#undef P_FUN
+#undef P_FALLBACK
+
+
 static constexpr PropertyMapRegistrationEntry const* AllClassDefns[] = {
 
 
@@ -618,8 +732,11 @@ void InitObjectProxyPropertyMaps()
 	static bool initialized{ false };
 	if (initialized) return;
 
-	ProcessClassRegistrations(std::span(AllClassDefns));
-	UpdateInheritance();
+	// Only class-level information is registered here; properties are added
+	// on first lookup of each map (see InitializePropertyMap())
+	for (auto defn : AllClassDefns) {
+		RegisterPropertyMap(defn);
+	}
 
 	initialized = true;
 }
@@ -13,6 +13,7 @@ enum class PropertyNotification
 };
 
 class GenericPropertyMap;
+struct PropertyMapRegistrationEntry;
 
 struct RawPropertyAccessors
 {
@@ -93,10 +94,16 @@ public:
 	TAssigner* Assign{ nullptr };
 	TSerializer* Serialize{ nullptr };
 	TUnserializer* Unserialize{ nullptr };
+	// Type-specific field (un)serializers generated from the property map definitions;
+	// used instead of walking the property table when available
+	TSerializer* SerializeFields{ nullptr };
+	TUnserializer* UnserializeFields{ nullptr };
 	GenericPropertyMap const* Parent{ nullptr };
 	std::size_t Size{ 0 };
+	// Static property definitions; the map is populated from these on first lookup
+	PropertyMapRegistrationEntry const* Definitions{ nullptr };
 	bool IsInitializing{ false };
-	bool Initialized{ false };
+	std::atomic<bool> Initialized{ false };
 	bool InheritanceUpdated{ false };
 	ValidationState Validated{ ValidationState::Unknown };
 	StructTypeId RegistryIndex{ -1 };
@@ -104,6 +111,9 @@ public:
 	TypeInformation* TypeInfo{ nullptr };
 };
 
+// Allows disabling generated field serializers to compare them with the generic path
+extern bool gUseGeneratedSerializers;
+
 inline PropertyOperationResult GenericSetNonWriteableProperty(lua_State* L,  void* obj, int index, RawPropertyAccessors const&)
 {
 	return PropertyOperationResult::UnsupportedType;
@@ -158,17 +168,40 @@ void DefaultAssign(void* object, void* rhs)
 }
 
 
+void InitializePropertyMap(GenericPropertyMap& pm);
+
 struct StructRegistry
 {
 	Array<GenericPropertyMap*> StructsById;
 
 	void Register(GenericPropertyMap* ei, StructTypeId id);
+	void InitializeAll();
 
 	inline GenericPropertyMap* Get(StructTypeId id) const
+	{
+		assert(id < (int)StructsById.size());
+		auto pm = StructsById[id];
+		if (pm != nullptr && !pm->Initialized) [[unlikely]] {
+			InitializeLazy(*pm);
+		}
+
+		return pm;
+	}
+
+	// Fetches a property map without initializing it; only class-level fields 
+	// (name, registry index, component type, constructors, ...) are usable
+	inline GenericPropertyMap* Peek(StructTypeId id) const
 	{
 		assert(id < (int)StructsById.size());
 		return StructsById[id];
 	}
+
+private:
+	// Initialization may happen concurrently from the server and client threads
+	// and recurses into the parent maps of the type being initialized
+	mutable std::recursive_mutex lazyInitLock_;
+
+	void InitializeLazy(GenericPropertyMap& pm) const;
 };
 
 extern StructRegistry gStructRegistry;
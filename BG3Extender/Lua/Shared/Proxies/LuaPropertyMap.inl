@@ -3,10 +3,11 @@
 BEGIN_NS(lua)
 
 StructRegistry gStructRegistry;
+bool gUseGeneratedSerializers{ true };
 
 void StructRegistry::Register(GenericPropertyMap* pm, StructTypeId id)
 {
-	assert(pm->IsInitializing);
+	assert(!pm->Initialized);
 	pm->RegistryIndex = id;
 
 	if (StructsById.size() < (uint32_t)id + 1) {
@@ -16,6 +17,23 @@ void StructRegistry::Register(GenericPropertyMap* pm, StructTypeId id)
 	StructsById[id] = pm;
 }
 
+void StructRegistry::InitializeLazy(GenericPropertyMap& pm) const
+{
+	std::lock_guard _(lazyInitLock_);
+	// Recursing into a map that is being initialized means that the inheritance tree has a cycle
+	assert(!pm.IsInitializing);
+	if (!pm.Initialized) {
+		InitializePropertyMap(pm);
+	}
+}
+
+void StructRegistry::InitializeAll()
+{
+	for (auto i = 0; i < (int)StructsById.size(); i++) {
+		Get(i);
+	}
+}
+
 void GenericPropertyMap::Init()
 {
 	assert(!IsInitializing && !Initialized);
@@ -157,7 +175,12 @@ bool GenericPropertyMap::IsA(int typeRegistryIndex) const
 void SerializeRawObject(lua_State* L, void const* obj, GenericPropertyMap const& pm)
 {
 	StackCheck _(L, 1);
-	lua_createtable(L, 0, (int)pm.Properties.size());
+	lua_createtable(L, 0, (int)pm.IterableProperties.size());
+	if (pm.SerializeFields != nullptr && gUseGeneratedSerializers) {
+		pm.SerializeFields(L, obj);
+		return;
+	}
+
 	for (auto it : pm.IterableProperties) {
 		auto const& prop = pm.Properties.values()[it.Value()];
 		if (prop.Serialize != nullptr) {
@@ -172,6 +195,12 @@ void SerializeRawObject(lua_State* L, void const* obj, GenericPropertyMap const&
 void UnserializeRawObjectFromTable(lua_State* L, int index, void* obj, GenericPropertyMap const& pm)
 {
 	StackCheck _(L);
+	index = lua_absindex(L, index);
+	if (pm.UnserializeFields != nullptr && gUseGeneratedSerializers) {
+		pm.UnserializeFields(L, index, obj);
+		return;
+	}
+
 	for (auto it : pm.IterableProperties) {
 		auto const& prop = pm.Properties.values()[it.Value()];
 		lua_getfield(L, index, it.Key().GetString());
@@ -10,6 +10,8 @@ public:
 	int GetRegistryIndex() const;
 	virtual TypeInformation const& GetContainerType() const = 0;
 	virtual TypeInformation const& GetElementType() const = 0;
+	// Whether string keys can refer to set elements (i.e. they may shadow container methods)
+	virtual bool HasStringKeys() const = 0;
 	virtual bool GetElementAt(lua_State* L, CppObjectMetadata& self, unsigned int arrayIndex) = 0;
 	virtual bool HasElement(lua_State* L, CppObjectMetadata& self, int luaIndex) = 0;
 	virtual bool AddElement(lua_State* L, CppObjectMetadata& self, int luaIndex) = 0;
@@ -18,6 +20,7 @@ public:
 	virtual unsigned Length(CppObjectMetadata& self) = 0;
 	virtual bool Unserialize(lua_State* L, CppObjectMetadata& self, int index) = 0;
 	virtual void Serialize(lua_State* L, CppObjectMetadata& self) = 0;
+	virtual void ToTable(lua_State* L, CppObjectMetadata& self, int depth) = 0;
 
 private:
 	int registryIndex_{ -1 };
@@ -43,6 +46,11 @@ public:
 		return GetTypeInfo<T>();
 	}
 
+	bool HasStringKeys() const override
+	{
+		return std::is_same_v<T, FixedString> || std::is_same_v<T, STDString>;
+	}
+
 	bool GetElementAt(lua_State* L, CppObjectMetadata& self, unsigned int arrayIndex) override
 	{
 		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
@@ -112,6 +120,18 @@ public:
 		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
 		lua::Serialize(L, obj);
 	}
+
+	void ToTable(lua_State* L, CppObjectMetadata& self, int depth) override
+	{
+		auto obj = reinterpret_cast<ContainerType*>(self.Ptr);
+		auto size = obj->size();
+		lua_createtable(L, (int)size, 0);
+		for (uint32_t i = 0; i < size; i++) {
+			// TODO - jank, but const proxies are not supported yet
+			push(L, const_cast<T*>(&obj->keys()[i]), self.Lifetime);
+			lua_rawseti(L, -2, i + 1);
+		}
+	}
 };
 
 
@@ -51,6 +51,12 @@ SetProxyImplBase* SetProxyMetatable::GetImpl(int propertyMapIndex)
 int SetProxyMetatable::Index(lua_State* L, CppObjectMetadata& self)
 {
 	auto impl = gExtender->GetPropertyMapManager().GetSetProxy(self.PropertyMapTag);
+	// String sets always test membership; use Ext.Types.ToTable() to convert them
+	if (!impl->HasStringKeys() && lua_type(L, 2) == LUA_TSTRING && get<FixedString>(L, 2) == GFS.strToTable) {
+		lua_pushcfunction(L, &ContainerProxyHelpers::ToTableProxy);
+		return 1;
+	}
+
 	push(L, impl->HasElement(L, self, 2));
 	return 1;
 }
@@ -38,7 +38,7 @@ void RegisterObjectProxyTypeInformation()
 	auto& ty = TypeInformationRepository::GetInstance().RegisterType(FixedString(#typeName)); \
 	ty.Kind = LuaTypeId::Object; \
 	ty.NativeName = FixedString(typeid(TClass).name()); \
-	ty.PropertyMap = &lua::GetStaticPropertyMap<TClass>(); \
+	ty.PropertyMap = lua::gStructRegistry.Peek(lua::StructID<TClass>::ID); \
 	if constexpr (std::is_base_of_v<BaseComponent, TClass> && !std::is_same_v<BaseComponent, TClass> && !std::is_same_v<BaseProxyComponent, TClass>) { \
 		ty.ComponentName = FixedString(TClass::ComponentName); \
 	} \
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <unordered_map>
+#include <deque>
+
+BEGIN_NS(lua)
+
+// Keeps track of the mod that loaded each Lua chunk (via Ext.Utils.Include / mod bootstrap scripts),
+// so that profiling and accounting data can be attributed to mods.
+class ScriptOriginMap
+{
+public:
+	void Register(StringView chunkName, FixedString const& mod)
+	{
+		auto it = chunks_.find(chunkName);
+		if (it != chunks_.end()) {
+			it->second = mod;
+		} else {
+			auto& name = names_.emplace_back(chunkName);
+			chunks_.insert(std::make_pair(std::string_view(name), mod));
+		}
+	}
+
+	// Looks up the mod of a chunk by its source name, as returned by lua_getinfo()
+	FixedString Find(char const* source) const
+	{
+		if (source == nullptr) return FixedString{};
+
+		std::string_view name(source);
+		if (name.starts_with("builtin://")) {
+			return builtinMod_;
+		}
+
+		auto it = chunks_.find(name);
+		if (it != chunks_.end()) {
+			return it->second;
+		} else {
+			return FixedString{};
+		}
+	}
+
+private:
+	FixedString builtinMod_{ "builtin" };
+	std::unordered_map<std::string_view, FixedString> chunks_;
+	// Backing storage for chunk names
+	std::deque<STDString> names_;
+};
+
+END_NS()
@@ -0,0 +1,199 @@
+#include <stdafx.h>
+#include <Lua/LuaBinding.h>
+#include <Lua/Shared/ScriptPrefetcher.h>
+#include <Extender/ScriptExtender.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+
+BEGIN_NS(lua)
+
+ScriptPrefetcher::~ScriptPrefetcher()
+{
+	cancel_ = true;
+	for (auto& worker : workers_) {
+		worker.join();
+	}
+}
+
+void ScriptPrefetcher::Start(std::vector<ModRequest>&& mods)
+{
+	Finish();
+	if (mods.empty()) return;
+
+	mods_.resize(mods.size());
+	for (std::size_t i = 0; i < mods.size(); i++) {
+		auto& mod = mods_[i];
+		mod.Request = std::move(mods[i]);
+		mod.Stats.Name = mod.Request.Name;
+		modsByDirectory_.insert(std::make_pair(mod.Request.Directory, &mod));
+	}
+
+	cancel_ = false;
+	nextMod_ = 0;
+	auto numWorkers = std::clamp(std::thread::hardware_concurrency() / 2, 1u, MaxWorkers);
+	numWorkers = std::min(numWorkers, (unsigned)mods_.size());
+	for (unsigned i = 0; i < numWorkers; i++) {
+		workers_.emplace_back(&ScriptPrefetcher::WorkerMain, this);
+	}
+}
+
+std::optional<ScriptPrefetcher::Script> ScriptPrefetcher::Take(STDString const& modDirectory, STDString const& chunkName)
+{
+	auto modIt = modsByDirectory_.find(modDirectory);
+	if (modIt == modsByDirectory_.end()) return {};
+
+	auto& mod = *modIt->second;
+	std::unique_lock lock(mutex_);
+	if (!mod.Done) {
+		auto waitStart = Clock::now();
+		modDone_.wait(lock, [&mod] { return mod.Done; });
+		mod.Stats.WaitTime += Clock::now() - waitStart;
+	}
+
+	auto it = mod.Scripts.find(chunkName);
+	if (it == mod.Scripts.end()) return {};
+
+	auto script = std::move(it->second);
+	mod.Scripts.erase(it);
+	mod.Stats.Used++;
+	mod.Stats.UsedPrefetchTime += script.PrefetchTime;
+	return script;
+}
+
+void ScriptPrefetcher::OnScriptLoaded(STDString const& modDirectory, Clock::duration loadTime)
+{
+	auto modIt = modsByDirectory_.find(modDirectory);
+	if (modIt != modsByDirectory_.end()) {
+		modIt->second->Stats.LoadTime += loadTime;
+	}
+}
+
+void ScriptPrefetcher::Finish()
+{
+	if (workers_.empty()) return;
+
+	cancel_ = true;
+	for (auto& worker : workers_) {
+		worker.join();
+	}
+	workers_.clear();
+
+	using namespace std::chrono;
+	Clock::duration totalSaved{ 0 };
+	for (auto const& mod : mods_) {
+		auto const& stats = mod.Stats;
+		if (stats.Prefetched == 0) continue;
+
+		// Without prefetching the main thread would have spent the same time reading and compiling the used scripts
+		auto saved = stats.UsedPrefetchTime - stats.LoadTime - stats.WaitTime;
+		totalSaved += saved;
+		DEBUG("Prefetched %d scripts of '%s' (%d used): %d us on workers, %d us loading, %d us waiting; saved %d us",
+			stats.Prefetched, stats.Name.GetString(), stats.Used,
+			(int)duration_cast<microseconds>(stats.PrefetchTime).count(),
+			(int)duration_cast<microseconds>(stats.LoadTime).count(),
+			(int)duration_cast<microseconds>(stats.WaitTime).count(),
+			(int)duration_cast<microseconds>(saved).count());
+	}
+
+	DEBUG("Script prefetch saved %d us of main thread time", (int)duration_cast<microseconds>(totalSaved).count());
+
+	modsByDirectory_.clear();
+	mods_.clear();
+}
+
+void ScriptPrefetcher::WorkerMain()
+{
+	LuaPoolAllocator allocator;
+	auto L = lua_newstate(&LuaPoolAllocator::LuaAlloc, &allocator);
+	lua_setup_strcache(L, &LuaCacheString, &LuaReleaseString);
+
+	BytecodeCache::Stats cacheStats;
+	for (;;) {
+		auto index = nextMod_++;
+		if (index >= mods_.size() || cancel_) break;
+
+		auto& mod = mods_[index];
+		PrefetchMod(L, mod, cacheStats);
+
+		{
+			std::lock_guard _(mutex_);
+			mod.Done = true;
+		}
+		modDone_.notify_all();
+	}
+
+	lua_close(L);
+}
+
+void ScriptPrefetcher::PrefetchMod(lua_State* L, ModState& mod, BytecodeCache::Stats& cacheStats)
+{
+	auto& cache = gExtender->GetBytecodeCache();
+	auto modStart = Clock::now();
+
+	std::vector<STDString> pending{ mod.Request.BootstrapFile };
+	std::unordered_set<STDString> visited{ mod.Request.BootstrapFile };
+	std::vector<STDString> required;
+
+	while (!pending.empty() && !cancel_) {
+		auto fileName = std::move(pending.back());
+		pending.pop_back();
+
+		auto start = Clock::now();
+		auto reader = GetStaticSymbols().MakeFileReader(mod.Request.ScriptRoot + fileName);
+		if (!reader.IsLoaded()) continue;
+
+		Script script;
+		script.Source = reader.ToString();
+		auto chunkName = mod.Request.ChunkPrefix + fileName;
+		// Scripts with syntax errors are compiled again by the main state, which reports the error
+		if (cache.GetBytecode(L, script.Source, chunkName.c_str(), script.Bytecode, cacheStats)) {
+			FindRequires(script.Source, required);
+			script.PrefetchTime = Clock::now() - start;
+			mod.Scripts.insert(std::make_pair(chunkName, std::move(script)));
+			mod.Stats.Prefetched++;
+		}
+
+		for (auto& file : required) {
+			if (visited.insert(file).second) {
+				pending.push_back(std::move(file));
+			}
+		}
+		required.clear();
+	}
+
+	mod.Stats.PrefetchTime = Clock::now() - modStart;
+}
+
+void ScriptPrefetcher::FindRequires(std::string_view source, std::vector<STDString>& files)
+{
+	static constexpr std::string_view RequireCall = "Ext.Require(";
+
+	auto skipSpaces = [source](std::size_t pos) {
+		while (pos < source.size() && isspace((unsigned char)source[pos])) pos++;
+		return pos;
+	};
+
+	std::size_t pos{ 0 };
+	while ((pos = source.find(RequireCall, pos)) != std::string_view::npos) {
+		pos = skipSpaces(pos + RequireCall.size());
+		if (pos >= source.size() || (source[pos] != '"' && source[pos] != '\'')) continue;
+
+		auto quote = source[pos++];
+		auto end = source.find(quote, pos);
+		if (end == std::string_view::npos) break;
+
+		auto path = source.substr(pos, end - pos);
+		pos = skipSpaces(end + 1);
+
+		// Only the single argument form loads a script from the calling mod; paths with escape sequences are skipped
+		if (pos < source.size() && source[pos] == ')'
+			&& !path.empty()
+			&& !path.starts_with("builtin://")
+			&& path.find('\\') == std::string_view::npos) {
+			files.push_back(STDString(path));
+		}
+	}
+}
+
+END_NS()
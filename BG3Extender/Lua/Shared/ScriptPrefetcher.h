@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Lua/Shared/BytecodeCache.h>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+BEGIN_NS(lua)
+
+// Reads and compiles mod bootstrap scripts on worker threads while earlier mods are being loaded.
+// Starting from the bootstrap file of each mod, scripts referenced via Ext.Require("<file>") with a literal
+// path are followed recursively; mod script directories may be inside .pak files, so they can't be enumerated.
+// Each worker compiles in its own scratch Lua state and produces bytecode (from the bytecode cache when possible),
+// so the main state only needs to load the precompiled chunk.
+class ScriptPrefetcher : Noncopyable<ScriptPrefetcher>
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr unsigned MaxWorkers = 4;
+
+	struct ModRequest
+	{
+		STDString Directory;
+		FixedString Name;
+		// Path of the mod Lua script directory (with trailing slash)
+		STDString ScriptRoot;
+		// Prefix of chunk names of scripts in the mod Lua directory
+		STDString ChunkPrefix;
+		STDString BootstrapFile;
+	};
+
+	struct Script
+	{
+		STDString Source;
+		STDString Bytecode;
+		Clock::duration PrefetchTime{ 0 };
+	};
+
+	struct ModStats
+	{
+		FixedString Name;
+		// Number of scripts read and compiled by the workers
+		uint32_t Prefetched{ 0 };
+		// Number of prefetched scripts loaded by the main state
+		uint32_t Used{ 0 };
+		// Time spent on reading and compiling scripts on worker threads
+		Clock::duration PrefetchTime{ 0 };
+		// Time spent on reading and compiling the scripts that were loaded by the main state
+		Clock::duration UsedPrefetchTime{ 0 };
+		// Time spent on the main thread loading prefetched bytecode
+		Clock::duration LoadTime{ 0 };
+		// Time the main thread spent waiting for the mod prefetch to complete
+		Clock::duration WaitTime{ 0 };
+	};
+
+	~ScriptPrefetcher();
+
+	inline bool IsRunning() const
+	{
+		return !workers_.empty();
+	}
+
+	void Start(std::vector<ModRequest>&& mods);
+	// Takes the prefetched script from the prefetcher, waiting for the workers to finish prefetching the mod if needed
+	std::optional<Script> Take(STDString const& modDirectory, STDString const& chunkName);
+	// Records the time the main state spent loading a prefetched script
+	void OnScriptLoaded(STDString const& modDirectory, Clock::duration loadTime);
+	// Stops the workers, discards unused scripts and logs the time saved for each mod
+	void Finish();
+
+private:
+	struct ModState
+	{
+		ModRequest Request;
+		std::unordered_map<STDString, Script> Scripts;
+		ModStats Stats;
+		bool Done{ false };
+	};
+
+	std::vector<ModState> mods_;
+	std::unordered_map<STDString, ModState*> modsByDirectory_;
+	std::vector<std::thread> workers_;
+	std::atomic<uint32_t> nextMod_{ 0 };
+	std::atomic<bool> cancel_{ false };
+	std::mutex mutex_;
+	std::condition_variable modDone_;
+
+	void WorkerMain();
+	void PrefetchMod(lua_State* L, ModState& mod, BytecodeCache::Stats& cacheStats);
+	static void FindRequires(std::string_view source, std::vector<STDString>& files);
+};
+
+END_NS()
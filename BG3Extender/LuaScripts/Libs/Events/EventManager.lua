@@ -58,7 +58,7 @@ end
 function EventManager:NetMessageReceived(channel, payload, userId)
 	if self.NetListeners[channel] ~= nil then
 		for i,callback in pairs(self.NetListeners[channel]) do
-			local ok, err = xpcall(callback, debug.traceback, channel, payload, userId)
+			local ok, err = Ext._Events.CallHandler(callback, channel, payload, userId)
 			if not ok then
 				Ext.Utils.PrintError("Error during NetMessage dispatch: ", err)
 			end
@@ -103,10 +103,6 @@ function EventManager:Expose()
         self:RegisterConsoleCommand(cmd, fn)
     end
     
-    _I._ThrowEvent = function (event)
-        self:ThrowEvent(event)
-    end
-
     _I._NetMessageReceived = function (channel, payload, userId)
         self:NetMessageReceived(channel, payload, userId)
     end
@@ -0,0 +1,303 @@
+-- Number of elements processed by each container benchmark iteration
+local CONTAINER_ELEMENTS = 10000
+
+local function CopyWithPairs(arr)
+    local tab = {}
+    for i,v in pairs(arr) do
+        tab[i] = v
+    end
+    return tab
+end
+
+function BenchContainerToTable()
+    local arr = Ext.Stats.GetStatsManager().TreasureTables.Primitives
+    local passes = math.ceil(CONTAINER_ELEMENTS / #arr)
+    local elements = passes * #arr
+
+    local pairsTime = Benchmark("pairs() copy, " .. elements .. " elements", 100, function ()
+        for i=1,passes do
+            CopyWithPairs(arr)
+        end
+    end)
+
+    local toTableTime = Benchmark("ToTable(), " .. elements .. " elements", 100, function ()
+        for i=1,passes do
+            arr:ToTable()
+        end
+    end)
+
+    Ext.Utils.Print(string.format("ToTable() speedup: %.2fx", pairsTime / toTableTime))
+end
+
+function BenchComponentSerialize()
+    local stats = Ext.Entity.Get("58a69333-40bf-8358-1d17-fff240d7fb12").Stats
+
+    Ext.DevTests.SetGeneratedSerializers(false)
+    local genericTime = Benchmark("Serialize StatsComponent (generic)", 10000, function ()
+        Ext.Types.Serialize(stats)
+    end)
+    local serialized = Ext.Types.Serialize(stats)
+    local genericUnserializeTime = Benchmark("Unserialize StatsComponent (generic)", 10000, function ()
+        Ext.Types.Unserialize(stats, serialized)
+    end)
+
+    Ext.DevTests.SetGeneratedSerializers(true)
+    local generatedTime = Benchmark("Serialize StatsComponent (generated)", 10000, function ()
+        Ext.Types.Serialize(stats)
+    end)
+    local generatedUnserializeTime = Benchmark("Unserialize StatsComponent (generated)", 10000, function ()
+        Ext.Types.Unserialize(stats, serialized)
+    end)
+
+    Ext.Utils.Print(string.format("Generated serializer speedup: %.2fx, unserializer speedup: %.2fx", 
+        genericTime / generatedTime, genericUnserializeTime / generatedUnserializeTime))
+end
+
+function BenchEventDispatch()
+    local counter = 0
+    local subscriptions = {}
+    for i=1,10 do
+        table.insert(subscriptions, Ext._Events.Subscribe("Benchmarks.Dispatch", function (e)
+            counter = counter + 1
+        end, 100, false))
+    end
+
+    local event = {}
+    Benchmark("Event dispatch, 10 subscribers", 100000, function ()
+        Ext._Events.Throw("Benchmarks.Dispatch", event)
+    end)
+
+    for i,id in ipairs(subscriptions) do
+        Ext._Events.Unsubscribe("Benchmarks.Dispatch", id)
+    end
+end
+
+function BenchDeferredCalls()
+    local counter = 0
+    local calls = 100000
+    local queueTime, flushTime = Ext.DevTests.BenchmarkDeferredCalls(function (i)
+        counter = counter + 1
+    end, calls, 10)
+    Ext.Utils.Print(string.format("Deferred calls, %d calls/frame: queue %.2f us/frame (%.1f ns/call), flush %.2f us/frame (%.1f ns/call)",
+        calls, queueTime, queueTime * 1000 / calls, flushTime, flushTime * 1000 / calls))
+end
+
+function BenchTimers()
+    local timers = 100000
+    local wheelTime, heapTime, peakHeapSize = Ext.DevTests.BenchmarkTimers(timers)
+    Ext.Utils.Print(string.format("%d timers, 1000 frames: timing wheel %.2f ms, binary heap %.2f ms (peak %d queued), speedup %.2fx",
+        timers, wheelTime / 1000, heapTime / 1000, peakHeapSize, heapTime / wheelTime))
+end
+
+-- Synthetic workload creating lots of small tables, strings and closures
+local AllocatorWorkload = [[
+    local objs = {}
+    for i = 1, 20000 do
+        local t = { X = i, Y = i * 2, Name = "Obj" .. i, Tags = { "a", "b" } }
+        t.Get = function () return t.X + t.Y end
+        objs[i % 1000 + 1] = t
+    end
+
+    local parts = {}
+    for i = 1, 5000 do
+        parts[#parts + 1] = string.format("%d:%s", i, objs[i % 1000 + 1].Name)
+    end
+    local str = table.concat(parts, ",")
+]]
+
+function BenchAllocator()
+    local pooledTime, gameTime, stats = Ext.DevTests.BenchmarkAllocator(AllocatorWorkload, 20)
+    Ext.Utils.Print(string.format("Table-heavy workload, 20 iterations: pooled allocator %.2f ms, game allocator %.2f ms",
+        pooledTime / 1000, gameTime / 1000))
+    Ext.Utils.Print(string.format("Pooled allocator: peak used %d KB, peak reserved %d KB, trimmed %d KB, reserved at exit %d KB",
+        stats.PeakUsedBytes // 1024, stats.PeakReservedBytes // 1024, stats.TrimmedBytes // 1024, stats.ReservedBytes // 1024))
+end
+
+-- Generates a script similar to a large mod bootstrap (many functions and table constructors)
+local function GenerateScript(numFunctions)
+    local parts = {}
+    for i = 1, numFunctions do
+        parts[#parts + 1] = string.format([[
+local function Handler%d(e)
+    local data = { Id = %d, Name = "Handler%d", Values = { 1, 2, 3 } }
+    if e.Value > data.Id then
+        return data.Name .. tostring(e.Value)
+    end
+    for i, v in ipairs(data.Values) do
+        data.Id = data.Id + v * i
+    end
+    return data
+end
+]], i, i, i)
+    end
+    return table.concat(parts, "\n")
+end
+
+function BenchBytecodeCache()
+    local script = GenerateScript(1000)
+    local compileTime, loadTime, bytecodeSize = Ext.DevTests.BenchmarkBytecodeCache(script, 20)
+    Ext.Utils.Print(string.format("%d KB script, 20 iterations: compile %.2f ms, bytecode load %.2f ms (%d KB), speedup %.2fx",
+        #script // 1024, compileTime / 1000, loadTime / 1000, bytecodeSize // 1024, compileTime / loadTime))
+
+    local stats = Ext.Debug.GetBytecodeCacheStats()
+    Ext.Utils.Print(string.format("Startup: %d scripts from cache in %.2f ms, %d compiled in %.2f ms (cache enabled: %s)",
+        stats.Hits, stats.LoadTimeUs / 1000, stats.Misses, stats.CompileTimeUs / 1000, tostring(stats.Enabled)))
+end
+
+function BenchLuaBundle()
+    local results = Ext.DevTests.BenchmarkLuaBundle(100)
+    for i,format in ipairs({"V1", "V2", "V2Compressed"}) do
+        local result = results[format]
+        if result ~= nil then
+            Ext.Utils.Print(string.format("Builtin bundle %s: %d KB, load and lookup %.2f us", format, result.Size // 1024, result.LoadUs))
+        end
+    end
+end
+
+-- Generates a JSON document of approximately the requested size, similar to a mod config or persisted state blob
+local function GenerateJson(sizeKb)
+    local record = Ext.Json.Stringify({
+        Id = 12345,
+        Name = "Item \"Name\" with escapes\n",
+        Position = { 1.5, -20.25, 300.125 },
+        Flags = { Visible = true, Locked = false },
+        Tags = { "tag_a", "tag_b", "tag_c", "tag_d" }
+    }, false)
+    local count = math.max(1, math.ceil(sizeKb * 1024 / (#record + 1)))
+    return "[" .. string.rep(record, count, ",") .. "]"
+end
+
+function BenchJsonParse()
+    for i,sizeMb in ipairs({1, 10, 50}) do
+        local json = GenerateJson(sizeMb * 1024)
+        local streamingTime, domTime = Ext.DevTests.BenchmarkJsonParse(json, 3)
+        Ext.Utils.Print(string.format("Parse %d MB JSON: streaming %.2f ms, jsoncpp DOM %.2f ms, speedup %.2fx",
+            #json // (1024 * 1024), streamingTime / 1000, domTime / 1000, domTime / streamingTime))
+    end
+end
+
+-- Generates a nested table similar to mod state tables (records with nested arrays and maps)
+local function GenerateNestedTable(numRecords)
+    local tab = {}
+    for i = 1, numRecords do
+        tab["Record" .. i] = {
+            Id = i,
+            Name = "Record " .. i,
+            Weight = i * 0.25,
+            Position = { i, i * 2.5, -i },
+            Children = { { Id = i * 10, Enabled = true }, { Id = i * 10 + 1, Enabled = false } }
+        }
+    end
+    return tab
+end
+
+function BenchJsonStringify()
+    local tab = GenerateNestedTable(100000)
+    local streamingTime, domTime, size, identical = Ext.DevTests.BenchmarkJsonStringify(tab, 3)
+    Ext.Utils.Print(string.format("Stringify %d KB nested table: streaming %.2f ms, jsoncpp DOM %.2f ms, speedup %.2fx, identical output: %s",
+        size // 1024, streamingTime / 1000, domTime / 1000, domTime / streamingTime, tostring(identical)))
+
+    local entity = Ext.Entity.Get("58a69333-40bf-8358-1d17-fff240d7fb12")
+    streamingTime, domTime, size, identical = Ext.DevTests.BenchmarkJsonStringify(entity, 3, true)
+    Ext.Utils.Print(string.format("Stringify %d KB entity dump: streaming %.2f ms, jsoncpp DOM %.2f ms, speedup %.2fx, identical output: %s",
+        size // 1024, streamingTime / 1000, domTime / 1000, domTime / streamingTime, tostring(identical)))
+end
+
+function BenchMsgPack()
+    local tab = GenerateNestedTable(20000)
+    local json = Ext.Json.Stringify(tab, false)
+    local packed = Ext.MsgPack.Pack(tab)
+    Ext.Utils.Print(string.format("Nested table: JSON %d KB, MessagePack %d KB", #json // 1024, #packed // 1024))
+
+    local stringifyTime = Benchmark("Ext.Json.Stringify", 10, function () Ext.Json.Stringify(tab, false) end)
+    local packTime = Benchmark("Ext.MsgPack.Pack", 10, function () Ext.MsgPack.Pack(tab) end)
+    local parseTime = Benchmark("Ext.Json.Parse", 10, function () Ext.Json.Parse(json) end)
+    local unpackTime = Benchmark("Ext.MsgPack.Unpack", 10, function () Ext.MsgPack.Unpack(packed) end)
+    Ext.Utils.Print(string.format("MessagePack speedup: encode %.2fx, decode %.2fx", stringifyTime / packTime, parseTime / unpackTime))
+end
+
+function BenchUserVarComposite()
+    -- Uncached variable, so every read decodes and every write encodes the composite value
+    Ext.Vars.RegisterUserVariable("BenchCompositeVar", {
+        Server = true,
+        Persistent = false,
+        DontCache = true,
+        SyncOnTick = false
+    })
+
+    local entity = Ext.Entity.Get("58a69333-40bf-8358-1d17-fff240d7fb12")
+    local tab = GenerateNestedTable(100)
+    entity.Vars.BenchCompositeVar = tab
+
+    local readTime = Benchmark("Composite user variable read", 1000, function () local v = entity.Vars.BenchCompositeVar end)
+    local writeTime = Benchmark("Composite user variable write", 1000, function () entity.Vars.BenchCompositeVar = tab end)
+    -- Cost of the JSON round trip that composite variables used to go through
+    local json = Ext.Json.Stringify(tab, false)
+    local parseTime = Benchmark("JSON parse", 1000, function () Ext.Json.Parse(json) end)
+    local stringifyTime = Benchmark("JSON stringify", 1000, function () Ext.Json.Stringify(tab, false) end)
+    Ext.Utils.Print(string.format("Composite user variable: read %.2f us (JSON parse %.2f us), write %.2f us (JSON stringify %.2f us)",
+        readTime, parseTime, writeTime, stringifyTime))
+
+    entity.Vars.BenchCompositeVar = nil
+end
+
+function BenchUserVarChangeDetection()
+    -- 10k entities, each holding a mid-sized table variable
+    local values = {}
+    for i = 1, 10000 do
+        values[i] = GenerateNestedTable(20)
+    end
+
+    local hashTime, packTime = Ext.DevTests.BenchmarkUserVarChangeDetection(values, 5)
+    Ext.Utils.Print(string.format("Change detection for %d table variables: structural hash %.2f ms, pack %.2f ms, speedup %.2fx",
+        #values, hashTime / 1000, packTime / 1000, packTime / hashTime))
+end
+
+function BenchTimerBatching()
+    local timers = 1000
+    local before = Ext.Timer.GetBatchingStats()
+    local fired = 0
+    local onBatch = function (handles, args)
+        fired = fired + #handles
+        if fired == timers then
+            local stats = Ext.Timer.GetBatchingStats()
+            local dispatches = stats.Dispatches - before.Dispatches
+            Ext.Utils.Print(string.format("Batched timers: %d timers fired in %d dispatches, %d dispatches saved",
+                timers, dispatches, timers - dispatches))
+        end
+    end
+
+    -- Timers spread over 500 ms, merged into 50 ms windows
+    for i = 1, timers do
+        Ext.Timer.WaitForBatched(math.random(0, 500), onBatch, i, 50)
+    end
+end
+
+RegisterBenchmarks("Containers", {
+    "BenchContainerToTable"
+})
+
+RegisterBenchmarks("Serialization", {
+    "BenchComponentSerialize",
+    "BenchJsonParse",
+    "BenchJsonStringify",
+    "BenchMsgPack",
+    "BenchUserVarComposite",
+    "BenchUserVarChangeDetection"
+})
+
+RegisterBenchmarks("Events", {
+    "BenchEventDispatch",
+    "BenchDeferredCalls",
+    "BenchTimers",
+    "BenchTimerBatching"
+})
+
+RegisterBenchmarks("Memory", {
+    "BenchAllocator"
+})
+
+RegisterBenchmarks("Startup", {
+    "BenchBytecodeCache",
+    "BenchLuaBundle"
+})
@@ -1,3 +1,5 @@
 Ext.Utils.Include(nil, "builtin://Tests/TestHelpers.lua")
 Ext.Utils.Include(nil, "builtin://Tests/StatTests.lua")
 Ext.Utils.Include(nil, "builtin://Tests/ResourceTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/SerializationTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/Benchmarks.lua")
@@ -51,9 +51,45 @@ function TestECSFunctions()
     -- GetSalt and GetIndex have no deterministic outputs
 end
 
+function TestECSBulkProperties()
+    local health = Ext.Entity.Get(GUID_LAEZEL).Health
+
+    local hp, maxHp = Ext.Types.GetProperties(health, {"Hp", "MaxHp"})
+    AssertEquals(hp, health.Hp)
+    AssertEquals(maxHp, health.MaxHp)
+
+    local keys = Ext.Types.CompilePropertyList(health, {"Hp", "MaxHp"})
+    local hp2, maxHp2 = Ext.Types.GetProperties(health, keys)
+    AssertEquals(hp2, hp)
+    AssertEquals(maxHp2, maxHp)
+
+    Ext.Types.SetProperties(health, {Hp = 1, TemporaryHp = health.TemporaryHp})
+    AssertEquals(health.Hp, 1)
+    Ext.Types.SetProperties(health, keys, {hp, maxHp})
+    AssertEquals(health.Hp, hp)
+    Assert(not pcall(Ext.Types.SetProperties, health, keys))
+end
+
+function TestECSGeneratedSerializers()
+    local stats = Ext.Entity.Get(GUID_LAEZEL).Stats
+
+    local generated = Ext.Types.Serialize(stats)
+    Ext.DevTests.SetGeneratedSerializers(false)
+    local generic = Ext.Types.Serialize(stats)
+    Ext.DevTests.SetGeneratedSerializers(true)
+
+    AssertEqualsProperties(generic, generated)
+    AssertEqualsProperties(generated, generic)
+
+    Ext.Types.Unserialize(stats, generated)
+    AssertEqualsProperties(generated, Ext.Types.Serialize(stats))
+end
+
 RegisterTests("ECS", {
     "TestECSFetch",
     "TestECSComponents",
     "TestECSFunctions",
-    "TestECSReplication"
+    "TestECSReplication",
+    "TestECSBulkProperties",
+    "TestECSGeneratedSerializers"
 })
@@ -0,0 +1,85 @@
+local _Events = Ext._Events
+
+local function SubscribeTest(name, calls, tag, priority, once)
+    return _Events.Subscribe(name, function (e)
+        table.insert(calls, tag)
+    end, priority or 100, once or false)
+end
+
+function TestEventPriority()
+    local calls = {}
+    SubscribeTest("Tests.Priority", calls, "A")
+    SubscribeTest("Tests.Priority", calls, "B", 200)
+    SubscribeTest("Tests.Priority", calls, "C")
+    SubscribeTest("Tests.Priority", calls, "D", 50)
+
+    _Events.Throw("Tests.Priority", {})
+    AssertEquals(calls, {"B", "A", "C", "D"})
+end
+
+function TestEventOnce()
+    local calls = {}
+    SubscribeTest("Tests.Once", calls, "A")
+    SubscribeTest("Tests.Once", calls, "B", 100, true)
+
+    _Events.Throw("Tests.Once", {})
+    _Events.Throw("Tests.Once", {})
+    AssertEquals(calls, {"A", "B", "A"})
+end
+
+function TestEventUnsubscribe()
+    local calls = {}
+    local idA = SubscribeTest("Tests.Unsubscribe", calls, "A")
+    local idB
+    _Events.Subscribe("Tests.Unsubscribe", function (e)
+        table.insert(calls, "X")
+        -- Handlers removed during dispatch are skipped by the running dispatch,
+        -- handlers added during dispatch are only called by the next one
+        AssertEquals(_Events.Unsubscribe("Tests.Unsubscribe", idB), true)
+        SubscribeTest("Tests.Unsubscribe", calls, "C")
+    end, 150, true)
+    idB = SubscribeTest("Tests.Unsubscribe", calls, "B")
+
+    _Events.Throw("Tests.Unsubscribe", {})
+    AssertEquals(calls, {"X", "A"})
+    AssertEquals(_Events.Unsubscribe("Tests.Unsubscribe", idA), true)
+    AssertEquals(_Events.Unsubscribe("Tests.Unsubscribe", idA), false)
+
+    _Events.Throw("Tests.Unsubscribe", {})
+    AssertEquals(calls, {"X", "A", "C"})
+end
+
+function TestEventStopPropagation()
+    local calls = {}
+    _Events.Subscribe("Tests.Stop", function (e)
+        table.insert(calls, "A")
+        e.Stopped = true
+    end, 100, false)
+    SubscribeTest("Tests.Stop", calls, "B")
+
+    _Events.Throw("Tests.Stop", {})
+    AssertEquals(calls, {"A"})
+end
+
+function TestEventModAccounting()
+    local calls = {}
+    SubscribeTest("Tests.Accounting", calls, "A")
+
+    local before = Ext.Debug.GetModStats(true)["builtin"]
+    local beforeCalls = before and before.Calls or 0
+    _Events.Throw("Tests.Accounting", {})
+    _Events.Throw("Tests.Accounting", {})
+    local ok = _Events.CallHandler(function () end)
+    AssertEquals(ok, true)
+
+    local after = Ext.Debug.GetModStats(true)["builtin"]
+    AssertEquals(after.Calls - beforeCalls, 3)
+end
+
+RegisterTests("Events", {
+    "TestEventPriority",
+    "TestEventOnce",
+    "TestEventUnsubscribe",
+    "TestEventStopPropagation",
+    "TestEventModAccounting"
+})
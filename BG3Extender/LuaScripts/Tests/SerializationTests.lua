@@ -0,0 +1,507 @@
+-- Deep comparison that distinguishes integers from floats and treats NaN as equal to itself
+local function DeepEquals(a, b)
+    if type(a) ~= type(b) then
+        return false
+    end
+
+    if type(a) == "number" then
+        if math.type(a) ~= math.type(b) then
+            return false
+        end
+        return a == b or (a ~= a and b ~= b)
+    end
+
+    if type(a) ~= "table" then
+        return a == b
+    end
+
+    for k,v in pairs(a) do
+        if not DeepEquals(v, b[k]) then
+            return false
+        end
+    end
+
+    for k,v in pairs(b) do
+        if a[k] == nil then
+            return false
+        end
+    end
+
+    return true
+end
+
+local INTEGER_EDGES = {
+    0, 1, -1, 127, 128, -32, -33, 255, 256, -128, -129, 65535, 65536, -32768, -32769,
+    4294967295, 4294967296, -2147483648, -2147483649, math.maxinteger, math.mininteger
+}
+
+local FLOAT_EDGES = { 0.5, -2.5, 0.1, 1.0, 1e300, -1e-300, 3.0e38, 1e39, math.huge, -math.huge, 0/0 }
+
+local function RandomString(maxLength)
+    local chars = {}
+    for i = 1, math.random(0, maxLength) do
+        chars[i] = string.char(math.random(0, 255))
+    end
+    return table.concat(chars)
+end
+
+local function RandomValue(depth)
+    local kind = math.random(1, depth > 4 and 5 or 7)
+    if kind == 1 then
+        return math.random(0, 1) == 1
+    elseif kind == 2 then
+        return INTEGER_EDGES[math.random(#INTEGER_EDGES)]
+    elseif kind == 3 then
+        return FLOAT_EDGES[math.random(#FLOAT_EDGES)]
+    elseif kind == 4 then
+        return math.random(math.mininteger, math.maxinteger)
+    elseif kind == 5 then
+        return RandomString(math.random(0, 3) == 0 and 300 or 20)
+    elseif kind == 6 then
+        local arr = {}
+        for i = 1, math.random(0, 20) do
+            arr[i] = RandomValue(depth + 1)
+        end
+        return arr
+    else
+        local map = {}
+        for i = 1, math.random(0, 20) do
+            local keyKind = math.random(1, 3)
+            local key
+            if keyKind == 1 then
+                key = RandomString(8)
+            elseif keyKind == 2 then
+                key = INTEGER_EDGES[math.random(#INTEGER_EDGES)]
+            else
+                key = math.random() * 100
+            end
+            map[key] = RandomValue(depth + 1)
+        end
+        return map
+    end
+end
+
+function TestMsgPackRoundTrip()
+    math.randomseed(1234)
+    for i = 1, 2000 do
+        local value = RandomValue(0)
+        local packed = Ext.MsgPack.Pack(value)
+        local unpacked = Ext.MsgPack.Unpack(packed)
+        if not DeepEquals(value, unpacked) then
+            error("MessagePack round trip failed for value: " .. Ext.Json.Stringify(value, false, true))
+        end
+    end
+end
+
+function TestMsgPackMalformedInput()
+    math.randomseed(5678)
+    for i = 1, 500 do
+        local packed = Ext.MsgPack.Pack(RandomValue(0))
+        if #packed > 1 then
+            local ok = pcall(Ext.MsgPack.Unpack, packed:sub(1, math.random(1, #packed - 1)))
+            AssertEquals(ok, false)
+        end
+
+        -- Random data must either decode or fail with an error
+        pcall(Ext.MsgPack.Unpack, RandomString(64))
+    end
+
+    -- Nested array32/map32 headers that each claim the rest of the input
+    local headers = {}
+    for i = 1, 900 do
+        headers[i] = (i % 2 == 0) and "\xdd\x00\x01\x00\x00" or "\xdf\x00\x00\x80\x00"
+    end
+    local nested = table.concat(headers) .. string.rep("\xc0", 0x10000)
+    AssertEquals(pcall(Ext.MsgPack.Unpack, nested), false)
+end
+
+function TestMsgPackUserdata()
+    AssertEquals(Ext.MsgPack.Unpack(Ext.MsgPack.Pack(Ext.Enums.SurfaceType.Web)), "Web")
+    AssertEquals(Ext.MsgPack.Unpack(Ext.MsgPack.Pack(Ext.Enums.SurfaceType.Web)), Ext.Json.Parse(Ext.Json.Stringify(Ext.Enums.SurfaceType.Web)))
+end
+
+-- Checks that parsing fails and that the error message contains the expected text
+local function AssertJsonParseError(json, message)
+    local ok, err = pcall(Ext.Json.Parse, json)
+    AssertEquals(ok, false)
+    if not string.find(err, message, 1, true) then
+        error("Expected error containing '" .. message .. "', got: " .. err)
+    end
+end
+
+function TestJsonParseStrings()
+    AssertEquals(Ext.Json.Parse([["plain"]]), "plain")
+    AssertEquals(Ext.Json.Parse([["a\"b\\c\/d\b\f\n\r\t"]]), "a\"b\\c/d\b\f\n\r\t")
+    AssertEquals(Ext.Json.Parse([["A\u00e9\u20AC"]]), "A\u{e9}\u{20ac}")
+    AssertEquals(Ext.Json.Parse([["x\u0000y"]]), "x\0y")
+    -- Surrogate pairs are combined into a single 4 byte UTF-8 sequence
+    AssertEquals(Ext.Json.Parse([["\ud83d\ude00"]]), "\u{1f600}")
+    AssertEquals(Ext.Json.Parse([["<\uD834\uDD1E>"]]), "<\u{1d11e}>")
+    -- A lone low surrogate is kept as is
+    AssertEquals(Ext.Json.Parse([["\ude00"]]), "\xed\xb8\x80")
+
+    AssertJsonParseError([["\ud83d"]], "second half of a unicode surrogate pair")
+    AssertJsonParseError([["\ud83dx"]], "second half of a unicode surrogate pair")
+    AssertJsonParseError([["\ud83d\u0041"]], "second half of a unicode surrogate pair")
+    AssertJsonParseError([["\ud83d\ud83d"]], "second half of a unicode surrogate pair")
+    AssertJsonParseError([["\u12G4"]], "Bad unicode escape sequence in string")
+    AssertJsonParseError([["\u12"]], "Bad unicode escape sequence in string")
+    AssertJsonParseError([["\x41"]], "Bad escape sequence in string")
+    AssertJsonParseError([["abc]], "Missing '\"' at end of string")
+    AssertJsonParseError([["abc\n\"]], "Missing '\"' at end of string")
+end
+
+function TestJsonParseNumbers()
+    local function AssertNumber(json, value, numberType)
+        local parsed = Ext.Json.Parse(json)
+        AssertEquals(math.type(parsed), numberType)
+        AssertEquals(parsed, value)
+    end
+
+    AssertNumber("0", 0, "integer")
+    AssertNumber("-17", -17, "integer")
+    AssertNumber("1.0", 1.0, "float")
+    AssertNumber("2.5e-3", 0.0025, "float")
+    AssertNumber("1e3", 1000.0, "float")
+    AssertNumber("1E+3", 1000.0, "float")
+    AssertNumber("9223372036854775807", math.maxinteger, "integer")
+    AssertNumber("-9223372036854775808", math.mininteger, "integer")
+    -- Values between INT64_MAX and UINT64_MAX wrap around, larger integers become floats
+    AssertNumber("18446744073709551615", -1, "integer")
+    AssertNumber("18446744073709551616", 18446744073709551616.0, "float")
+
+    -- -0 is an integer zero, -0.0 keeps its sign
+    AssertNumber("-0", 0, "integer")
+    local negativeZero = Ext.Json.Parse("-0.0")
+    AssertEquals(math.type(negativeZero), "float")
+    AssertEquals(1 / negativeZero, -math.huge)
+
+    -- Values outside the range of doubles are rounded to infinity or zero
+    AssertNumber("1e400", math.huge, "float")
+    AssertNumber("-1e400", -math.huge, "float")
+    AssertNumber("1e+9999", math.huge, "float")
+    AssertNumber("1e-400", 0.0, "float")
+    AssertNumber("0.0000000000000000000001e-400", 0.0, "float")
+    AssertNumber("123456789e305", math.huge, "float")
+
+    AssertEqualsArray({1, 2.5, -3}, Ext.Json.Parse("[1,2.5,-3]"))
+
+    AssertJsonParseError("1.2.3", "Invalid number")
+    AssertJsonParseError("+1", "Invalid number")
+    AssertJsonParseError("-", "Invalid number")
+    AssertJsonParseError("1e", "Invalid number")
+    AssertJsonParseError("[1, 2-3]", "Invalid number")
+end
+
+function TestJsonParseCommentsAndTrailingData()
+    local parsed = Ext.Json.Parse("// Leading comment\n{\n\t\"a\" /* before colon */ : 1, // Trailing comment\n\t\"b\" : [/**/2/* x */]\n}\n// End")
+    AssertEquals(parsed.a, 1)
+    AssertEqualsArray({2}, parsed.b)
+    AssertEquals(Ext.Json.Parse("/* only */ 5 /* comments */"), 5)
+
+    -- Anything after the root value is ignored
+    AssertEquals(Ext.Json.Parse("1 x"), 1)
+    AssertEqualsArray({1}, Ext.Json.Parse("[1] [2]"))
+    AssertEquals(Ext.Json.Parse("{\"a\":1}}").a, 1)
+
+    AssertJsonParseError("/* unterminated", "Unterminated comment")
+    AssertJsonParseError("[1 /* unterminated ]", "Unterminated comment")
+    AssertJsonParseError("// only a comment", "Unexpected end of document, value expected")
+end
+
+function TestJsonParseErrors()
+    AssertJsonParseError("", "Unable to parse JSON: Line 1, column 1: Unexpected end of document, value expected")
+    AssertJsonParseError("tru", "Syntax error: value, object or array expected")
+    AssertJsonParseError("nul", "Syntax error: value, object or array expected")
+    AssertJsonParseError("[1,]", "Line 1, column 4: Syntax error: value, object or array expected")
+    AssertJsonParseError("[1, 2", "Missing ',' or ']' in array declaration")
+    AssertJsonParseError("[1 2]", "Line 1, column 4: Missing ',' or ']' in array declaration")
+    AssertJsonParseError("{", "Missing '}' or object member name")
+    AssertJsonParseError("{\"a\":1,}", "Missing '}' or object member name")
+    AssertJsonParseError("{a:1}", "Missing '}' or object member name")
+    AssertJsonParseError("{\"a\" 1}", "Missing ':' after object member name")
+    AssertJsonParseError("{\"a\":1 \"b\":2}", "Missing ',' or '}' in object declaration")
+    AssertJsonParseError("{\n  \"a\": x\n}", "Line 2, column 8: Syntax error: value, object or array expected")
+    AssertJsonParseError(string.rep("[", 1001) .. string.rep("]", 1001), "Exceeded stack limit while parsing JSON")
+    AssertEquals(#Ext.Json.Parse(string.rep("[", 1000) .. string.rep("]", 1000)), 1)
+
+    -- Every truncated prefix of an object is malformed
+    local json = Ext.Json.Stringify({ a = { 1, 2.5, "x\u{1f600}" }, b = { c = true } }, false)
+    for i = 0, #json - 1 do
+        AssertEquals(pcall(Ext.Json.Parse, json:sub(1, i)), false)
+    end
+end
+
+local COMPACT = { Beautify = false }
+
+function TestJsonStringifyScalars()
+    AssertEquals(Ext.Json.Stringify("a\"b\\c/d\b\f\n\r\t\1"), [["a\"b\\c/d\b\f\n\r\t\u0001"]])
+    AssertEquals(Ext.Json.Stringify("A\u{e9}\u{20ac}\u{1f600}"), [["A\u00e9\u20ac\ud83d\ude00"]])
+    -- Invalid UTF-8 sequences and encoded surrogates are replaced with U+FFFD
+    AssertEquals(Ext.Json.Stringify("\xff"), [["\ufffd"]])
+    AssertEquals(Ext.Json.Stringify("\xc0\x80"), [["\ufffd"]])
+    AssertEquals(Ext.Json.Stringify("\xed\xa0\x80"), [["\ufffd"]])
+
+    for _, str in ipairs({ "", "x\0y", "\u{7f}\u{80}\u{7ff}\u{800}\u{ffff}\u{10000}\u{10ffff}", "\u{fffd}\u{1f600}" }) do
+        AssertEquals(Ext.Json.Parse(Ext.Json.Stringify(str)), str)
+    end
+
+    AssertEquals(Ext.Json.Stringify(1), "1")
+    AssertEquals(Ext.Json.Stringify(-0), "0")
+    AssertEquals(Ext.Json.Stringify(math.mininteger), "-9223372036854775808")
+    -- Floats are written with 17 significant digits and always read back as floats
+    AssertEquals(Ext.Json.Stringify(1.0), "1.0")
+    AssertEquals(Ext.Json.Stringify(-0.0), "-0.0")
+    AssertEquals(Ext.Json.Stringify(0.5), "0.5")
+    AssertEquals(Ext.Json.Stringify(0.1), "0.10000000000000001")
+    AssertEquals(Ext.Json.Stringify(1e20), "1e+20")
+    AssertEquals(Ext.Json.Stringify(2.0^53), "9007199254740992.0")
+    AssertEquals(Ext.Json.Stringify(math.huge), "1e+9999")
+    AssertEquals(Ext.Json.Stringify(-math.huge), "-1e+9999")
+    AssertEquals(Ext.Json.Stringify(0/0), "null")
+    for _, num in ipairs({ 1.0, -0.0, 0.1, 1e20, 1e300, -1e-300, 2.0^53, math.huge, -math.huge }) do
+        local parsed = Ext.Json.Parse(Ext.Json.Stringify(num))
+        AssertEquals(math.type(parsed), "float")
+        AssertEquals(parsed, num)
+    end
+
+    AssertEquals(Ext.Json.Stringify(true), "true")
+    AssertEquals(Ext.Json.Stringify(nil), "null")
+    AssertEquals(Ext.Json.Stringify(Ext.Enums.SurfaceType.Web), [["Web"]])
+end
+
+function TestJsonStringifyContainers()
+    AssertEquals(Ext.Json.Stringify({}, COMPACT), "[]")
+    AssertEquals(Ext.Json.Stringify({1, "a", {}}, COMPACT), [=[[1,"a",[]]]=])
+    -- Object members are sorted by name; tables with holes or non-integer keys are written as objects
+    AssertEquals(Ext.Json.Stringify({z = 1, a = 2, m = {x = 3}}, COMPACT), [[{"a":2,"m":{"x":3},"z":1}]])
+    AssertEquals(Ext.Json.Stringify({[1] = 1, [3] = 3}, COMPACT), [[{"1":1,"3":3}]])
+    AssertEquals(Ext.Json.Stringify({[1.5] = true}, COMPACT), [[{"1.5":true}]])
+    local ok, err = pcall(Ext.Json.Stringify, {[true] = 1})
+    AssertEquals(ok, false)
+    Assert(err:find("Can only stringify string or number table keys", 1, true))
+
+    local value = {a = 1, b = {1, 2}, c = {}, d = {e = true}, f = {{g = "h"}}}
+    AssertEquals(Ext.Json.Stringify(value, COMPACT), [[{"a":1,"b":[1,2],"c":[],"d":{"e":true},"f":[{"g":"h"}]}]])
+    local beautified = "{\n\t\"a\" : 1,\n\t\"b\" : \n\t[\n\t\t1,\n\t\t2\n\t],\n\t\"c\" : [],\n\t\"d\" : \n\t{\n\t\t\"e\" : true\n\t},"
+        .. "\n\t\"f\" : \n\t[\n\t\t{\n\t\t\t\"g\" : \"h\"\n\t\t}\n\t]\n}"
+    AssertEquals(Ext.Json.Stringify(value), beautified)
+    AssertEquals(Ext.Json.Stringify(value, { Beautify = true }), beautified)
+    -- Old API: Stringify(value, beautify, stringifyInternalTypes, iterateUserdata)
+    AssertEquals(Ext.Json.Stringify(value, true), beautified)
+    AssertEquals(Ext.Json.Stringify(value, false), Ext.Json.Stringify(value, COMPACT))
+
+    -- The streaming writer must produce the same output as the jsoncpp DOM writer
+    for i = 1, 20 do
+        local tab = { Value = RandomValue(0), Beautified = value, Numbers = FLOAT_EDGES, Integers = INTEGER_EDGES }
+        AssertEquals(select(4, Ext.DevTests.BenchmarkJsonStringify(tab, 1)), true)
+    end
+end
+
+function TestJsonStringifyOptions()
+    local fn = function () end
+    local ok, err = pcall(Ext.Json.Stringify, {f = fn})
+    AssertEquals(ok, false)
+    Assert(err:find("Attempted to stringify a lightuserdata, userdata, function or thread value", 1, true))
+    AssertEquals(Ext.Json.Parse(Ext.Json.Stringify({f = fn}, { StringifyInternalTypes = true })).f, tostring(fn))
+    AssertEquals(Ext.Json.Parse(Ext.Json.Stringify(fn, false, true)), tostring(fn))
+
+    -- Userdata is only iterated with IterateUserdata, otherwise it is written as an internal type
+    local stat = Ext.Stats.Get("WPN_Sling")
+    AssertEquals(pcall(Ext.Json.Stringify, stat), false)
+    AssertEquals(Ext.Json.Parse(Ext.Json.Stringify(stat, { StringifyInternalTypes = true })), tostring(stat))
+    local iterated = Ext.Json.Parse(Ext.Json.Stringify(stat, { StringifyInternalTypes = true, IterateUserdata = true }))
+    AssertType(iterated, "table")
+    AssertEquals(iterated.Name, "WPN_Sling")
+    AssertEquals(Ext.Json.Parse(Ext.Json.Stringify(stat, false, true, true)).Name, "WPN_Sling")
+
+    -- The root value is at depth 0; MaxDepth is capped at 64
+    local nested = {a = {b = {c = {}}}}
+    AssertEquals(Ext.Json.Stringify(nested, { Beautify = false, MaxDepth = 3 }), [[{"a":{"b":{"c":[]}}}]])
+    ok, err = pcall(Ext.Json.Stringify, nested, { MaxDepth = 2 })
+    AssertEquals(ok, false)
+    Assert(err:find("Recursion depth exceeded while stringifying JSON", 1, true))
+    AssertEquals(Ext.Json.Stringify(nested, { Beautify = false, LimitDepth = 1 }), [[{"a":{"b":"*DEPTH LIMIT EXCEEDED*"}}]])
+
+    local deep = {}
+    for i = 1, 64 do
+        deep = {deep}
+    end
+    Ext.Json.Stringify(deep, { MaxDepth = 1000 })
+    AssertEquals(pcall(Ext.Json.Stringify, {deep}, { MaxDepth = 1000 }), false)
+
+    -- Recursive tables exceed MaxDepth unless AvoidRecursion is set
+    local recursive = {name = "t"}
+    recursive.self = recursive
+    ok, err = pcall(Ext.Json.Stringify, recursive)
+    AssertEquals(ok, false)
+    Assert(err:find("Recursion depth exceeded while stringifying JSON", 1, true))
+    AssertEquals(Ext.Json.Stringify(recursive, { Beautify = false, AvoidRecursion = true }), [[{"name":"t","self":"*RECURSION*"}]])
+    AssertEquals(Ext.Json.Stringify({recursive}, { Beautify = false, AvoidRecursion = true }), [=[[{"name":"t","self":"*RECURSION*"}]]=])
+end
+
+-- Successive values of a composite user variable with a few fields changed each time
+local function UserVarVersions(count)
+    local versions = {}
+    local value = { Inventory = {}, Stats = { Level = 1, XP = 0 } }
+    for i = 1, 50 do
+        value.Inventory["Item" .. i] = { Count = i, Name = RandomString(16) }
+    end
+
+    for v = 1, count do
+        versions[v] = value
+        value = Ext.MsgPack.Unpack(Ext.MsgPack.Pack(value))
+        value.Stats.XP = value.Stats.XP + 100
+        value.Inventory["Item" .. math.random(1, 50)].Count = math.random(1, 1000)
+        if v % 3 == 0 then
+            value.Inventory["Item" .. math.random(1, 50)] = nil
+        end
+        if v % 4 == 0 then
+            value["Flag" .. v] = true
+        end
+    end
+
+    return versions
+end
+
+function TestUserVarDeltaLoopback()
+    math.randomseed(4321)
+    local intact, stats = Ext.DevTests.TestUserVarDeltaLoopback(UserVarVersions(20))
+    AssertEquals(intact, true)
+    AssertEquals(stats.FullValues, 1)
+    AssertEquals(stats.Patches, 19)
+    AssertEquals(stats.Resyncs, 0)
+    AssertEquals(stats.SentBytes < stats.FullBytes / 4, true)
+    -- Only the acknowledged baseline and the latest value are kept
+    AssertEquals(stats.ClientValues <= 2, true)
+end
+
+function TestUserVarDeltaUnpatchable()
+    -- Top-level arrays are always sent in full; the client must still drop values older than the baseline
+    local versions = {}
+    for v = 1, 20 do
+        versions[v] = { v, v * 2, v * 3 }
+    end
+
+    local intact, stats = Ext.DevTests.TestUserVarDeltaLoopback(versions)
+    AssertEquals(intact, true)
+    AssertEquals(stats.FullValues, 20)
+    AssertEquals(stats.Patches, 0)
+    AssertEquals(stats.ClientValues <= 2, true)
+end
+
+function TestUserVarDeltaResync()
+    math.randomseed(8765)
+    -- The client loses its baselines before the 10th value, so the patch must be rejected and resent in full
+    local intact, stats = Ext.DevTests.TestUserVarDeltaLoopback(UserVarVersions(20), 10)
+    AssertEquals(intact, true)
+    AssertEquals(stats.Resyncs, 1)
+    AssertEquals(stats.FullValues, 2)
+    AssertEquals(stats.Patches, 19)
+end
+
+local function SyncRequest(tick, variable, priority, size)
+    return { Tick = tick, Variable = variable, Priority = priority, Size = size or 100 }
+end
+
+function TestUserVarSyncBudget()
+    local requests = {}
+    for i = 1, 10 do
+        table.insert(requests, SyncRequest(0, "Var" .. i, "Normal", 1000))
+    end
+    -- Larger than the budget; must still be sent on its own
+    table.insert(requests, SyncRequest(10, "Large", "Normal", 5000))
+
+    local sent, stats = Ext.DevTests.SimulateUserVarSync(requests, 3000, 12)
+    AssertEquals(#sent, 11)
+    local perTick = {}
+    for i, var in ipairs(sent) do
+        if i <= 10 then
+            AssertEquals(var.Variable, "Var" .. i)
+        end
+        perTick[var.Tick] = (perTick[var.Tick] or 0) + 1
+    end
+    AssertEquals(perTick[0], 3)
+    AssertEquals(perTick[1], 3)
+    AssertEquals(perTick[2], 3)
+    AssertEquals(perTick[3], 1)
+    AssertEquals(sent[11].Variable, "Large")
+    AssertEquals(sent[11].Tick, 10)
+    AssertEquals(stats.BudgetLimitedTicks, 3)
+    AssertEquals(stats.QueueDepth, 0)
+    AssertEquals(stats.PeakQueueDepth, 10)
+end
+
+function TestUserVarSyncPriority()
+    local sent = Ext.DevTests.SimulateUserVarSync({
+        SyncRequest(0, "Low1", "Low"),
+        SyncRequest(0, "Normal1", "Normal"),
+        SyncRequest(0, "High1", "High"),
+        SyncRequest(0, "Low2", "Low"),
+        SyncRequest(0, "High2", "High")
+    }, 100000, 1)
+    local order = {}
+    for i, var in ipairs(sent) do
+        order[i] = var.Variable
+    end
+    AssertEqualsArray({"High1", "High2", "Normal1", "Low1", "Low2"}, order)
+end
+
+function TestUserVarSyncAging()
+    -- A Low variable competes with a steady stream of High variables that use up the whole budget each tick;
+    -- it is promoted by one class every 30 ticks and wins the tie against newer High requests after 60 ticks
+    local requests = { SyncRequest(0, "Starved", "Low") }
+    for tick = 0, 70 do
+        table.insert(requests, SyncRequest(tick, "High" .. tick, "High"))
+    end
+
+    local sent = Ext.DevTests.SimulateUserVarSync(requests, 100, 80)
+    local starvedTick
+    for _, var in ipairs(sent) do
+        if var.Variable == "Starved" then
+            starvedTick = var.Tick
+        end
+    end
+    AssertEquals(starvedTick, 60)
+    AssertEquals(#sent, 72)
+end
+
+function TestUserVarSyncCoalescing()
+    local sent, stats = Ext.DevTests.SimulateUserVarSync({
+        SyncRequest(0, "Repeated", "Normal"),
+        SyncRequest(0, "Repeated", "Normal"),
+        SyncRequest(0, "Repeated", "Normal"),
+        SyncRequest(0, "Other", "Normal"),
+        -- Raises the priority of the queued request; the stale Low entry must not be sent again
+        SyncRequest(0, "Raised", "Low"),
+        SyncRequest(0, "Raised", "High")
+    }, 100000, 2)
+    AssertEquals(#sent, 3)
+    AssertEquals(sent[1].Variable, "Raised")
+    AssertEquals(sent[2].Variable, "Repeated")
+    AssertEquals(sent[3].Variable, "Other")
+    AssertEquals(stats.Requests, 6)
+    AssertEquals(stats.Coalesced, 3)
+    AssertEquals(stats.Sent, 3)
+    AssertEquals(stats.QueueDepth, 0)
+end
+
+RegisterTests("Serialization", {
+    "TestMsgPackRoundTrip",
+    "TestMsgPackMalformedInput",
+    "TestMsgPackUserdata",
+    "TestJsonParseStrings",
+    "TestJsonParseNumbers",
+    "TestJsonParseCommentsAndTrailingData",
+    "TestJsonParseErrors",
+    "TestJsonStringifyScalars",
+    "TestJsonStringifyContainers",
+    "TestJsonStringifyOptions",
+    "TestUserVarDeltaLoopback",
+    "TestUserVarDeltaResync",
+    "TestUserVarDeltaUnpatchable",
+    "TestUserVarSyncBudget",
+    "TestUserVarSyncPriority",
+    "TestUserVarSyncAging",
+    "TestUserVarSyncCoalescing"
+})
@@ -3,6 +3,10 @@ Ext.Utils.Include(nil, "builtin://Tests/ModTests.lua")
 Ext.Utils.Include(nil, "builtin://Tests/StaticDataTests.lua")
 Ext.Utils.Include(nil, "builtin://Tests/StatTests.lua")
 Ext.Utils.Include(nil, "builtin://Tests/ECSTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/EventTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/SerializationTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/TimerTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/Benchmarks.lua")
 --Ext.Utils.Include(nil, "builtin://Tests/ResourceTests.lua")
 --Ext.Utils.Include(nil, "builtin://Tests/CharacterTests.lua")
 --Ext.Utils.Include(nil, "builtin://Tests/CharacterComponentTests.lua")
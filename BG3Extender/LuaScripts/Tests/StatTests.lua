@@ -170,7 +170,30 @@ function TestStatAttributeReassignment()
     end
 end
 
+function TestStatContainerToTable()
+    local lists = Ext.Stats.GetStatsManager().ModifierValueLists
+    local arr = lists.Primitives:ToTable()
+    AssertEquals(#arr, #lists.Primitives)
+    for i,list in ipairs(lists.Primitives) do
+        AssertEquals(arr[i], list)
+    end
+
+    local map = lists.NameHashMap:ToTable()
+    for name,index in pairs(lists.NameHashMap) do
+        AssertEquals(map[name], index)
+    end
+
+    local map2 = Ext.Types.ToTable(lists.NameHashMap)
+    for name,index in pairs(map) do
+        AssertEquals(map2[name], index)
+    end
+
+    local nested = lists.Primitives:ToTable(2)
+    AssertEquals(nested[1], arr[1])
+end
+
 RegisterTests("Stats", {
     "TestStatAttributes",
-    "TestStatAttributeReassignment"
+    "TestStatAttributeReassignment",
+    "TestStatContainerToTable"
 })
@@ -27,6 +27,47 @@ Ext.RegisterConsoleCommand("se_test", function ()
     RunTests()
 end)
 
+RegisteredBenchmarks = {}
+
+function RegisterBenchmarks(category, benchmarks)
+    if RegisteredBenchmarks[category] == nil then
+        RegisteredBenchmarks[category] = {}
+    end
+
+    for i,benchmark in pairs(benchmarks) do
+        table.insert(RegisteredBenchmarks[category], benchmark)
+    end
+end
+
+function RunBenchmarks()
+    Ext.Utils.Print(" --- STARTING BENCHMARKS --- ")
+
+    for category,benchmarks in pairs(RegisteredBenchmarks) do
+        Ext.Utils.Print(" --- Category: " .. category)
+        for i,benchmark in ipairs(benchmarks) do
+            RunTest(benchmark, _G[benchmark])
+        end
+    end
+
+    Ext.Utils.Print(" --- FINISHING BENCHMARKS --- ")
+end
+
+Ext.RegisterConsoleCommand("se_bench", function ()
+    RunBenchmarks()
+end)
+
+-- Runs fun() the specified number of times and prints the average time per iteration
+function Benchmark(name, iterations, fun)
+    fun()
+    local startTime = Ext.Utils.MicrosecTime()
+    for i=1,iterations do
+        fun()
+    end
+    local elapsed = Ext.Utils.MicrosecTime() - startTime
+    Ext.Utils.Print(string.format("Benchmark %s: %d iterations, %.2f us/iteration", name, iterations, elapsed / iterations))
+    return elapsed / iterations
+end
+
 function Assert(expr)
     if not expr then
         error("Assertion failed")
@@ -0,0 +1,200 @@
+function TestTimerPersistenceConversion()
+    local packedArgs = { Target = "S_Player", Count = 3, Nested = { 1, 2, 3 } }
+    local records = Ext.DevTests.TestTimerPersistence('{"Target":"S_Player","Count":3,"Nested":[1,2,3]}', packedArgs)
+    AssertEquals(#records, 2)
+
+    table.sort(records, function (a, b) return a.Time < b.Time end)
+    AssertEquals(records[1].Callback, "JsonTimer")
+    AssertEquals(records[1].Time, 10.0)
+    AssertEquals(records[2].Callback, "PackedTimer")
+    AssertEquals(records[2].Time, 20.0)
+
+    -- JSON arguments from old savegames are saved in MessagePack format
+    for _, record in ipairs(records) do
+        AssertEquals(record.Packed, true)
+        AssertEqualsProperties(packedArgs, record.Args)
+    end
+end
+
+-- Level boundaries of the timer wheel in seconds: level 0 covers 256 ms and each further level covers 64 times
+-- more; timers beyond the last level (2^32 ms, about 49.7 days) wait in its farthest slot and are re-linked
+local TIMER_WHEEL_BOUNDARIES = { 0.256, 16.384, 1048.576, 67108.864, 4294967.296 }
+
+local function TimerWheelDelays()
+    local delays = {}
+    for _, boundary in ipairs(TIMER_WHEEL_BOUNDARIES) do
+        for _, offset in ipairs({ -0.001, 0.0, 0.001 }) do
+            table.insert(delays, boundary + offset)
+        end
+    end
+    -- Re-linked into the overflow slot once and twice
+    table.insert(delays, 5000000.0)
+    table.insert(delays, 9000000.0)
+    return delays
+end
+
+local function TestTimerWheelLevelsFrom(start)
+    local delays = TimerWheelDelays()
+
+    -- Advancing to just before and then exactly to each timer fires it at its scheduled time
+    local ops = { { Op = "Advance", Time = start } }
+    for id, delay in ipairs(delays) do
+        table.insert(ops, { Op = "Add", Id = id, Time = start + delay })
+    end
+    for id, delay in ipairs(delays) do
+        table.insert(ops, { Op = "Advance", Time = start + delay - 0.0005 })
+        table.insert(ops, { Op = "Advance", Time = start + delay })
+    end
+
+    local fired, _, size = Ext.DevTests.SimulateTimerWheel(ops)
+    AssertEquals(#fired, #delays)
+    for id, delay in ipairs(delays) do
+        AssertEquals(fired[id].Id, id)
+        AssertEquals(fired[id].Time, start + delay)
+    end
+    AssertEquals(size, 0)
+
+    -- A single large step fires every timer in order of time; timers with the same time fire in the order they were added
+    ops = { { Op = "Advance", Time = start } }
+    for id = #delays, 1, -1 do
+        table.insert(ops, { Op = "Add", Id = id, Time = start + delays[id] })
+    end
+    table.insert(ops, { Op = "Add", Id = 100, Time = start + 20.0 })
+    table.insert(ops, { Op = "Add", Id = 101, Time = start + 20.0 })
+    table.insert(ops, { Op = "Advance", Time = start + 10000000.0 })
+
+    fired = Ext.DevTests.SimulateTimerWheel(ops)
+    local order = {}
+    for i, timer in ipairs(fired) do
+        order[i] = timer.Id
+    end
+    AssertEqualsArray({1, 2, 3, 4, 5, 6, 100, 101, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17}, order)
+end
+
+function TestTimerWheelLevels()
+    TestTimerWheelLevelsFrom(0.0)
+    -- Start from a time that isn't aligned to the slots of any level
+    TestTimerWheelLevelsFrom(12345.6789)
+end
+
+function TestTimerWheelFrames()
+    local times = {}
+    local ops = {}
+    for id = 1, 500 do
+        times[id] = math.random(0, 20000) / 1000.0 + math.random(0, 999) / 1000000.0
+        table.insert(ops, { Op = "Add", Id = id, Time = times[id] })
+    end
+
+    local frames = {}
+    local now = 0.0
+    for frame = 1, 21 * 60 do
+        now = now + 1.0 / 60.0
+        frames[frame] = now
+        table.insert(ops, { Op = "Advance", Time = now })
+    end
+
+    -- Each timer fires once, in the first frame at or after its scheduled time
+    local fired, _, size = Ext.DevTests.SimulateTimerWheel(ops)
+    AssertEquals(#fired, 500)
+    AssertEquals(size, 0)
+    local seen = {}
+    for _, timer in ipairs(fired) do
+        Assert(not seen[timer.Id])
+        seen[timer.Id] = true
+        local expected
+        for _, frameTime in ipairs(frames) do
+            if frameTime >= times[timer.Id] then
+                expected = frameTime
+                break
+            end
+        end
+        AssertEquals(timer.Time, expected)
+    end
+end
+
+function TestTimerWheelCancel()
+    local fired, cancelled, size = Ext.DevTests.SimulateTimerWheel({
+        { Op = "Add", Id = 1, Time = 1.0 },
+        -- Level 1, cascaded to level 0 at 19.968 s
+        { Op = "Add", Id = 2, Time = 20.0 },
+        -- Overflow slot
+        { Op = "Add", Id = 3, Time = 5000000.0 },
+        { Op = "Advance", Time = 1.0 },
+        -- Already fired
+        { Op = "Cancel", Id = 1 },
+        -- Reuses the wheel entry of timer 1; cancelling timer 1 must not remove it
+        { Op = "Add", Id = 4, Time = 2.0 },
+        { Op = "Cancel", Id = 1 },
+        { Op = "Advance", Time = 17.0 },
+        { Op = "Advance", Time = 19.99 },
+        -- Cancelled after being cascaded
+        { Op = "Cancel", Id = 2 },
+        { Op = "Cancel", Id = 2 },
+        { Op = "Cancel", Id = 3 },
+        { Op = "Add", Id = 5, Time = 30.0 },
+        { Op = "Add", Id = 6, Time = 30.0 },
+        { Op = "Cancel", Id = 5 },
+        { Op = "Advance", Time = 10000000.0 },
+        { Op = "Cancel", Id = 6 }
+    })
+
+    AssertEquals(#fired, 3)
+    AssertEquals(fired[1].Id, 1)
+    AssertEquals(fired[1].Time, 1.0)
+    AssertEquals(fired[2].Id, 4)
+    AssertEquals(fired[2].Time, 17.0)
+    AssertEquals(fired[3].Id, 6)
+    AssertEqualsArray({false, false, true, false, true, true, false}, cancelled)
+    AssertEquals(size, 0)
+end
+
+function TestTimerBatchAlignment()
+    local calls = {}
+    local function HandlerA(handles, args)
+        table.insert(calls, { Handler = "A", Handles = handles, Args = args })
+    end
+    local function HandlerB(handles, args)
+        table.insert(calls, { Handler = "B", Handles = handles, Args = args })
+    end
+
+    local handles, stats = Ext.DevTests.SimulateBatchedTimers({
+        { Time = 1.0, Handler = HandlerA, Arg = "a1" },
+        { Time = 1.0, Handler = HandlerB, Arg = { Value = 1 } },
+        -- No argument; leaves a hole in the argument list
+        { Time = 1.5, Handler = HandlerA },
+        { Time = 1.2, Handler = HandlerA, Arg = "a4" },
+        { Time = 1.1, Handler = HandlerA, Arg = "cancelled" },
+        { Time = 3.0, Handler = HandlerA, Arg = "not due" },
+        { Time = 0.5, Handler = HandlerA, Arg = false },
+        { Time = 1.3, Handler = HandlerA }
+    }, { 5 }, 2.0)
+
+    AssertEquals(#calls, 2)
+    AssertEquals(calls[1].Handler, "A")
+    AssertEqualsArray({handles[7], handles[1], handles[4], handles[8], handles[3]}, calls[1].Handles)
+    -- args[i] belongs to handles[i]
+    local args = calls[1].Args
+    AssertEquals(args[1], false)
+    AssertEquals(args[2], "a1")
+    AssertEquals(args[3], "a4")
+    AssertEquals(args[4], nil)
+    AssertEquals(args[5], nil)
+    for k, _ in pairs(args) do
+        Assert(k == 1 or k == 2 or k == 3)
+    end
+
+    AssertEquals(calls[2].Handler, "B")
+    AssertEqualsArray({handles[2]}, calls[2].Handles)
+    AssertEquals(calls[2].Args[1].Value, 1)
+
+    AssertEquals(stats.TimersFired, 6)
+    AssertEquals(stats.Dispatches, 2)
+end
+
+RegisterTests("Timer", {
+    "TestTimerPersistenceConversion",
+    "TestTimerWheelLevels",
+    "TestTimerWheelFrames",
+    "TestTimerWheelCancel",
+    "TestTimerBatchAlignment"
+})
@@ -74,6 +74,9 @@ namespace bg3se
 	std::wstring FromStdUTF8(std::string_view s);
 	STDString ToUTF8(WStringView s);
 	STDWString FromUTF8(StringView s);
+	STDString EncodeBase64(StringView data);
+	// Returns false if the input is not valid (padded) base64
+	bool DecodeBase64(StringView encoded, STDString& data);
 
 	struct FixedString
 	{
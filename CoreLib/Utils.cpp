@@ -40,7 +40,70 @@ std::wstring FromStdUTF8(std::string_view s)
 	return converted;
 }
 
-std::optional<std::string> GetExeResource(int resourceId)
+static constexpr char Base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+STDString EncodeBase64(StringView data)
+{
+	STDString encoded;
+	encoded.reserve((data.size() + 2) / 3 * 4);
+
+	std::size_t i = 0;
+	for (; i + 3 <= data.size(); i += 3) {
+		uint32_t v = ((uint8_t)data[i] << 16) | ((uint8_t)data[i + 1] << 8) | (uint8_t)data[i + 2];
+		encoded.push_back(Base64Alphabet[(v >> 18) & 0x3f]);
+		encoded.push_back(Base64Alphabet[(v >> 12) & 0x3f]);
+		encoded.push_back(Base64Alphabet[(v >> 6) & 0x3f]);
+		encoded.push_back(Base64Alphabet[v & 0x3f]);
+	}
+
+	if (i < data.size()) {
+		uint32_t v = (uint8_t)data[i] << 16;
+		if (i + 1 < data.size()) v |= (uint8_t)data[i + 1] << 8;
+		encoded.push_back(Base64Alphabet[(v >> 18) & 0x3f]);
+		encoded.push_back(Base64Alphabet[(v >> 12) & 0x3f]);
+		encoded.push_back(i + 1 < data.size() ? Base64Alphabet[(v >> 6) & 0x3f] : '=');
+		encoded.push_back('=');
+	}
+
+	return encoded;
+}
+
+bool DecodeBase64(StringView encoded, STDString& data)
+{
+	if (encoded.size() % 4 != 0) return false;
+
+	auto decodeChar = [](char c) -> int {
+		if (c >= 'A' && c <= 'Z') return c - 'A';
+		if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+		if (c >= '0' && c <= '9') return c - '0' + 52;
+		if (c == '+') return 62;
+		if (c == '/') return 63;
+		return -1;
+	};
+
+	data.clear();
+	data.reserve(encoded.size() / 4 * 3);
+	for (std::size_t i = 0; i < encoded.size(); i += 4) {
+		auto last = (i + 4 == encoded.size());
+		auto padding = last ? (encoded[i + 3] == '=') + (encoded[i + 2] == '=') : 0;
+		if (padding == 1 && encoded[i + 3] != '=') return false;
+
+		uint32_t v = 0;
+		for (unsigned j = 0; j < 4 - padding; j++) {
+			auto bits = decodeChar(encoded[i + j]);
+			if (bits < 0) return false;
+			v |= bits << (18 - j * 6);
+		}
+
+		data.push_back((char)(v >> 16));
+		if (padding < 2) data.push_back((char)((v >> 8) & 0xff));
+		if (padding < 1) data.push_back((char)(v & 0xff));
+	}
+
+	return true;
+}
+
+std::optional<std::string_view> GetExeResourceView(int resourceId)
 {
 	auto hResource = FindResource(gCoreLibPlatformInterface.ThisModule, MAKEINTRESOURCE(resourceId), L"SCRIPT_EXTENDER");
 
@@ -50,10 +113,7 @@ std::optional<std::string> GetExeResource(int resourceId)
 			auto resourceData = LockResource(hGlobal);
 			if (resourceData) {
 				DWORD resourceSize = SizeofResource(gCoreLibPlatformInterface.ThisModule, hResource);
-				std::string contents;
-				contents.resize(resourceSize);
-				memcpy(contents.data(), resourceData, resourceSize);
-				return contents;
+				return std::string_view(reinterpret_cast<char const*>(resourceData), resourceSize);
 			}
 		}
 	}
@@ -62,6 +122,16 @@ std::optional<std::string> GetExeResource(int resourceId)
 	return {};
 }
 
+std::optional<std::string> GetExeResource(int resourceId)
+{
+	auto resource = GetExeResourceView(resourceId);
+	if (resource) {
+		return std::string(*resource);
+	} else {
+		return {};
+	}
+}
+
 void TryDebugBreak()
 {
 #if defined(_DEBUG)
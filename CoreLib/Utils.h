@@ -32,5 +32,7 @@ bool LoadFile(std::wstring const& path, std::vector<uint8_t>& body);
 bool LoadFile(std::wstring const& path, std::string& body);
 
 std::optional<std::string> GetExeResource(int resourceId);
+// Returns a view of the resource data; resources stay mapped while the module is loaded
+std::optional<std::string_view> GetExeResourceView(int resourceId);
 
 END_SE()
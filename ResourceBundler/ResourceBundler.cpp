@@ -1,6 +1,9 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <Lua/Shared/LuaBundleFormat.h>
+
+using namespace bg3se::lua;
 
 class LuaBundler
 {
@@ -20,9 +23,9 @@ public:
 		}
 	}
 
-	std::vector<uint8_t> Pack()
+	std::vector<uint8_t> Pack(uint32_t version, bool compress)
 	{
-		std::vector<uint8_t> bundle;
+		bundle::Writer writer;
 
 		for (auto const& res : paths_) {
 			std::ifstream f(res.FilesystemPath.c_str(), std::ios::in | std::ios::binary);
@@ -35,23 +38,18 @@ public:
 			f.seekg(0, std::ifstream::end);
 			len = f.tellg();
 			f.seekg(0, std::ifstream::beg);
-			std::vector<uint8_t> fbuf;
+			std::string fbuf;
 			fbuf.resize(len);
-			f.read((char*)fbuf.data(), len);
-
-			auto offset = bundle.size();
-			bundle.resize(offset + sizeof(HeaderInfo) + fbuf.size() + res.BundlePath.size());
-			auto phdr = bundle.data() + offset;
+			f.read(fbuf.data(), len);
 
-			HeaderInfo hdr;
-			hdr.FileNameSize = (uint32_t)res.BundlePath.size();
-			hdr.FileSize = (uint32_t)fbuf.size();
-			memcpy(phdr, &hdr, sizeof(hdr));
-			memcpy(phdr + sizeof(hdr), res.BundlePath.c_str(), res.BundlePath.size());
-			memcpy(phdr + sizeof(hdr) + res.BundlePath.size(), fbuf.data(), fbuf.size());
+			writer.Add(res.BundlePath, std::move(fbuf));
 		}
 
-		return bundle;
+		if (version == 1) {
+			return writer.WriteV1();
+		} else {
+			return writer.WriteV2(compress);
+		}
 	}
 
 private:
@@ -61,20 +59,33 @@ private:
 		std::string BundlePath;
 	};
 
-	struct HeaderInfo
-	{
-		uint32_t FileNameSize;
-		uint32_t FileSize;
-	};
-
 	std::vector<ResourceInfo> paths_;
 };
 
 int main(int argc, char const ** argv)
 {
+	if (argc < 3) {
+		std::cout << "Usage: ResourceBundler <resource directory> <bundle file> [--v1] [--compress]" << std::endl;
+		return 1;
+	}
+
+	uint32_t version = bundle::Version;
+	bool compress = false;
+	for (int i = 3; i < argc; i++) {
+		std::string_view arg(argv[i]);
+		if (arg == "--v1") {
+			version = 1;
+		} else if (arg == "--compress") {
+			compress = true;
+		} else {
+			std::cout << "Unknown option: " << arg << std::endl;
+			return 1;
+		}
+	}
+
 	LuaBundler bundler;
 	bundler.AddResources(argv[1]);
-	auto pack = bundler.Pack();
+	auto pack = bundler.Pack(version, compress);
 
 	std::ofstream f(argv[2], std::ios::out | std::ios::binary);
 	if (!f.good()) {